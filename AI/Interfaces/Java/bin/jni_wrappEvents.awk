@@ -254,6 +254,19 @@ function printNativeHandleFuncHead() {
 }
 
 
+# Returns the C expression for the number of elements of an array member
+# of an event struct, which is the value of its <name>_size member.
+function getEventArraySize(evtIndex_as, name_as, value_as) {
+
+	for (_m=0; _m < evtsNumMembers[evtIndex_as]; _m++) {
+		if (evtsMembers_name[evtIndex_as, _m] == (name_as "_size")) {
+			return value_as "_size";
+		}
+	}
+
+	return "sizeof(" value_as ")";
+}
+
 function printNativeEventCases() {
 
 	for (e=0; e < ind_evtStructs; e++) {
@@ -288,7 +301,7 @@ function printNativeEventCase(evtIndex) {
 		} else if (type_jni == "jfloatArray") {
 			name_jni = name_c "_jni";
 
-			array_size = "sizeof(" value_c ")";
+			array_size = getEventArraySize(evtIndex, name_c, value_c);
 			if (match(name_c, /_posF3$/)) {
 				array_size = "3";
 			}
@@ -298,7 +311,7 @@ function printNativeEventCase(evtIndex) {
 		} else if (type_jni == "jintArray") {
 			name_jni = name_c "_jni";
 
-			array_size = "sizeof(" value_c ")";
+			array_size = getEventArraySize(evtIndex, name_c, value_c);
 
 			conversion_pre  = conversion_pre  "\n\t\t\t" type_jni " " name_jni " = (*env)->NewIntArray(env, " array_size ");";
 			conversion_pre  = conversion_pre  "\n\t\t\t" "(*env)->SetIntArrayRegion(env, " name_jni ", 0, " array_size ", " value_c ");";
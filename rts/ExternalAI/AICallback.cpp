@@ -49,6 +49,7 @@
 #include "Sim/Weapons/WeaponDefHandler.h"
 #include "Sim/Weapons/Weapon.h"
 #include "ExternalAI/SkirmishAIHandler.h"
+#include "ExternalAI/SkirmishAIWorker.h"
 #include "ExternalAI/EngineOutHandler.h"
 #include "System/EventHandler.h"
 #include "System/Log/ILog.h"
@@ -138,11 +139,13 @@ CAICallback::~CAICallback()
 void CAICallback::SendStartPos(bool ready, float3 startPos)
 {
 	unsigned char readyness = ready? 1: 0;
-	net->Send(CBaseNetProtocol::Get().SendStartPos(gu->myPlayerNum, team, readyness, startPos.x, startPos.y, startPos.z));
+	CSkirmishAIWorker::SendToServer(CBaseNetProtocol::Get().SendStartPos(gu->myPlayerNum, team, readyness, startPos.x, startPos.y, startPos.z));
 }
 
 void CAICallback::SendTextMsg(const char* text, int zone)
 {
+	SKIRMISH_AI_ENGINE_LOCK();
+
 	const CSkirmishAIHandler::ids_t& teamAIs = skirmishAIHandler.GetSkirmishAIsInTeam(this->team);
 	const SkirmishAIData* aiData = skirmishAIHandler.GetSkirmishAI(*(teamAIs.begin())); // FIXME is there a better way?
 
@@ -154,11 +157,15 @@ void CAICallback::SendTextMsg(const char* text, int zone)
 
 void CAICallback::SetLastMsgPos(const float3& pos)
 {
+	SKIRMISH_AI_ENGINE_LOCK();
+
 	eventHandler.LastMessagePosition(pos);
 }
 
 void CAICallback::AddNotification(const float3& pos, const float3& color, float alpha)
 {
+	SKIRMISH_AI_ENGINE_LOCK();
+
 	minimap->AddNotification(pos, color, alpha);
 }
 
@@ -188,7 +195,7 @@ bool CAICallback::SendResources(float mAmount, float eAmount, int receivingTeamI
 		eAmount = std::max(0.0f, std::min(eAmount, GetEnergy()));
 		std::vector<short> empty;
 
-		net->Send(CBaseNetProtocol::Get().SendAIShare(ubyte(gu->myPlayerNum), skirmishAIHandler.GetCurrentAIID(), ubyte(team), ubyte(receivingTeamId), mAmount, eAmount, empty));
+		CSkirmishAIWorker::SendToServer(CBaseNetProtocol::Get().SendAIShare(ubyte(gu->myPlayerNum), skirmishAIHandler.GetCurrentAIID(), ubyte(team), ubyte(receivingTeamId), mAmount, eAmount, empty));
 	}
 
 	return ret;
@@ -227,7 +234,7 @@ int CAICallback::SendUnits(const std::vector<int>& unitIds, int receivingTeamId)
 		if (!sentUnitIDs.empty()) {
 			// we ca not use SendShare() here either, since
 			// AIs do not have a notion of "selected units"
-			net->Send(CBaseNetProtocol::Get().SendAIShare(ubyte(gu->myPlayerNum), skirmishAIHandler.GetCurrentAIID(), ubyte(team), ubyte(receivingTeamId), 0.0f, 0.0f, sentUnitIDs));
+			CSkirmishAIWorker::SendToServer(CBaseNetProtocol::Get().SendAIShare(ubyte(gu->myPlayerNum), skirmishAIHandler.GetCurrentAIID(), ubyte(team), ubyte(receivingTeamId), 0.0f, 0.0f, sentUnitIDs));
 		}
 	}
 
@@ -302,6 +309,8 @@ void CAICallback::ReleasedSharedMemArea(char* name)
 
 int CAICallback::CreateGroup()
 {
+	SKIRMISH_AI_ENGINE_LOCK();
+
 	GML_RECMUTEX_LOCK(group); // CreateGroup
 
 	const CGroup* g = gh->CreateNewGroup();
@@ -310,6 +319,8 @@ int CAICallback::CreateGroup()
 
 void CAICallback::EraseGroup(int groupId)
 {
+	SKIRMISH_AI_ENGINE_LOCK();
+
 	GML_RECMUTEX_LOCK(group); // EraseGroup
 
 	if (CHECK_GROUPID(groupId)) {
@@ -321,6 +332,8 @@ void CAICallback::EraseGroup(int groupId)
 
 bool CAICallback::AddUnitToGroup(int unitId, int groupId)
 {
+	SKIRMISH_AI_ENGINE_LOCK();
+
 	bool added = false;
 
 	CUnit* unit = GetMyTeamUnit(unitId);
@@ -337,6 +350,8 @@ bool CAICallback::AddUnitToGroup(int unitId, int groupId)
 
 bool CAICallback::RemoveUnitFromGroup(int unitId)
 {
+	SKIRMISH_AI_ENGINE_LOCK();
+
 	bool removed = false;
 
 	CUnit* unit = GetMyTeamUnit(unitId);
@@ -396,7 +411,7 @@ int CAICallback::GiveOrder(int unitId, Command* c)
 		return -5;
 	}
 
-	net->Send(CBaseNetProtocol::Get().SendAICommand(gu->myPlayerNum, skirmishAIHandler.GetCurrentAIID(), unitId, c->GetID(), c->aiCommandId, c->options, c->params));
+	CSkirmishAIWorker::SendToServer(CBaseNetProtocol::Get().SendAICommand(gu->myPlayerNum, skirmishAIHandler.GetCurrentAIID(), unitId, c->GetID(), c->aiCommandId, c->options, c->params.begin(), c->params.size()));
 
 	return 0;
 }
@@ -725,22 +740,30 @@ bool CAICallback::IsUnitNeutral(int unitId) {
 
 int CAICallback::InitPath(const float3& start, const float3& end, int pathType, float goalRadius)
 {
+	SKIRMISH_AI_ENGINE_LOCK();
+
 	assert(((size_t)pathType) < moveDefHandler->moveDefs.size());
 	return pathManager->RequestPath(moveDefHandler->moveDefs.at(pathType), start, end, goalRadius, NULL, false);
 }
 
 float3 CAICallback::GetNextWaypoint(int pathId)
 {
+	SKIRMISH_AI_ENGINE_LOCK();
+
 	return pathManager->NextWayPoint(pathId, ZeroVector, 0.0f, 0, 0, false);
 }
 
 void CAICallback::FreePath(int pathId)
 {
+	SKIRMISH_AI_ENGINE_LOCK();
+
 	pathManager->DeletePath(pathId);
 }
 
 float CAICallback::GetPathLength(float3 start, float3 end, int pathType, float goalRadius)
 {
+	SKIRMISH_AI_ENGINE_LOCK();
+
 	const int pathID  = InitPath(start, end, pathType, goalRadius);
 	float     pathLen = -1.0f;
 
@@ -804,6 +827,8 @@ float CAICallback::GetPathLength(float3 start, float3 end, int pathType, float g
 }
 
 bool CAICallback::SetPathNodeCost(unsigned int x, unsigned int z, float cost) {
+	SKIRMISH_AI_ENGINE_LOCK();
+
 	return pathManager->SetNodeExtraCost(x, z, cost, false);
 }
 
@@ -918,6 +943,8 @@ static inline bool unit_IsNeutralAndInLos(const CUnit* unit) {
 
 int CAICallback::GetEnemyUnits(int* unitIds, int unitIds_max)
 {
+	SKIRMISH_AI_ENGINE_LOCK();
+
 	verify();
 	myAllyTeamId = teamHandler->AllyTeam(team);
 	return FilterUnitsList(uh->activeUnits, unitIds, unitIds_max, &unit_IsEnemyAndInLos);
@@ -925,6 +952,8 @@ int CAICallback::GetEnemyUnits(int* unitIds, int unitIds_max)
 
 int CAICallback::GetEnemyUnitsInRadarAndLos(int* unitIds, int unitIds_max)
 {
+	SKIRMISH_AI_ENGINE_LOCK();
+
 	verify();
 	myAllyTeamId = teamHandler->AllyTeam(team);
 	return FilterUnitsList(uh->activeUnits, unitIds, unitIds_max, &unit_IsEnemyAndInLosOrRadar);
@@ -933,6 +962,8 @@ int CAICallback::GetEnemyUnitsInRadarAndLos(int* unitIds, int unitIds_max)
 int CAICallback::GetEnemyUnits(int* unitIds, const float3& pos, float radius,
 		int unitIds_max)
 {
+	SKIRMISH_AI_ENGINE_LOCK();
+
 	verify();
 	const std::vector<CUnit*>& units = qf->GetUnitsExact(pos, radius);
 	myAllyTeamId = teamHandler->AllyTeam(team);
@@ -942,6 +973,8 @@ int CAICallback::GetEnemyUnits(int* unitIds, const float3& pos, float radius,
 
 int CAICallback::GetFriendlyUnits(int* unitIds, int unitIds_max)
 {
+	SKIRMISH_AI_ENGINE_LOCK();
+
 	verify();
 	myAllyTeamId = teamHandler->AllyTeam(team);
 	return FilterUnitsList(uh->activeUnits, unitIds, unitIds_max, &unit_IsFriendly);
@@ -950,6 +983,8 @@ int CAICallback::GetFriendlyUnits(int* unitIds, int unitIds_max)
 int CAICallback::GetFriendlyUnits(int* unitIds, const float3& pos, float radius,
 		int unitIds_max)
 {
+	SKIRMISH_AI_ENGINE_LOCK();
+
 	verify();
 	const std::vector<CUnit*>& units = qf->GetUnitsExact(pos, radius);
 	myAllyTeamId = teamHandler->AllyTeam(team);
@@ -959,6 +994,8 @@ int CAICallback::GetFriendlyUnits(int* unitIds, const float3& pos, float radius,
 
 int CAICallback::GetNeutralUnits(int* unitIds, int unitIds_max)
 {
+	SKIRMISH_AI_ENGINE_LOCK();
+
 	verify();
 	myAllyTeamId = teamHandler->AllyTeam(team);
 	return FilterUnitsList(uh->activeUnits, unitIds, unitIds_max, &unit_IsNeutralAndInLos);
@@ -966,6 +1003,8 @@ int CAICallback::GetNeutralUnits(int* unitIds, int unitIds_max)
 
 int CAICallback::GetNeutralUnits(int* unitIds, const float3& pos, float radius, int unitIds_max)
 {
+	SKIRMISH_AI_ENGINE_LOCK();
+
 	verify();
 	const std::vector<CUnit*>& units = qf->GetUnitsExact(pos, radius);
 	myAllyTeamId = teamHandler->AllyTeam(team);
@@ -973,6 +1012,63 @@ int CAICallback::GetNeutralUnits(int* unitIds, const float3& pos, float radius,
 }
 
 
+int CAICallback::GetVisibleUnits(int* unitIds, int* unitDefIds, float* unitPos,
+		float* unitHealth, int* unitTeams, int unitIds_max)
+{
+	verify();
+	const int allyTeam = teamHandler->AllyTeam(team);
+	const unsigned short prevMask = (LOS_PREVLOS | LOS_CONTRADAR);
+
+	int a = 0;
+
+	// same visibility rules as GetUnitDef, GetUnitPos, GetUnitHealth and
+	// GetUnitTeam, but without the unit lookup and checks for every value
+	for (std::list<CUnit*>::const_iterator ui = uh->activeUnits.begin();
+			(ui != uh->activeUnits.end()) && (a < unitIds_max); ++ui) {
+		const CUnit* unit = *ui;
+		const bool allied = teamHandler->Ally(unit->allyteam, allyTeam);
+		const unsigned short losStatus = unit->losStatus[allyTeam];
+
+		if (!allied && ((losStatus & (LOS_INLOS | LOS_INRADAR)) == 0))
+			continue;
+
+		const bool inLos = (allied || ((losStatus & LOS_INLOS) != 0));
+		const UnitDef* unitDef = unit->unitDef;
+		const UnitDef* decoyDef = allied? NULL: unitDef->decoyDef;
+
+		if (unitIds != NULL) {
+			unitIds[a] = unit->id;
+		}
+		if (unitDefIds != NULL) {
+			if (inLos || ((losStatus & prevMask) == prevMask)) {
+				unitDefIds[a] = (decoyDef == NULL)? unitDef->id: decoyDef->id;
+			} else {
+				unitDefIds[a] = -1;
+			}
+		}
+		if (unitPos != NULL) {
+			helper->GetUnitErrorPos(unit, allyTeam).copyInto(&unitPos[a * 3]);
+		}
+		if (unitHealth != NULL) {
+			if (!inLos) {
+				unitHealth[a] = -1.0f;
+			} else if (decoyDef == NULL) {
+				unitHealth[a] = unit->health;
+			} else {
+				unitHealth[a] = unit->health * (decoyDef->health / unitDef->health);
+			}
+		}
+		if (unitTeams != NULL) {
+			unitTeams[a] = inLos? unit->team: -1;
+		}
+
+		a++;
+	}
+
+	return a;
+}
+
+
 
 
 int CAICallback::GetMapWidth()
@@ -1071,41 +1167,57 @@ float CAICallback::GetElevation(float x, float z)
 
 void CAICallback::LineDrawerStartPath(const float3& pos, const float* color)
 {
+	SKIRMISH_AI_ENGINE_LOCK();
+
 	lineDrawer.StartPath(pos, color);
 }
 
 void CAICallback::LineDrawerFinishPath()
 {
+	SKIRMISH_AI_ENGINE_LOCK();
+
 	lineDrawer.FinishPath();
 }
 
 void CAICallback::LineDrawerDrawLine(const float3& endPos, const float* color)
 {
+	SKIRMISH_AI_ENGINE_LOCK();
+
 	lineDrawer.DrawLine(endPos,color);
 }
 
 void CAICallback::LineDrawerDrawLineAndIcon(int commandId, const float3& endPos, const float* color)
 {
+	SKIRMISH_AI_ENGINE_LOCK();
+
 	lineDrawer.DrawLineAndIcon(commandId,endPos,color);
 }
 
 void CAICallback::LineDrawerDrawIconAtLastPos(int commandId)
 {
+	SKIRMISH_AI_ENGINE_LOCK();
+
 	lineDrawer.DrawIconAtLastPos(commandId);
 }
 
 void CAICallback::LineDrawerBreak(const float3& endPos, const float* color)
 {
+	SKIRMISH_AI_ENGINE_LOCK();
+
 	lineDrawer.Break(endPos,color);
 }
 
 void CAICallback::LineDrawerRestart()
 {
+	SKIRMISH_AI_ENGINE_LOCK();
+
 	lineDrawer.Restart();
 }
 
 void CAICallback::LineDrawerRestartSameColor()
 {
+	SKIRMISH_AI_ENGINE_LOCK();
+
 	lineDrawer.RestartSameColor();
 }
 
@@ -1114,22 +1226,30 @@ int CAICallback::CreateSplineFigure(const float3& pos1, const float3& pos2,
 		const float3& pos3, const float3& pos4, float width, int arrow,
 		int lifetime, int group)
 {
+	SKIRMISH_AI_ENGINE_LOCK();
+
 	return geometricObjects->AddSpline(pos1, pos2, pos3, pos4, width, arrow, lifetime, group);
 }
 
 int CAICallback::CreateLineFigure(const float3& pos1, const float3& pos2,
 		float width, int arrow, int lifetime, int group)
 {
+	SKIRMISH_AI_ENGINE_LOCK();
+
 	return geometricObjects->AddLine(pos1, pos2, width, arrow, lifetime, group);
 }
 
 void CAICallback::SetFigureColor(int group, float red, float green, float blue, float alpha)
 {
+	SKIRMISH_AI_ENGINE_LOCK();
+
 	geometricObjects->SetColor(group, red, green, blue, alpha);
 }
 
 void CAICallback::DeleteFigureGroup(int group)
 {
+	SKIRMISH_AI_ENGINE_LOCK();
+
 	geometricObjects->DeleteGroup(group);
 }
 
@@ -1139,6 +1259,8 @@ void CAICallback::DrawUnit(const char* unitName, const float3& pos,
 		float rotation, int lifetime, int teamId, bool transparent,
 		bool drawBorder, int facing)
 {
+	SKIRMISH_AI_ENGINE_LOCK();
+
 	CUnitDrawer::TempDrawUnit tdu;
 	tdu.unitdef = unitDefHandler->GetUnitDefByName(unitName);
 	if (!tdu.unitdef) {
@@ -1165,6 +1287,8 @@ void CAICallback::DrawUnit(const char* unitName, const float3& pos,
 
 bool CAICallback::CanBuildAt(const UnitDef* unitDef, const float3& pos, int facing)
 {
+	SKIRMISH_AI_ENGINE_LOCK();
+
 	CFeature* blockingF = NULL;
 	BuildInfo bi(unitDef, pos, facing);
 	bi.pos = helper->Pos2BuildPos(bi, false);
@@ -1174,6 +1298,8 @@ bool CAICallback::CanBuildAt(const UnitDef* unitDef, const float3& pos, int faci
 
 float3 CAICallback::ClosestBuildSite(const UnitDef* unitDef, const float3& pos, float searchRadius, int minDist, int facing)
 {
+	SKIRMISH_AI_ENGINE_LOCK();
+
 	return helper->ClosestBuildSite(team, unitDef, pos, searchRadius, minDist, facing);
 }
 
@@ -1288,6 +1414,8 @@ int CAICallback::GetFeatures(int* featureIds, int featureIds_sizeMax)
 
 int CAICallback::GetFeatures(int* featureIds, int featureIds_sizeMax, const float3& pos, float radius)
 {
+	SKIRMISH_AI_ENGINE_LOCK();
+
 	int featureIds_size = 0;
 
 	verify();
@@ -1391,6 +1519,8 @@ float3 CAICallback::GetFeaturePos(int featureId)
 
 bool CAICallback::GetValue(int id, void *data)
 {
+	SKIRMISH_AI_ENGINE_LOCK();
+
 	verify();
 	switch (id) {
 		case AIVAL_NUMDAMAGETYPES:{
@@ -1456,23 +1586,25 @@ bool CAICallback::GetValue(int id, void *data)
 
 int CAICallback::HandleCommand(int commandId, void* data)
 {
+	SKIRMISH_AI_ENGINE_LOCK();
+
 	switch (commandId) {
 		case AIHCQuerySubVersionId: {
 			return 1; // current version of Handle Command interface
 		} break;
 		case AIHCAddMapPointId: {
 			const AIHCAddMapPoint* cmdData = static_cast<AIHCAddMapPoint*>(data);
-			net->Send(CBaseNetProtocol::Get().SendMapDrawPoint(team, (short)cmdData->pos.x, (short)cmdData->pos.z, std::string(cmdData->label), false));
+			CSkirmishAIWorker::SendToServer(CBaseNetProtocol::Get().SendMapDrawPoint(team, (short)cmdData->pos.x, (short)cmdData->pos.z, std::string(cmdData->label), false));
 			return 1;
 		} break;
 		case AIHCAddMapLineId: {
 			const AIHCAddMapLine* cmdData = static_cast<AIHCAddMapLine*>(data);
-			net->Send(CBaseNetProtocol::Get().SendMapDrawLine(team, (short)cmdData->posfrom.x, (short)cmdData->posfrom.z, (short)cmdData->posto.x, (short)cmdData->posto.z, false));
+			CSkirmishAIWorker::SendToServer(CBaseNetProtocol::Get().SendMapDrawLine(team, (short)cmdData->posfrom.x, (short)cmdData->posfrom.z, (short)cmdData->posto.x, (short)cmdData->posto.z, false));
 			return 1;
 		} break;
 		case AIHCRemoveMapPointId: {
 			const AIHCRemoveMapPoint* cmdData = static_cast<AIHCRemoveMapPoint*>(data);
-			net->Send(CBaseNetProtocol::Get().SendMapErase(team, (short)cmdData->pos.x, (short)cmdData->pos.z));
+			CSkirmishAIWorker::SendToServer(CBaseNetProtocol::Get().SendMapErase(team, (short)cmdData->pos.x, (short)cmdData->pos.z));
 			return 1;
 		} break;
 		case AIHCSendStartPosId: {
@@ -1547,7 +1679,7 @@ int CAICallback::HandleCommand(int commandId, void* data)
 		case AIHCPauseId: {
 			AIHCPause* cmdData = static_cast<AIHCPause*>(data);
 
-			net->Send(CBaseNetProtocol::Get().SendPause(gu->myPlayerNum, cmdData->enable));
+			CSkirmishAIWorker::SendToServer(CBaseNetProtocol::Get().SendPause(gu->myPlayerNum, cmdData->enable));
 			LOG("Skirmish AI controlling team %i paused the game, reason: %s",
 					team,
 					cmdData->reason != NULL ? cmdData->reason : "UNSPECIFIED");
@@ -1656,6 +1788,8 @@ void CAICallback::GetUnitDefList (const UnitDef** list)
 
 float CAICallback::GetUnitDefRadius(int def)
 {
+	SKIRMISH_AI_ENGINE_LOCK();
+
 	const UnitDef* ud = unitDefHandler->GetUnitDefByID(def);
 	S3DModel* mdl = ud->LoadModel();
 	return mdl->radius;
@@ -1663,6 +1797,8 @@ float CAICallback::GetUnitDefRadius(int def)
 
 float CAICallback::GetUnitDefHeight(int def)
 {
+	SKIRMISH_AI_ENGINE_LOCK();
+
 	const UnitDef* ud = unitDefHandler->GetUnitDefByID(def);
 	S3DModel* mdl = ud->LoadModel();
 	return mdl->height;
@@ -1671,6 +1807,8 @@ float CAICallback::GetUnitDefHeight(int def)
 
 bool CAICallback::GetProperty(int unitId, int property, void* data)
 {
+	SKIRMISH_AI_ENGINE_LOCK();
+
 	verify();
 	if (CHECK_UNITID(unitId)) {
 		const CUnit* unit = uh->units[unitId];
@@ -1728,6 +1866,8 @@ bool CAICallback::GetProperty(int unitId, int property, void* data)
 
 int CAICallback::GetFileSize(const char *filename)
 {
+	SKIRMISH_AI_ENGINE_LOCK();
+
 	CFileHandler fh (filename);
 
 	if (!fh.FileExists ())
@@ -1739,6 +1879,8 @@ int CAICallback::GetFileSize(const char *filename)
 
 int CAICallback::GetFileSize(const char* filename, const char* modes)
 {
+	SKIRMISH_AI_ENGINE_LOCK();
+
 	CFileHandler fh (filename, modes);
 
 	if (!fh.FileExists ())
@@ -1750,6 +1892,8 @@ int CAICallback::GetFileSize(const char* filename, const char* modes)
 
 bool CAICallback::ReadFile(const char* filename, void* buffer, int bufferLength)
 {
+	SKIRMISH_AI_ENGINE_LOCK();
+
 	CFileHandler fh (filename);
 	int fs;
 	if (!fh.FileExists() || bufferLength < (fs = fh.FileSize()))
@@ -1763,6 +1907,8 @@ bool CAICallback::ReadFile(const char* filename, void* buffer, int bufferLength)
 bool CAICallback::ReadFile(const char* filename, const char* modes,
 		void* buffer, int bufferLength)
 {
+	SKIRMISH_AI_ENGINE_LOCK();
+
 	CFileHandler fh (filename, modes);
 	int fs;
 	if (!fh.FileExists() || bufferLength < (fs = fh.FileSize()))
@@ -1807,6 +1953,8 @@ float3 CAICallback::GetMousePos() {
 
 void CAICallback::GetMapPoints(std::vector<PointMarker>& pm, int pm_sizeMax, bool includeAllies)
 {
+	SKIRMISH_AI_ENGINE_LOCK();
+
 	verify();
 
 	// If the AI is not in the local player's ally team, the draw
@@ -1834,6 +1982,8 @@ void CAICallback::GetMapPoints(std::vector<PointMarker>& pm, int pm_sizeMax, boo
 
 void CAICallback::GetMapLines(std::vector<LineMarker>& lm, int lm_sizeMax, bool includeAllies)
 {
+	SKIRMISH_AI_ENGINE_LOCK();
+
 	verify();
 
 	// If the AI is not in the local player's ally team, the draw
@@ -127,6 +127,12 @@ public:
 	int GetFriendlyUnits(int* unitIds, const float3& pos, float radius, int unitIds_max = -1);
 	int GetNeutralUnits(int* unitIds, int unitIds_max = -1);
 	int GetNeutralUnits(int* unitIds, const float3& pos, float radius, int unitIds_max = -1);
+	/**
+	 * Fills the given arrays (each may be NULL) with the id, def, position
+	 * (3 floats per unit), health and team of all units visible to us.
+	 * @return the number of units filled in
+	 */
+	int GetVisibleUnits(int* unitIds, int* unitDefIds, float* unitPos, float* unitHealth, int* unitTeams, int unitIds_max);
 
 
 	int GetMapWidth();
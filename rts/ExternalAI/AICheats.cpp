@@ -3,6 +3,7 @@
 #include "AICheats.h"
 
 #include "ExternalAI/SkirmishAIWrapper.h"
+#include "ExternalAI/SkirmishAIWorker.h"
 #include "Game/TraceRay.h"
 #include "Sim/Units/Unit.h"
 #include "Sim/Units/CommandAI/CommandAI.h"
@@ -69,6 +70,8 @@ void CAICheats::EnableCheatEvents(bool enable)
 
 void CAICheats::SetMyIncomeMultiplier(float incomeMultiplier)
 {
+	SKIRMISH_AI_ENGINE_LOCK();
+
 	if (!OnlyPassiveCheats()) {
 		teamHandler->Team(ai->GetTeamId())->SetIncomeMultiplier(incomeMultiplier);
 	}
@@ -76,18 +79,24 @@ void CAICheats::SetMyIncomeMultiplier(float incomeMultiplier)
 
 void CAICheats::GiveMeMetal(float amount)
 {
+	SKIRMISH_AI_ENGINE_LOCK();
+
 	if (!OnlyPassiveCheats())
 		teamHandler->Team(ai->GetTeamId())->metal += amount;
 }
 
 void CAICheats::GiveMeEnergy(float amount)
 {
+	SKIRMISH_AI_ENGINE_LOCK();
+
 	if (!OnlyPassiveCheats())
 		teamHandler->Team(ai->GetTeamId())->energy += amount;
 }
 
 int CAICheats::CreateUnit(const char* name, const float3& pos)
 {
+	SKIRMISH_AI_ENGINE_LOCK();
+
 	int unitId = 0;
 
 	if (!OnlyPassiveCheats()) {
@@ -197,12 +206,16 @@ static inline bool unit_IsEnemy(CUnit* unit) {
 
 int CAICheats::GetEnemyUnits(int* unitIds, int unitIds_max)
 {
+	SKIRMISH_AI_ENGINE_LOCK();
+
 	myAllyTeamId = teamHandler->AllyTeam(ai->GetTeamId());
 	return FilterUnitsList(uh->activeUnits, unitIds, unitIds_max, &unit_IsEnemy);
 }
 
 int CAICheats::GetEnemyUnits(int* unitIds, const float3& pos, float radius, int unitIds_max)
 {
+	SKIRMISH_AI_ENGINE_LOCK();
+
 	const std::vector<CUnit*>& units = qf->GetUnitsExact(pos, radius);
 	myAllyTeamId = teamHandler->AllyTeam(ai->GetTeamId());
 	return FilterUnitsVector(units, unitIds, unitIds_max, &unit_IsEnemy);
@@ -210,21 +223,58 @@ int CAICheats::GetEnemyUnits(int* unitIds, const float3& pos, float radius, int
 
 int CAICheats::GetNeutralUnits(int* unitIds, int unitIds_max)
 {
+	SKIRMISH_AI_ENGINE_LOCK();
+
 	return FilterUnitsList(uh->activeUnits, unitIds, unitIds_max, &unit_IsNeutral);
 }
 
 int CAICheats::GetNeutralUnits(int* unitIds, const float3& pos, float radius, int unitIds_max)
 {
+	SKIRMISH_AI_ENGINE_LOCK();
+
 	const std::vector<CUnit*>& units = qf->GetUnitsExact(pos, radius);
 	return FilterUnitsVector(units, unitIds, unitIds_max, &unit_IsNeutral);
 }
 
+int CAICheats::GetVisibleUnits(int* unitIds, int* unitDefIds, float* unitPos,
+		float* unitHealth, int* unitTeams, int unitIds_max) const
+{
+	int a = 0;
+
+	for (std::list<CUnit*>::const_iterator ui = uh->activeUnits.begin();
+			(ui != uh->activeUnits.end()) && (a < unitIds_max); ++ui) {
+		const CUnit* unit = *ui;
+
+		if (unitIds != NULL) {
+			unitIds[a] = unit->id;
+		}
+		if (unitDefIds != NULL) {
+			unitDefIds[a] = unit->unitDef->id;
+		}
+		if (unitPos != NULL) {
+			unit->pos.copyInto(&unitPos[a * 3]);
+		}
+		if (unitHealth != NULL) {
+			unitHealth[a] = unit->health;
+		}
+		if (unitTeams != NULL) {
+			unitTeams[a] = unit->team;
+		}
+
+		a++;
+	}
+
+	return a;
+}
+
 int CAICheats::GetFeatures(int* features, int max) const {
 	// this method is never called anyway, see SSkirmishAICallbackImpl.cpp
 	return 0;
 }
 int CAICheats::GetFeatures(int* features, int max, const float3& pos,
 			float radius) const {
+	SKIRMISH_AI_ENGINE_LOCK();
+
 	// this method is never called anyway, see SSkirmishAICallbackImpl.cpp
 	return 0;
 }
@@ -433,6 +483,8 @@ bool CAICheats::GetValue(int id, void* data) const
 
 int CAICheats::HandleCommand(int commandId, void* data)
 {
+	SKIRMISH_AI_ENGINE_LOCK();
+
 	int ret = 0; // handling failed
 
 	switch (commandId) {
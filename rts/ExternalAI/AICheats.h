@@ -45,6 +45,8 @@ public:
 	int GetEnemyUnits(int* unitIds, const float3& pos, float radius, int unitIds_max = -1);
 	int GetNeutralUnits(int* unitIds, int unitIds_max = -1);
 	int GetNeutralUnits(int* unitIds, const float3& pos, float radius, int unitIds_max = -1);
+	/// all units, see CAICallback::GetVisibleUnits
+	int GetVisibleUnits(int* unitIds, int* unitDefIds, float* unitPos, float* unitHealth, int* unitTeams, int unitIds_max) const;
 
 	int GetFeatures(int* features, int max) const;
 	int GetFeatures(int* features, int max, const float3& pos, float radius) const;
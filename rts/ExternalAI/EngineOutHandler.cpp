@@ -28,6 +28,8 @@
 
 CONFIG(int, CatchAIExceptions).defaultValue(1);
 CONFIG(bool, AI_UnpauseAfterInit).defaultValue(true);
+CONFIG(bool, SkirmishAIThreads).defaultValue(false)
+	.description("Runs each Skirmish AI on its own thread. The AIs then handle their events concurrently with each other, once per frame, while the simulation waits for them. AIs using cheats which modify the game should not be run this way. Events reach the AIs one frame late, after destroyed units were removed, so the IDs in UnitDestroyed and EnemyDestroyed events can not be queried anymore, and may already belong to a new unit.");
 
 CR_BIND_DERIVED(CEngineOutHandler, CObject, )
 
@@ -164,6 +166,13 @@ void CEngineOutHandler::Update() {
 	const int frame = gs->frameNum;
 
 	DO_FOR_SKIRMISH_AIS(Update(frame))
+
+	// AIs running on worker threads only queued the events so far
+	// (see SkirmishAIThreads); the world does not change while they run,
+	// and their commands are sent afterwards, ordered by AI ID
+	DO_FOR_SKIRMISH_AIS(StartWorker())
+	DO_FOR_SKIRMISH_AIS(WaitForWorker())
+	DO_FOR_SKIRMISH_AIS(FinishWorker())
 }
 
 
@@ -621,6 +630,15 @@ void CEngineOutHandler::SetSkirmishAIDieing(const size_t skirmishAIId) {
 	} CATCH_AI_EXCEPTION;
 }
 
+void CEngineOutHandler::SetEventBatching(const size_t skirmishAIId, bool enable) {
+
+	const id_ai_t::iterator ai = id_skirmishAI.find(skirmishAIId);
+
+	if (ai != id_skirmishAI.end()) {
+		ai->second->SetEventBatchingEnabled(enable);
+	}
+}
+
 static void internal_aiErase(std::vector<unsigned char>& ais, const unsigned char skirmishAIId) {
 
 	for (std::vector<unsigned char>::iterator ai = ais.begin(); ai != ais.end(); ++ai) {
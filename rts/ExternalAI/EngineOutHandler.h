@@ -95,6 +95,11 @@ public:
 	 * @see CSkirmishAIHandler::SetLocalSkirmishAIDieing()
 	 */
 	void DestroySkirmishAI(const size_t skirmishAIId);
+	/**
+	 * Enables or disables batched event delivery for a local Skirmish AI.
+	 * @see SBatchEvent in Interface/AISEvents.h
+	 */
+	void SetEventBatching(const size_t skirmishAIId, bool enable);
 
 
 	void SetCheating(bool enable);
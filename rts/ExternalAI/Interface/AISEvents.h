@@ -56,8 +56,14 @@ enum EventTopic {
 	EVENT_ENEMY_CREATED                = 25,
 	EVENT_ENEMY_FINISHED               = 26,
 	EVENT_LUA_MESSAGE                  = 27,
+	EVENT_BATCH                        = 28,
 };
-const int NUM_EVENTS = 28;
+const int NUM_EVENTS = 29;
+
+/// number of int members stored per event in SBatchEvent.intParams
+const int BATCH_EVENT_INT_PARAMS   = 4;
+/// number of float members stored per event in SBatchEvent.floatParams
+const int BATCH_EVENT_FLOAT_PARAMS = 4;
 
 
 
@@ -89,6 +95,7 @@ const int NUM_EVENTS = 28;
 		+ sizeof(struct SEnemyCreatedEvent) \
 		+ sizeof(struct SEnemyFinishedEvent) \
 		+ sizeof(struct SLuaMessageEvent) \
+		+ sizeof(struct SBatchEvent) \
 		)
 
 /**
@@ -396,6 +403,47 @@ struct SEnemyFinishedEvent {
 	int enemy;
 }; //$ EVENT_ENEMY_FINISHED INTERFACES:Unit(enemy),Enemy(enemy)
 
+/**
+ * This AI event is only sent to AIs which enabled batched event delivery
+ * (see SSkirmishAICallback.Engine_setEventBatching()).
+ * It contains all the events of the topics listed below that happened since
+ * the last batch, in the order they happened. A batch is sent before the
+ * update event of each frame, and before any other event that is not batched,
+ * so the order of all events stays the same as without batching.
+ * Note that the units referenced in a batch may be dead already, when it
+ * arrives.
+ *
+ * Batched are the events of these topics:
+ * UNIT_CREATED, UNIT_FINISHED, UNIT_IDLE, UNIT_MOVE_FAILED, UNIT_DAMAGED,
+ * UNIT_DESTROYED, UNIT_GIVEN, UNIT_CAPTURED, ENEMY_CREATED, ENEMY_FINISHED,
+ * ENEMY_ENTER_LOS, ENEMY_LEAVE_LOS, ENEMY_ENTER_RADAR, ENEMY_LEAVE_RADAR,
+ * ENEMY_DAMAGED, ENEMY_DESTROYED, WEAPON_FIRED, COMMAND_FINISHED,
+ * SEISMIC_PING
+ *
+ * The members of the event struct of the i'th event are stored in the order
+ * they appear in the struct: int and bool members (bools as 0 or 1) in
+ * intParams[i * BATCH_EVENT_INT_PARAMS + n], float members and the three
+ * components of float3 members in
+ * floatParams[i * BATCH_EVENT_FLOAT_PARAMS + n].
+ * For example, a UNIT_DAMAGED event is stored as
+ * {unit, attacker, weaponDefId, paralyzer} and {damage, dir x, y, z}.
+ * Unused parameters are 0.
+ */
+struct SBatchEvent {
+	/// the frame the events happened in, or before
+	int frame;
+	/// topic of each event
+	int* topics;
+	/// number of events
+	int topics_size;
+	int* intParams;
+	/// topics_size * BATCH_EVENT_INT_PARAMS
+	int intParams_size;
+	float* floatParams;
+	/// topics_size * BATCH_EVENT_FLOAT_PARAMS
+	int floatParams_size;
+}; //$ EVENT_BATCH
+
 #ifdef	__cplusplus
 } // extern "C"
 #endif
@@ -2304,6 +2304,31 @@ struct SSkirmishAICallback {
 
 	bool              (CALLING_CONV *Debug_GraphDrawer_isEnabled)(int skirmishAIId);
 
+	/**
+	 * Enables or disables batched event delivery for this AI.
+	 * When enabled, unit related events are not sent one by one anymore,
+	 * but collected and sent as a single batch event, right before the update
+	 * event of each frame.
+	 * Events collected before disabling are still sent as a batch, right
+	 * before the next event.
+	 * @see SBatchEvent in AISEvents.h
+	 */
+	void              (CALLING_CONV *Engine_setEventBatching)(int skirmishAIId, bool enable);
+
+	/**
+	 * Fills the given arrays with the state of all units this AI can see
+	 * (own and allied units, and enemy units in LOS or radar; all units with
+	 * cheats enabled), using a single pass over all units.
+	 * This is much faster than fetching the same data unit by unit.
+	 * Each value is the same as returned by the Unit_get* method of the same
+	 * name, so for example the def is -1 for units only seen on radar, and
+	 * the position of radar-only units contains the radar error.
+	 * Any of the arrays may be NULL, if the data is not needed.
+	 * @param pos_AposF3  3 floats per unit
+	 * @return the number of units filled in, at most unitIds_sizeMax
+	 */
+	int               (CALLING_CONV *getVisibleUnitsSnapshot)(int skirmishAIId, int* unitIds, int* unitDefIds, float* pos_AposF3, float* health, int* teams, int unitIds_sizeMax);
+
 };
 
 #if	defined(__cplusplus)
@@ -2,11 +2,13 @@
 
 #include "ExternalAI/AICallback.h"
 #include "ExternalAI/AICheats.h"
+#include "ExternalAI/EngineOutHandler.h"
 #include "ExternalAI/IAILibraryManager.h"
 #include "ExternalAI/SSkirmishAICallbackImpl.h"
 #include "ExternalAI/SkirmishAILibraryInfo.h"
 #include "ExternalAI/SAIInterfaceCallbackImpl.h"
 #include "ExternalAI/SkirmishAIHandler.h"
+#include "ExternalAI/SkirmishAIWorker.h"
 #include "ExternalAI/Interface/AISCommands.h"
 #include "ExternalAI/Interface/SSkirmishAICallback.h"
 #include "ExternalAI/Interface/SSkirmishAILibrary.h"
@@ -199,6 +201,8 @@ static int wrapper_HandleCommand(CAICallback* clb, CAICheats* clbCheat,
 EXPORT(int) skirmishAiCallback_Engine_handleCommand(int skirmishAIId, int toId, int commandId,
 		int commandTopic, void* commandData) {
 
+	SKIRMISH_AI_ENGINE_LOCK();
+
 	int ret = 0;
 
 	CAICallback* clb = skirmishAIId_callback[skirmishAIId];
@@ -936,6 +940,7 @@ EXPORT(const char*) skirmishAiCallback_SkirmishAI_OptionValues_getValueByKey(int
 
 EXPORT(void) skirmishAiCallback_Log_log(int skirmishAIId, const char* const msg) {
 
+	SKIRMISH_AI_ENGINE_LOCK();
 	checkSkirmishAIId(skirmishAIId);
 
 	const CSkirmishAILibraryInfo* info = getSkirmishAILibraryInfo(skirmishAIId);
@@ -944,6 +949,7 @@ EXPORT(void) skirmishAiCallback_Log_log(int skirmishAIId, const char* const msg)
 
 EXPORT(void) skirmishAiCallback_Log_exception(int skirmishAIId, const char* const msg, int severety, bool die) {
 
+	SKIRMISH_AI_ENGINE_LOCK();
 	checkSkirmishAIId(skirmishAIId);
 
 	const CSkirmishAILibraryInfo* info = getSkirmishAILibraryInfo(skirmishAIId);
@@ -1020,6 +1026,7 @@ EXPORT(char*) skirmishAiCallback_DataDirs_allocatePath(int skirmishAIId, const c
 static std::vector<std::string> writeableDataDirs;
 EXPORT(const char*) skirmishAiCallback_DataDirs_getWriteableDir(int skirmishAIId) {
 
+	SKIRMISH_AI_ENGINE_LOCK();
 	checkSkirmishAIId(skirmishAIId);
 
 	// fill up writeableDataDirs until teamId index is in there
@@ -1671,6 +1678,8 @@ EXPORT(int) skirmishAiCallback_Map_getResourceMapRaw(
 }
 
 static inline const CResourceMapAnalyzer* getResourceMapAnalyzer(int resourceId) {
+	// the analyzer is created on first use
+	SKIRMISH_AI_ENGINE_LOCK();
 	return resourceHandler->GetResourceMapAnalyzer(resourceId);
 }
 
@@ -3350,7 +3359,7 @@ EXPORT(int) skirmishAiCallback_Unit_CurrentCommand_getParams(int skirmishAIId,
 		return -1;
 	}
 
-	const std::vector<float>& ps = q->at(commandId).params;
+	const CommandParams& ps = q->at(commandId).params;
 	const size_t params_sizeReal = ps.size();
 
 	size_t params_size = params_sizeReal;
@@ -3779,6 +3788,7 @@ EXPORT(int) skirmishAiCallback_getFeaturesIn(int skirmishAIId, float* pos_posF3,
 
 	if (skirmishAiCallback_Cheats_isEnabled(skirmishAIId)) {
 		// cheating
+		SKIRMISH_AI_ENGINE_LOCK();
 		const std::vector<CFeature*>& fset = qf->GetFeaturesExact(pos_posF3, radius);
 		const int featureIds_sizeReal = fset.size();
 
@@ -4414,6 +4424,20 @@ EXPORT(bool) skirmishAiCallback_Debug_GraphDrawer_isEnabled(int skirmishAIId) {
 	return skirmishAIId_callback[skirmishAIId]->IsDebugDrawerEnabled();
 }
 
+EXPORT(void) skirmishAiCallback_Engine_setEventBatching(int skirmishAIId, bool enable) {
+	eoh->SetEventBatching(skirmishAIId, enable);
+}
+
+EXPORT(int) skirmishAiCallback_getVisibleUnitsSnapshot(int skirmishAIId, int* unitIds,
+		int* unitDefIds, float* pos_AposF3, float* health, int* teams, int unitIds_sizeMax)
+{
+	if (skirmishAiCallback_Cheats_isEnabled(skirmishAIId)) {
+		return skirmishAIId_cheatCallback[skirmishAIId]->GetVisibleUnits(unitIds, unitDefIds, pos_AposF3, health, teams, unitIds_sizeMax);
+	} else {
+		return skirmishAIId_callback[skirmishAIId]->GetVisibleUnits(unitIds, unitDefIds, pos_AposF3, health, teams, unitIds_sizeMax);
+	}
+}
+
 EXPORT(int) skirmishAiCallback_getGroups(int skirmishAIId, int* groupIds, int groupIds_sizeMax) {
 	GML_RECMUTEX_LOCK(group); // skirmishAiCallback_getGroups
 
@@ -4517,7 +4541,7 @@ EXPORT(int) skirmishAiCallback_Group_OrderPreview_getParams(int skirmishAIId,
 
 	if (!isControlledByLocalPlayer(skirmishAIId)) { return 0; }
 
-	const std::vector<float>& ps = guihandler->GetOrderPreview().params;
+	const CommandParams& ps = guihandler->GetOrderPreview().params;
 	const size_t params_sizeReal = ps.size();
 
 	size_t params_size = params_sizeReal;
@@ -5151,6 +5175,8 @@ static void skirmishAiCallback_init(SSkirmishAICallback* callback) {
 	callback->WeaponDef_isDynDamageInverted = &skirmishAiCallback_WeaponDef_isDynDamageInverted;
 	callback->WeaponDef_getCustomParams = &skirmishAiCallback_WeaponDef_getCustomParams;
 	callback->Debug_GraphDrawer_isEnabled = &skirmishAiCallback_Debug_GraphDrawer_isEnabled;
+	callback->Engine_setEventBatching = &skirmishAiCallback_Engine_setEventBatching;
+	callback->getVisibleUnitsSnapshot = &skirmishAiCallback_getVisibleUnitsSnapshot;
 }
 
 SSkirmishAICallback* skirmishAiCallback_getInstanceFor(int skirmishAIId, int teamId, CAICallback* aiCallback, CAICheats* aiCheats) {
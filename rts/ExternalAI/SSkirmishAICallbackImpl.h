@@ -1277,6 +1277,10 @@ EXPORT(int              ) skirmishAiCallback_WeaponDef_getCustomParams(int skirm
 
 EXPORT(bool             ) skirmishAiCallback_Debug_GraphDrawer_isEnabled(int skirmishAIId);
 
+EXPORT(void             ) skirmishAiCallback_Engine_setEventBatching(int skirmishAIId, bool enable);
+
+EXPORT(int              ) skirmishAiCallback_getVisibleUnitsSnapshot(int skirmishAIId, int* unitIds, int* unitDefIds, float* pos_AposF3, float* health, int* teams, int unitIds_sizeMax);
+
 #if	defined(__cplusplus)
 } // extern "C"
 #endif
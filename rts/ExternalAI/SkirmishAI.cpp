@@ -6,9 +6,23 @@
 #include "IAILibraryManager.h"
 #include "SkirmishAILibrary.h"
 #include "SkirmishAIHandler.h"
+#include "SkirmishAIWorker.h"
 #include "System/TimeProfiler.h"
 #include "System/Util.h"
 
+#include <boost/scoped_ptr.hpp>
+
+/**
+ * The profiler may only be used on the simulation thread; AIs running on
+ * a worker thread are timed by it as a whole, see CSkirmishAIWrapper.
+ */
+static ScopedTimer* CreateTimer(const std::string& timerName) {
+	if (CSkirmishAIWorker::GetCurrent() != NULL)
+		return NULL;
+
+	return new ScopedTimer(timerName.c_str());
+}
+
 CSkirmishAI::CSkirmishAI(int skirmishAIId, int teamId, const SkirmishAIKey& key,
 		const SSkirmishAICallback* callback) :
 		skirmishAIId(skirmishAIId),
@@ -20,7 +34,7 @@ CSkirmishAI::CSkirmishAI(int skirmishAIId, int teamId, const SkirmishAIKey& key,
 		initOk(false),
 		dieing(false)
 {
-	SCOPED_TIMER(timerName.c_str());
+	const boost::scoped_ptr<ScopedTimer> timer(CreateTimer(timerName));
 	library = IAILibraryManager::GetInstance()->FetchSkirmishAILibrary(key);
 	if (library == NULL) {
 		dieing = true;
@@ -31,7 +45,7 @@ CSkirmishAI::CSkirmishAI(int skirmishAIId, int teamId, const SkirmishAIKey& key,
 
 CSkirmishAI::~CSkirmishAI() {
 
-	SCOPED_TIMER(timerName.c_str());
+	const boost::scoped_ptr<ScopedTimer> timer(CreateTimer(timerName));
 	if (initOk) {
 		library->Release(skirmishAIId);
 	}
@@ -52,7 +66,7 @@ void CSkirmishAI::Dieing() {
 
 int CSkirmishAI::HandleEvent(int topic, const void* data) const {
 
-	SCOPED_TIMER(timerName.c_str());
+	const boost::scoped_ptr<ScopedTimer> timer(CreateTimer(timerName));
 	if (!dieing || (topic == EVENT_RELEASE)) {
 		return library->HandleEvent(skirmishAIId, topic, data);
 	} else {
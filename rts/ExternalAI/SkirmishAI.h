@@ -42,6 +42,9 @@ public:
 	 */
 	void Dieing();
 
+	/// name of the profiler entry of this AI
+	const std::string& GetTimerName() const { return timerName; }
+
 private:
 	int skirmishAIId;
 	const SkirmishAIKey key;
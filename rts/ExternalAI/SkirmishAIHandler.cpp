@@ -5,6 +5,7 @@
 #include "ExternalAI/SkirmishAIKey.h"
 #include "ExternalAI/IAILibraryManager.h"
 #include "ExternalAI/EngineOutHandler.h"
+#include "ExternalAI/SkirmishAIWorker.h"
 #include "ExternalAI/LuaAIImplHandler.h"
 #include "ExternalAI/Interface/SSkirmishAILibrary.h"
 #include "Game/GameSetup.h"
@@ -311,3 +312,20 @@ void CSkirmishAIHandler::CompleteSkirmishAI(const size_t skirmishAIId) {
 		}
 	}
 }
+
+unsigned char CSkirmishAIHandler::GetCurrentAIID() const {
+
+	const CSkirmishAIWorker* worker = CSkirmishAIWorker::GetCurrent();
+
+	if (worker != NULL)
+		return worker->GetSkirmishAIId();
+
+	return currentAIId;
+}
+
+void CSkirmishAIHandler::SetCurrentAIID(unsigned char id) {
+
+	// AIs on worker threads run concurrently, so they can not share this
+	if (CSkirmishAIWorker::GetCurrent() == NULL)
+		currentAIId = id;
+}
@@ -172,8 +172,12 @@ public:
 
 	const std::set<std::string>& GetLuaAIImplShortNames() const;
 
-	unsigned char GetCurrentAIID() { return currentAIId; }
-	void SetCurrentAIID(unsigned char id) { currentAIId = id; }
+	/**
+	 * The AI currently handling an event; on the worker thread of an AI
+	 * (see CSkirmishAIWorker), this is always the ID of that AI.
+	 */
+	unsigned char GetCurrentAIID() const;
+	void SetCurrentAIID(unsigned char id);
 
 private:
 	static bool IsLocalSkirmishAI(const SkirmishAIData& aiData);
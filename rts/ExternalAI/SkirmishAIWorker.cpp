@@ -0,0 +1,220 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "SkirmishAIWorker.h"
+
+#include "System/NetProtocol.h"
+#include "System/Platform/Threading.h"
+#include "lib/streflop/streflop_cond.h"
+
+#include <exception>
+#include <sstream>
+#include <stdexcept>
+#include <boost/bind.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+#include <boost/thread/recursive_mutex.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/tss.hpp>
+
+
+namespace {
+	/// the worker of the calling thread; the deleter must not delete it
+	void KeepWorker(CSkirmishAIWorker*) {}
+	boost::thread_specific_ptr<CSkirmishAIWorker> currentWorker(&KeepWorker);
+
+	boost::recursive_mutex engineMutex;
+}
+
+
+CSkirmishAIWorker::EngineLock::EngineLock()
+	: locked(CSkirmishAIWorker::GetCurrent() != NULL)
+{
+	if (locked)
+		engineMutex.lock();
+}
+
+CSkirmishAIWorker::EngineLock::~EngineLock()
+{
+	if (locked)
+		engineMutex.unlock();
+}
+
+
+
+CSkirmishAIWorker::CSkirmishAIWorker(int skirmishAIId)
+	: skirmishAIId(skirmishAIId)
+	, thread(NULL)
+	, busy(false)
+	, quit(false)
+	, taskTime(0)
+{
+	thread = new boost::thread(boost::bind(&CSkirmishAIWorker::ThreadMain, this));
+}
+
+CSkirmishAIWorker::~CSkirmishAIWorker()
+{
+	{
+		boost::mutex::scoped_lock lock(mutex);
+		queuedTasks.clear();
+		quit = true;
+		startCond.notify_one();
+	}
+
+	thread->join();
+	delete thread;
+}
+
+
+void CSkirmishAIWorker::ThreadMain()
+{
+	std::ostringstream threadName;
+	threadName << "skirmishai" << skirmishAIId;
+	Threading::SetThreadName(threadName.str());
+
+	// AIs get the same FPU settings as on the simulation thread
+	streflop::streflop_init<streflop::Simple>();
+
+	currentWorker.reset(this);
+
+	boost::mutex::scoped_lock lock(mutex);
+
+	while (true) {
+		while (!quit && startedTasks.empty()) {
+			startCond.wait(lock);
+		}
+
+		if (startedTasks.empty())
+			break;
+
+		// the tasks of a batch were queued by a single thread, which waits
+		// for them, so they can run without holding the lock
+		std::deque<Task> tasks;
+		tasks.swap(startedTasks);
+		lock.unlock();
+
+		const boost::posix_time::ptime startTime = boost::posix_time::microsec_clock::universal_time();
+		std::string taskError;
+
+		for (std::deque<Task>::iterator it = tasks.begin(); it != tasks.end(); ++it) {
+			try {
+				(*it)();
+			} catch (const std::exception& ex) {
+				if (taskError.empty())
+					taskError = ex.what();
+			} catch (...) {
+				if (taskError.empty())
+					taskError = "unknown exception";
+			}
+		}
+
+		const boost::posix_time::time_duration duration = boost::posix_time::microsec_clock::universal_time() - startTime;
+
+		lock.lock();
+		taskTime += duration.total_milliseconds();
+
+		if (error.empty())
+			error = taskError;
+
+		busy = false;
+		doneCond.notify_all();
+	}
+}
+
+
+void CSkirmishAIWorker::Post(const Task& task)
+{
+	boost::mutex::scoped_lock lock(mutex);
+	queuedTasks.push_back(task);
+}
+
+void CSkirmishAIWorker::Start()
+{
+	boost::mutex::scoped_lock lock(mutex);
+
+	if (busy || queuedTasks.empty())
+		return;
+
+	startedTasks.swap(queuedTasks);
+	busy = true;
+	startCond.notify_one();
+}
+
+void CSkirmishAIWorker::Wait()
+{
+	boost::mutex::scoped_lock lock(mutex);
+
+	while (busy) {
+		doneCond.wait(lock);
+	}
+}
+
+void CSkirmishAIWorker::Call(const Task& task)
+{
+	// happens if the AI triggers an event synchronously delivered to itself
+	// (eg. a Lua message); it is already on the right thread
+	if (GetCurrent() == this) {
+		task();
+		return;
+	}
+
+	Wait();
+	Post(task);
+	Start();
+	Wait();
+	RethrowError();
+}
+
+void CSkirmishAIWorker::RethrowError()
+{
+	std::string taskError;
+
+	{
+		boost::mutex::scoped_lock lock(mutex);
+		taskError.swap(error);
+	}
+
+	if (!taskError.empty())
+		throw std::runtime_error(taskError);
+}
+
+
+void CSkirmishAIWorker::SendQueuedPackets()
+{
+	std::vector<Packet> packets;
+
+	{
+		boost::mutex::scoped_lock lock(mutex);
+		packets.swap(queuedPackets);
+	}
+
+	for (std::vector<Packet>::const_iterator it = packets.begin(); it != packets.end(); ++it) {
+		net->Send(*it);
+	}
+}
+
+unsigned int CSkirmishAIWorker::GetAndResetTaskTime()
+{
+	boost::mutex::scoped_lock lock(mutex);
+
+	const unsigned int time = taskTime;
+	taskTime = 0;
+	return time;
+}
+
+
+CSkirmishAIWorker* CSkirmishAIWorker::GetCurrent()
+{
+	return currentWorker.get();
+}
+
+void CSkirmishAIWorker::SendToServer(const Packet& packet)
+{
+	CSkirmishAIWorker* worker = GetCurrent();
+
+	if (worker == NULL) {
+		net->Send(packet);
+		return;
+	}
+
+	boost::mutex::scoped_lock lock(worker->mutex);
+	worker->queuedPackets.push_back(packet);
+}
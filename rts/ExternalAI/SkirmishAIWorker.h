@@ -0,0 +1,129 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef SKIRMISH_AI_WORKER_H
+#define SKIRMISH_AI_WORKER_H
+
+#include <deque>
+#include <string>
+#include <vector>
+#include <boost/function.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
+
+namespace boost {
+	class thread;
+}
+namespace netcode {
+	class RawPacket;
+}
+
+/**
+ * Worker thread of a single Skirmish AI (see the SkirmishAIThreads config
+ * variable).
+ * Every call into the AI library is executed as a task on the worker:
+ * - events are only queued (Post) while the simulation runs
+ * - in CEngineOutHandler::Update, the queued tasks of all AIs are started
+ *   (Start), and the simulation waits until all of them are done (Wait);
+ *   so the AIs run concurrently with each other, but always see a
+ *   consistent, unchanging world
+ * - as CEngineOutHandler::Update runs at the start of the next frame, dead
+ *   units are already deleted when the AIs see their destroy events, and
+ *   their IDs may have been reused by new units
+ * - calls which need their result right away (init, release, load, save
+ *   and Lua messages) are executed synchronously (Call)
+ *
+ * The few engine functions which use shared scratch data or modify engine
+ * state, have to be guarded with SKIRMISH_AI_ENGINE_LOCK, as AIs running at
+ * the same time may call them concurrently.
+ * AI commands are not sent from the worker, but queued, and sent by the
+ * simulation thread after the AI phase, in the order of the AI IDs, so the
+ * order in which they arrive does not depend on thread timing.
+ */
+class CSkirmishAIWorker
+{
+public:
+	typedef boost::function<void()> Task;
+	typedef boost::shared_ptr<const netcode::RawPacket> Packet;
+
+	/**
+	 * Serializes engine access of the workers (see above); does nothing
+	 * when called from any other thread, as those never run at the same
+	 * time as a worker.
+	 */
+	class EngineLock {
+	public:
+		EngineLock();
+		~EngineLock();
+	private:
+		bool locked;
+	};
+
+public:
+	CSkirmishAIWorker(int skirmishAIId);
+	/// Waits for the current tasks, and discards the queued ones
+	~CSkirmishAIWorker();
+
+	/// Queues a task, which is executed with the next Start
+	void Post(const Task& task);
+	/// Starts executing all queued tasks on the worker thread
+	void Start();
+	/// Waits until all started tasks were executed
+	void Wait();
+	/**
+	 * Executes the queued tasks and then the given one, and waits for them.
+	 * Rethrows an exception thrown by any of them.
+	 */
+	void Call(const Task& task);
+
+	/**
+	 * Throws a std::runtime_error, if a task started since the last call
+	 * threw an exception (the worker continues with the next task).
+	 */
+	void RethrowError();
+
+	/// Sends the queued AI commands to the server
+	void SendQueuedPackets();
+	/// Time spent executing tasks since the last call, in milliseconds
+	unsigned int GetAndResetTaskTime();
+
+	int GetSkirmishAIId() const { return skirmishAIId; }
+
+	/// @return the worker of the calling thread, or NULL
+	static CSkirmishAIWorker* GetCurrent();
+
+	/**
+	 * Sends the packet to the server, or queues it, when called from a
+	 * worker thread.
+	 */
+	static void SendToServer(const Packet& packet);
+
+private:
+	void ThreadMain();
+
+private:
+	const int skirmishAIId;
+
+	boost::thread* thread;
+	boost::mutex mutex;
+	/// signals the worker, that tasks were started, or that it should exit
+	boost::condition_variable startCond;
+	/// signals waiting threads, that the started tasks are done
+	boost::condition_variable doneCond;
+
+	std::deque<Task> queuedTasks;
+	std::deque<Task> startedTasks;
+	bool busy;
+	bool quit;
+
+	std::string error;
+	unsigned int taskTime;
+
+	/// AI commands sent by the worker, see SendToServer
+	std::vector<Packet> queuedPackets;
+};
+
+/// @see CSkirmishAIWorker::EngineLock
+#define SKIRMISH_AI_ENGINE_LOCK() const CSkirmishAIWorker::EngineLock skirmishAIEngineLock
+
+#endif // SKIRMISH_AI_WORKER_H
@@ -7,12 +7,16 @@
 #include "System/FileSystem/FileSystem.h"
 #include "System/Log/ILog.h"
 #include "System/Util.h"
+#include "System/TimeProfiler.h"
+#include "System/Config/ConfigHandler.h"
 #include "Sim/Units/Unit.h"
 #include "Sim/Units/UnitHandler.h"
+#include "Sim/Misc/GlobalSynced.h"
 #include "Sim/Misc/TeamHandler.h"
 #include "ExternalAI/AICallback.h"
 #include "ExternalAI/AICheats.h"
 #include "ExternalAI/SkirmishAI.h"
+#include "ExternalAI/SkirmishAIWorker.h"
 #include "ExternalAI/EngineOutHandler.h"
 #include "ExternalAI/SkirmishAIHandler.h"
 #include "ExternalAI/SkirmishAILibraryInfo.h"
@@ -26,14 +30,23 @@
 #include <sstream>
 #include <iostream>
 #include <fstream>
+#include <boost/bind.hpp>
 
 #undef DeleteFile
 
+/// passes an event on to the worker thread of the AI, if it has one
+#define POST_TO_WORKER(CALL)   \
+	if (IsDeferred()) {        \
+		worker->Post(CALL);    \
+		return;                \
+	}
+
 CR_BIND_DERIVED(CSkirmishAIWrapper, CObject, )
 CR_REG_METADATA(CSkirmishAIWrapper, (
 	CR_MEMBER(skirmishAIId),
 	CR_MEMBER(teamId),
 	CR_MEMBER(cheatEvents),
+	CR_MEMBER(batchEvents),
 	CR_MEMBER(key),
 	CR_SERIALIZER(Serialize),
 	CR_POSTLOAD(PostLoad)
@@ -44,13 +57,15 @@ CSkirmishAIWrapper::CSkirmishAIWrapper():
 		skirmishAIId(-1),
 		teamId(-1),
 		cheatEvents(false),
+		batchEvents(false),
 		ai(NULL),
 		initialized(false),
 		released(false),
 		callback(NULL),
 		cheats(NULL),
 		c_callback(NULL),
-		info(NULL)
+		info(NULL),
+		worker(NULL)
 {
 }
 
@@ -58,13 +73,15 @@ CSkirmishAIWrapper::CSkirmishAIWrapper(const int skirmishAIId):
 		skirmishAIId(skirmishAIId),
 		teamId(-1),
 		cheatEvents(false),
+		batchEvents(false),
 		ai(NULL),
 		initialized(false),
 		released(false),
 		callback(NULL),
 		cheats(NULL),
 		c_callback(NULL),
-		info(NULL)
+		info(NULL),
+		worker(NULL)
 {
 	const SkirmishAIData* aiData = skirmishAIHandler.GetSkirmishAI(skirmishAIId);
 
@@ -73,6 +90,7 @@ CSkirmishAIWrapper::CSkirmishAIWrapper(const int skirmishAIId):
 	key    = aiLibManager->ResolveSkirmishAIKey(keyTmp);
 
 	CreateCallback();
+	CreateWorker();
 }
 
 void CSkirmishAIWrapper::CreateCallback() {
@@ -84,6 +102,13 @@ void CSkirmishAIWrapper::CreateCallback() {
 	}
 }
 
+void CSkirmishAIWrapper::CreateWorker() {
+
+	if (worker == NULL && configHandler->GetBool("SkirmishAIThreads")) {
+		worker = new CSkirmishAIWorker(skirmishAIId);
+	}
+}
+
 void CSkirmishAIWrapper::PreDestroy() {
 	callback->noMessages = true;
 }
@@ -94,8 +119,7 @@ CSkirmishAIWrapper::~CSkirmishAIWrapper() {
 			Release();
 		}
 
-		delete ai;
-		ai = NULL;
+		CallOnWorker(boost::bind(&CSkirmishAIWrapper::DeleteAI, this));
 
 		skirmishAiCallback_release(skirmishAIId);
 		c_callback = NULL;
@@ -106,6 +130,14 @@ CSkirmishAIWrapper::~CSkirmishAIWrapper() {
 		delete cheats;
 		cheats = NULL;
 	}
+
+	delete worker;
+	worker = NULL;
+}
+
+void CSkirmishAIWrapper::DeleteAI() {
+	delete ai;
+	ai = NULL;
 }
 
 void CSkirmishAIWrapper::Serialize(creg::ISerializer* s) {
@@ -113,7 +145,8 @@ void CSkirmishAIWrapper::Serialize(creg::ISerializer* s) {
 
 void CSkirmishAIWrapper::PostLoad() {
 	//CreateCallback();
-	LoadSkirmishAI(true);
+	CreateWorker();
+	CallOnWorker(boost::bind(&CSkirmishAIWrapper::LoadSkirmishAI, this, true));
 }
 
 
@@ -179,6 +212,12 @@ bool CSkirmishAIWrapper::LoadSkirmishAI(bool postLoad) {
 
 void CSkirmishAIWrapper::Init() {
 
+	if (IsDeferred()) {
+		// the AI library is loaded on the worker, too
+		CallOnWorker(boost::bind(&CSkirmishAIWrapper::Init, this));
+		return;
+	}
+
 	if (ai == NULL) {
 		bool loadOk = LoadSkirmishAI(false);
 		if (!loadOk) {
@@ -207,7 +246,17 @@ void CSkirmishAIWrapper::Dieing() {
 
 void CSkirmishAIWrapper::Release(int reason) {
 
+	if (IsDeferred()) {
+		CallOnWorker(boost::bind(&CSkirmishAIWrapper::Release, this, reason));
+		return;
+	}
+
 	if (initialized && !released) {
+		// the AI will not be interested in these anymore
+		batchTopics.clear();
+		batchIntParams.clear();
+		batchFloatParams.clear();
+
 		SReleaseEvent evtData = {reason};
 		ai->HandleEvent(EVENT_RELEASE, &evtData);
 
@@ -259,7 +308,7 @@ void CSkirmishAIWrapper::Load(std::istream* load_s)
 	tmpFile_s.close();
 
 	SLoadEvent evtData = {tmpFile.c_str()};
-	ai->HandleEvent(EVENT_LOAD, &evtData);
+	CallOnWorker(boost::bind(&CSkirmishAIWrapper::SendEvent, this, EVENT_LOAD, &evtData));
 
 	FileSystem::DeleteFile(tmpFile);
 }
@@ -269,7 +318,7 @@ void CSkirmishAIWrapper::Save(std::ostream* save_s)
 	const std::string tmpFile = createTempFileName("save", teamId, skirmishAIId);
 
 	SSaveEvent evtData = {tmpFile.c_str()};
-	ai->HandleEvent(EVENT_SAVE, &evtData);
+	CallOnWorker(boost::bind(&CSkirmishAIWrapper::SendEvent, this, EVENT_SAVE, &evtData));
 
 	if (FileSystem::FileExists(tmpFile)) {
 		std::ifstream tmpFile_s;
@@ -281,144 +330,194 @@ void CSkirmishAIWrapper::Save(std::ostream* save_s)
 }
 
 void CSkirmishAIWrapper::UnitIdle(int unitId) {
+	POST_TO_WORKER(boost::bind(&CSkirmishAIWrapper::UnitIdle, this, unitId));
+
 	SUnitIdleEvent evtData = {unitId};
-	ai->HandleEvent(EVENT_UNIT_IDLE, &evtData);
+	SendEvent(EVENT_UNIT_IDLE, &evtData);
 }
 
 void CSkirmishAIWrapper::UnitCreated(int unitId, int builderId) {
+	POST_TO_WORKER(boost::bind(&CSkirmishAIWrapper::UnitCreated, this, unitId, builderId));
+
 	SUnitCreatedEvent evtData = {unitId, builderId};
-	ai->HandleEvent(EVENT_UNIT_CREATED, &evtData);
+	SendEvent(EVENT_UNIT_CREATED, &evtData);
 }
 
 void CSkirmishAIWrapper::UnitFinished(int unitId) {
+	POST_TO_WORKER(boost::bind(&CSkirmishAIWrapper::UnitFinished, this, unitId));
+
 	SUnitFinishedEvent evtData = {unitId};
-	ai->HandleEvent(EVENT_UNIT_FINISHED, &evtData);
+	SendEvent(EVENT_UNIT_FINISHED, &evtData);
 }
 
 void CSkirmishAIWrapper::UnitDestroyed(int unitId, int attackerUnitId) {
+	POST_TO_WORKER(boost::bind(&CSkirmishAIWrapper::UnitDestroyed, this, unitId, attackerUnitId));
 
 	SUnitDestroyedEvent evtData = {unitId, attackerUnitId};
-	ai->HandleEvent(EVENT_UNIT_DESTROYED, &evtData);
+	SendEvent(EVENT_UNIT_DESTROYED, &evtData);
 }
 
 void CSkirmishAIWrapper::UnitDamaged(int unitId, int attackerUnitId,
 		float damage, const float3& dir, int weaponDefId, bool paralyzer) {
+	POST_TO_WORKER(boost::bind(&CSkirmishAIWrapper::UnitDamaged, this, unitId, attackerUnitId, damage, dir, weaponDefId, paralyzer));
+
+	float dir_posF3[3];
+	dir.copyInto(dir_posF3);
 
 	SUnitDamagedEvent evtData = {unitId, attackerUnitId, damage,
-			new float[3], weaponDefId, paralyzer};
-	dir.copyInto(evtData.dir_posF3);
-	ai->HandleEvent(EVENT_UNIT_DAMAGED, &evtData);
-	delete [] evtData.dir_posF3;
+			dir_posF3, weaponDefId, paralyzer};
+	SendEvent(EVENT_UNIT_DAMAGED, &evtData);
 }
 
 void CSkirmishAIWrapper::UnitMoveFailed(int unitId) {
+	POST_TO_WORKER(boost::bind(&CSkirmishAIWrapper::UnitMoveFailed, this, unitId));
+
 	SUnitMoveFailedEvent evtData = {unitId};
-	ai->HandleEvent(EVENT_UNIT_MOVE_FAILED, &evtData);
+	SendEvent(EVENT_UNIT_MOVE_FAILED, &evtData);
 }
 
 void CSkirmishAIWrapper::UnitGiven(int unitId, int oldTeam, int newTeam) {
+	POST_TO_WORKER(boost::bind(&CSkirmishAIWrapper::UnitGiven, this, unitId, oldTeam, newTeam));
+
 	SUnitGivenEvent evtData = {unitId, oldTeam, newTeam};
-	ai->HandleEvent(EVENT_UNIT_GIVEN, &evtData);
+	SendEvent(EVENT_UNIT_GIVEN, &evtData);
 }
 
 void CSkirmishAIWrapper::UnitCaptured(int unitId, int oldTeam, int newTeam) {
+	POST_TO_WORKER(boost::bind(&CSkirmishAIWrapper::UnitCaptured, this, unitId, oldTeam, newTeam));
+
 	SUnitCapturedEvent evtData = {unitId, oldTeam, newTeam};
-	ai->HandleEvent(EVENT_UNIT_CAPTURED, &evtData);
+	SendEvent(EVENT_UNIT_CAPTURED, &evtData);
 }
 
 
 void CSkirmishAIWrapper::EnemyCreated(int unitId) {
+	POST_TO_WORKER(boost::bind(&CSkirmishAIWrapper::EnemyCreated, this, unitId));
+
 	SEnemyCreatedEvent evtData = {unitId};
-	ai->HandleEvent(EVENT_ENEMY_CREATED, &evtData);
+	SendEvent(EVENT_ENEMY_CREATED, &evtData);
 }
 
 void CSkirmishAIWrapper::EnemyFinished(int unitId) {
+	POST_TO_WORKER(boost::bind(&CSkirmishAIWrapper::EnemyFinished, this, unitId));
+
 	SEnemyFinishedEvent evtData = {unitId};
-	ai->HandleEvent(EVENT_ENEMY_FINISHED, &evtData);
+	SendEvent(EVENT_ENEMY_FINISHED, &evtData);
 }
 
 void CSkirmishAIWrapper::EnemyEnterLOS(int unitId) {
+	POST_TO_WORKER(boost::bind(&CSkirmishAIWrapper::EnemyEnterLOS, this, unitId));
+
 	SEnemyEnterLOSEvent evtData = {unitId};
-	ai->HandleEvent(EVENT_ENEMY_ENTER_LOS, &evtData);
+	SendEvent(EVENT_ENEMY_ENTER_LOS, &evtData);
 }
 
 void CSkirmishAIWrapper::EnemyLeaveLOS(int unitId) {
+	POST_TO_WORKER(boost::bind(&CSkirmishAIWrapper::EnemyLeaveLOS, this, unitId));
+
 	SEnemyLeaveLOSEvent evtData = {unitId};
-	ai->HandleEvent(EVENT_ENEMY_LEAVE_LOS, &evtData);
+	SendEvent(EVENT_ENEMY_LEAVE_LOS, &evtData);
 }
 
 void CSkirmishAIWrapper::EnemyEnterRadar(int unitId) {
+	POST_TO_WORKER(boost::bind(&CSkirmishAIWrapper::EnemyEnterRadar, this, unitId));
+
 	SEnemyEnterRadarEvent evtData = {unitId};
-	ai->HandleEvent(EVENT_ENEMY_ENTER_RADAR, &evtData);
+	SendEvent(EVENT_ENEMY_ENTER_RADAR, &evtData);
 }
 
 void CSkirmishAIWrapper::EnemyLeaveRadar(int unitId) {
+	POST_TO_WORKER(boost::bind(&CSkirmishAIWrapper::EnemyLeaveRadar, this, unitId));
+
 	SEnemyLeaveRadarEvent evtData = {unitId};
-	ai->HandleEvent(EVENT_ENEMY_LEAVE_RADAR, &evtData);
+	SendEvent(EVENT_ENEMY_LEAVE_RADAR, &evtData);
 }
 
 void CSkirmishAIWrapper::EnemyDestroyed(int enemyUnitId, int attackerUnitId) {
+	POST_TO_WORKER(boost::bind(&CSkirmishAIWrapper::EnemyDestroyed, this, enemyUnitId, attackerUnitId));
+
 	SEnemyDestroyedEvent evtData = {enemyUnitId, attackerUnitId};
-	ai->HandleEvent(EVENT_ENEMY_DESTROYED, &evtData);
+	SendEvent(EVENT_ENEMY_DESTROYED, &evtData);
 }
 
 void CSkirmishAIWrapper::EnemyDamaged(int enemyUnitId, int attackerUnitId,
 		float damage, const float3& dir, int weaponDefId, bool paralyzer) {
+	POST_TO_WORKER(boost::bind(&CSkirmishAIWrapper::EnemyDamaged, this, enemyUnitId, attackerUnitId, damage, dir, weaponDefId, paralyzer));
+
+	float dir_posF3[3];
+	dir.copyInto(dir_posF3);
 
 	SEnemyDamagedEvent evtData = {enemyUnitId, attackerUnitId, damage,
-			new float[3], weaponDefId, paralyzer};
-	dir.copyInto(evtData.dir_posF3);
-	ai->HandleEvent(EVENT_ENEMY_DAMAGED, &evtData);
-	delete [] evtData.dir_posF3;
+			dir_posF3, weaponDefId, paralyzer};
+	SendEvent(EVENT_ENEMY_DAMAGED, &evtData);
 }
 
 void CSkirmishAIWrapper::Update(int frame) {
+	POST_TO_WORKER(boost::bind(&CSkirmishAIWrapper::Update, this, frame));
+
 	SUpdateEvent evtData = {frame};
-	ai->HandleEvent(EVENT_UPDATE, &evtData);
+	SendEvent(EVENT_UPDATE, &evtData);
 }
 
 void CSkirmishAIWrapper::SendChatMessage(const char* msg, int fromPlayerId) {
+	POST_TO_WORKER(boost::bind(&CSkirmishAIWrapper::SendChatMessageStr, this, std::string(msg), fromPlayerId));
+
 	SMessageEvent evtData = {fromPlayerId, msg};
-	ai->HandleEvent(EVENT_MESSAGE, &evtData);
+	SendEvent(EVENT_MESSAGE, &evtData);
 }
 
 void CSkirmishAIWrapper::SendLuaMessage(const char* inData, const char** outData) {
+	// outData is not supported yet, so this does not have to wait for the AI
+	POST_TO_WORKER(boost::bind(&CSkirmishAIWrapper::SendLuaMessageStr, this, std::string(inData)));
+
 	SLuaMessageEvent evtData = {inData /*outData*/};
-	ai->HandleEvent(EVENT_LUA_MESSAGE, &evtData);
+	SendEvent(EVENT_LUA_MESSAGE, &evtData);
+}
+
+void CSkirmishAIWrapper::SendChatMessageStr(const std::string& msg, int fromPlayerId) {
+	SendChatMessage(msg.c_str(), fromPlayerId);
+}
+
+void CSkirmishAIWrapper::SendLuaMessageStr(const std::string& inData) {
+	SendLuaMessage(inData.c_str(), NULL);
 }
 
 void CSkirmishAIWrapper::WeaponFired(int unitId, int weaponDefId) {
+	POST_TO_WORKER(boost::bind(&CSkirmishAIWrapper::WeaponFired, this, unitId, weaponDefId));
+
 	SWeaponFiredEvent evtData = {unitId, weaponDefId};
-	ai->HandleEvent(EVENT_WEAPON_FIRED, &evtData);
+	SendEvent(EVENT_WEAPON_FIRED, &evtData);
 }
 
 void CSkirmishAIWrapper::PlayerCommandGiven(
 		const std::vector<int>& selectedUnits, const Command& c, int playerId) {
+	POST_TO_WORKER(boost::bind(&CSkirmishAIWrapper::PlayerCommandGiven, this, selectedUnits, c, playerId));
 
+	// the event data is read-only for the AI
 	const int unitIds_size = selectedUnits.size();
-	int* unitIds = new int[unitIds_size];
-	for (int i = 0; i < unitIds_size; ++i) {
-		unitIds[i] = selectedUnits.at(i);
-	}
+	int* unitIds = (unitIds_size > 0)? const_cast<int*>(&selectedUnits[0]): NULL;
 	const int cCommandId = extractAICommandTopic(&c, uh->MaxUnits());
 
 	SPlayerCommandEvent evtData = {unitIds, unitIds_size, cCommandId, playerId};
-	ai->HandleEvent(EVENT_PLAYER_COMMAND, &evtData);
-	delete [] unitIds;
+	SendEvent(EVENT_PLAYER_COMMAND, &evtData);
 }
 
 void CSkirmishAIWrapper::CommandFinished(int unitId, int commandId, int commandTopicId) {
+	POST_TO_WORKER(boost::bind(&CSkirmishAIWrapper::CommandFinished, this, unitId, commandId, commandTopicId));
+
 	SCommandFinishedEvent evtData = {unitId, commandId, commandTopicId};
-	ai->HandleEvent(EVENT_COMMAND_FINISHED, &evtData);
+	SendEvent(EVENT_COMMAND_FINISHED, &evtData);
 }
 
 void CSkirmishAIWrapper::SeismicPing(int allyTeam, int unitId,
 		const float3& pos, float strength) {
+	POST_TO_WORKER(boost::bind(&CSkirmishAIWrapper::SeismicPing, this, allyTeam, unitId, pos, strength));
+
+	float pos_posF3[3];
+	pos.copyInto(pos_posF3);
 
-	SSeismicPingEvent evtData = {new float[3], strength};
-	pos.copyInto(evtData.pos_posF3);
-	ai->HandleEvent(EVENT_SEISMIC_PING, &evtData);
-	delete [] evtData.pos_posF3;
+	SSeismicPingEvent evtData = {pos_posF3, strength};
+	SendEvent(EVENT_SEISMIC_PING, &evtData);
 }
 
 
@@ -440,3 +539,198 @@ void CSkirmishAIWrapper::SetCheatEventsEnabled(bool enable) {
 bool CSkirmishAIWrapper::IsCheatEventsEnabled() const {
 	return cheatEvents;
 }
+
+void CSkirmishAIWrapper::SetEventBatchingEnabled(bool enable) {
+	// events batched so far are flushed with the next event
+	batchEvents = enable;
+}
+bool CSkirmishAIWrapper::IsEventBatchingEnabled() const {
+	return batchEvents;
+}
+
+
+void CSkirmishAIWrapper::SendEvent(int topic, const void* data) {
+
+	if (batchEvents && AddBatchEvent(topic, data))
+		return;
+
+	FlushEventBatch();
+	ai->HandleEvent(topic, data);
+}
+
+bool CSkirmishAIWrapper::AddBatchEvent(int topic, const void* data) {
+
+	int ints[BATCH_EVENT_INT_PARAMS] = {0};
+	float floats[BATCH_EVENT_FLOAT_PARAMS] = {0.0f};
+
+	// members in the order of the event structs, see SBatchEvent
+	switch (topic) {
+		case EVENT_UNIT_FINISHED:
+		case EVENT_UNIT_IDLE:
+		case EVENT_UNIT_MOVE_FAILED:
+		case EVENT_ENEMY_CREATED:
+		case EVENT_ENEMY_FINISHED:
+		case EVENT_ENEMY_ENTER_LOS:
+		case EVENT_ENEMY_LEAVE_LOS:
+		case EVENT_ENEMY_ENTER_RADAR:
+		case EVENT_ENEMY_LEAVE_RADAR: {
+			// all of these consist of the unit ID only
+			ints[0] = *static_cast<const int*>(data);
+		} break;
+		case EVENT_UNIT_CREATED: {
+			const SUnitCreatedEvent* evt = static_cast<const SUnitCreatedEvent*>(data);
+			ints[0] = evt->unit;
+			ints[1] = evt->builder;
+		} break;
+		case EVENT_UNIT_DESTROYED: {
+			const SUnitDestroyedEvent* evt = static_cast<const SUnitDestroyedEvent*>(data);
+			ints[0] = evt->unit;
+			ints[1] = evt->attacker;
+		} break;
+		case EVENT_ENEMY_DESTROYED: {
+			const SEnemyDestroyedEvent* evt = static_cast<const SEnemyDestroyedEvent*>(data);
+			ints[0] = evt->enemy;
+			ints[1] = evt->attacker;
+		} break;
+		case EVENT_UNIT_GIVEN:
+		case EVENT_UNIT_CAPTURED: {
+			// both have the same layout
+			const SUnitGivenEvent* evt = static_cast<const SUnitGivenEvent*>(data);
+			ints[0] = evt->unitId;
+			ints[1] = evt->oldTeamId;
+			ints[2] = evt->newTeamId;
+		} break;
+		case EVENT_UNIT_DAMAGED: {
+			const SUnitDamagedEvent* evt = static_cast<const SUnitDamagedEvent*>(data);
+			ints[0] = evt->unit;
+			ints[1] = evt->attacker;
+			ints[2] = evt->weaponDefId;
+			ints[3] = evt->paralyzer;
+			floats[0] = evt->damage;
+			floats[1] = evt->dir_posF3[0];
+			floats[2] = evt->dir_posF3[1];
+			floats[3] = evt->dir_posF3[2];
+		} break;
+		case EVENT_ENEMY_DAMAGED: {
+			const SEnemyDamagedEvent* evt = static_cast<const SEnemyDamagedEvent*>(data);
+			ints[0] = evt->enemy;
+			ints[1] = evt->attacker;
+			ints[2] = evt->weaponDefId;
+			ints[3] = evt->paralyzer;
+			floats[0] = evt->damage;
+			floats[1] = evt->dir_posF3[0];
+			floats[2] = evt->dir_posF3[1];
+			floats[3] = evt->dir_posF3[2];
+		} break;
+		case EVENT_WEAPON_FIRED: {
+			const SWeaponFiredEvent* evt = static_cast<const SWeaponFiredEvent*>(data);
+			ints[0] = evt->unitId;
+			ints[1] = evt->weaponDefId;
+		} break;
+		case EVENT_COMMAND_FINISHED: {
+			const SCommandFinishedEvent* evt = static_cast<const SCommandFinishedEvent*>(data);
+			ints[0] = evt->unitId;
+			ints[1] = evt->commandId;
+			ints[2] = evt->commandTopicId;
+		} break;
+		case EVENT_SEISMIC_PING: {
+			const SSeismicPingEvent* evt = static_cast<const SSeismicPingEvent*>(data);
+			floats[0] = evt->pos_posF3[0];
+			floats[1] = evt->pos_posF3[1];
+			floats[2] = evt->pos_posF3[2];
+			floats[3] = evt->strength;
+		} break;
+		default: {
+			return false;
+		}
+	}
+
+	batchTopics.push_back(topic);
+	batchIntParams.insert(batchIntParams.end(), ints, ints + BATCH_EVENT_INT_PARAMS);
+	batchFloatParams.insert(batchFloatParams.end(), floats, floats + BATCH_EVENT_FLOAT_PARAMS);
+	return true;
+}
+
+void CSkirmishAIWrapper::FlushEventBatch() {
+
+	if (batchTopics.empty())
+		return;
+
+	// the AI may cause new events while handling the batch (through cheats
+	// for example), those have to go into the next one
+	std::vector<int> topics;
+	std::vector<int> intParams;
+	std::vector<float> floatParams;
+
+	topics.swap(batchTopics);
+	intParams.swap(batchIntParams);
+	floatParams.swap(batchFloatParams);
+
+	SBatchEvent evtData = {
+		gs->frameNum,
+		&topics[0],
+		int(topics.size()),
+		&intParams[0],
+		int(intParams.size()),
+		&floatParams[0],
+		int(floatParams.size())
+	};
+	ai->HandleEvent(EVENT_BATCH, &evtData);
+
+	if (batchTopics.empty()) {
+		// keep the memory for the next batch
+		topics.clear();
+		intParams.clear();
+		floatParams.clear();
+
+		topics.swap(batchTopics);
+		intParams.swap(batchIntParams);
+		floatParams.swap(batchFloatParams);
+	}
+}
+
+
+bool CSkirmishAIWrapper::IsDeferred() const {
+	return (worker != NULL && CSkirmishAIWorker::GetCurrent() != worker);
+}
+
+void CSkirmishAIWrapper::CallOnWorker(const boost::function<void()>& call) {
+
+	if (!IsDeferred()) {
+		call();
+		return;
+	}
+
+	worker->Call(call);
+	// eg. AI commands given while loading
+	worker->SendQueuedPackets();
+}
+
+void CSkirmishAIWrapper::StartWorker() {
+
+	if (worker != NULL) {
+		worker->Start();
+	}
+}
+
+void CSkirmishAIWrapper::WaitForWorker() {
+
+	if (worker != NULL) {
+		worker->Wait();
+	}
+}
+
+void CSkirmishAIWrapper::FinishWorker() {
+
+	if (worker == NULL)
+		return;
+
+	worker->SendQueuedPackets();
+
+	// the profiler may only be used on this thread
+	if (ai != NULL) {
+		profiler.AddTime(ai->GetTimerName(), worker->GetAndResetTaskTime());
+	}
+
+	worker->RethrowError();
+}
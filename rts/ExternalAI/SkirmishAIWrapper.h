@@ -9,11 +9,14 @@
 
 #include <map>
 #include <string>
+#include <vector>
+#include <boost/function.hpp>
 
 class CAICallback;
 class CAICheats;
 struct SSkirmishAICallback;
 class CSkirmishAI;
+class CSkirmishAIWorker;
 struct Command;
 class float3;
 
@@ -75,6 +78,10 @@ public:
 	virtual void SetCheatEventsEnabled(bool enable);
 	virtual bool IsCheatEventsEnabled() const;
 
+	/// @see SBatchEvent in Interface/AISEvents.h
+	virtual void SetEventBatchingEnabled(bool enable);
+	virtual bool IsEventBatchingEnabled() const;
+
 	virtual void Init();
 	void Dieing();
 	/// @see SReleaseEvent in Interface/AISEvents.h
@@ -82,13 +89,45 @@ public:
 
 	int GetSkirmishAIID() const { return skirmishAIId; }
 
+	/**
+	 * Used by CEngineOutHandler::Update, if the AI runs on its own worker
+	 * thread (see SkirmishAIThreads); does nothing otherwise.
+	 * Start lets the worker handle the events queued since the last frame,
+	 * Wait blocks until it is done, and Finish sends the commands given by
+	 * the AI and rethrows its exceptions.
+	 */
+	void StartWorker();
+	void WaitForWorker();
+	void FinishWorker();
+
 private:
 	bool LoadSkirmishAI(bool postLoad);
 
+	void CreateWorker();
+	/// whether calls into the AI have to be passed on to its worker thread
+	bool IsDeferred() const;
+	/// runs the call on the worker thread, or directly, and waits for it
+	void CallOnWorker(const boost::function<void()>& call);
+	/// helpers for events with string data, which has to be copied
+	void SendChatMessageStr(const std::string& msg, int fromPlayerId);
+	void SendLuaMessageStr(const std::string& inData);
+	void DeleteAI();
+
+	/**
+	 * Sends an event to the AI, or adds it to the current batch, if batching
+	 * is enabled and the topic can be batched.
+	 * Before any event is sent, the current batch is flushed.
+	 */
+	void SendEvent(int topic, const void* data);
+	/// @return false if events of this topic can not be batched
+	bool AddBatchEvent(int topic, const void* data);
+	void FlushEventBatch();
+
 
 	int skirmishAIId;
 	int teamId;
 	bool cheatEvents;
+	bool batchEvents;
 
 	CSkirmishAI* ai;
 	bool initialized;
@@ -98,6 +137,14 @@ private:
 	SSkirmishAICallback* c_callback;
 	SkirmishAIKey key;
 	const struct InfoItem* info;
+
+	/// only if the AI runs on its own thread, see CSkirmishAIWorker
+	CSkirmishAIWorker* worker;
+
+	/// events not sent yet, in the layout of SBatchEvent (kept to reuse their memory)
+	std::vector<int> batchTopics;
+	std::vector<int> batchIntParams;
+	std::vector<float> batchFloatParams;
 };
 
 #endif // SKIRMISH_AI_WRAPPER_H
@@ -0,0 +1,191 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "DefsCache.h"
+
+#include "Game/GameVersion.h"
+#include "Lua/LuaParser.h"
+#include "System/CRC.h"
+#include "System/FileSystem/ArchiveScanner.h"
+#include "System/FileSystem/DataDirsAccess.h"
+#include "System/FileSystem/FileQueryFlags.h"
+#include "System/Log/ILog.h"
+
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+#include <vector>
+#include <boost/cstdint.hpp>
+
+#define LOG_SECTION_DEFS_CACHE "DefsCache"
+LOG_REGISTER_SECTION_GLOBAL(LOG_SECTION_DEFS_CACHE)
+
+// use the specific section for all LOG*() calls in this source file
+#ifdef LOG_SECTION_CURRENT
+	#undef LOG_SECTION_CURRENT
+#endif
+#define LOG_SECTION_CURRENT LOG_SECTION_DEFS_CACHE
+
+
+static const std::string DEFS_CACHE_DIR = "cache/defs/";
+static const char DEFS_CACHE_MAGIC[8] = {'S', 'p', 'r', 'D', 'e', 'f', 's', 'C'};
+/// increase when the serialized table format changes
+static const boost::uint32_t DEFS_CACHE_VERSION = 1;
+
+
+static void AppendOptions(std::ostringstream& key, const std::map<std::string, std::string>& options)
+{
+	key << options.size() << "\n";
+
+	std::map<std::string, std::string>::const_iterator it;
+	for (it = options.begin(); it != options.end(); ++it) {
+		key << it->first.size() << ":" << it->first << "=" << it->second.size() << ":" << it->second << "\n";
+	}
+}
+
+static unsigned int GetChecksum(const std::string& data)
+{
+	CRC crc;
+	crc.Update(data.data(), data.size());
+	return crc.GetDigest();
+}
+
+
+CDefsCache::CDefsCache(
+	const std::string& modArchive,
+	const std::string& mapArchive,
+	const std::map<std::string, std::string>& modOptions,
+	const std::map<std::string, std::string>& mapOptions)
+	: dataChecksum(0)
+{
+	std::ostringstream keyStream;
+	keyStream << DEFS_CACHE_VERSION << "\n";
+	keyStream << SpringVersion::GetSync() << "\n";
+	keyStream << modArchive << "\n" << archiveScanner->GetArchiveCompleteChecksum(modArchive) << "\n";
+	keyStream << mapArchive << "\n" << archiveScanner->GetArchiveCompleteChecksum(mapArchive) << "\n";
+	AppendOptions(keyStream, modOptions);
+	AppendOptions(keyStream, mapOptions);
+
+	key = keyStream.str();
+
+	char hashString[16];
+	sprintf(hashString, "%08x", GetChecksum(key));
+	fileName = DEFS_CACHE_DIR + hashString + ".bin";
+}
+
+
+bool CDefsCache::Load(LuaParser* parser)
+{
+	const std::string filePath = dataDirsAccess.LocateFile(fileName);
+
+	FILE* in = fopen(filePath.c_str(), "rb");
+	if (in == NULL) {
+		LOG("no cached defs for this setup (%s)", fileName.c_str());
+		return false;
+	}
+
+	std::vector<char> buffer;
+	char readBuffer[64 * 1024];
+	size_t numRead = 0;
+	while ((numRead = fread(readBuffer, 1, sizeof(readBuffer), in)) > 0) {
+		buffer.insert(buffer.end(), readBuffer, readBuffer + numRead);
+	}
+	fclose(in);
+
+	// header: magic, version, key, data checksum, data size
+	size_t pos = 0;
+	boost::uint32_t version = 0, keySize = 0, checksum = 0, dataSize = 0;
+
+	bool valid = (buffer.size() >= (sizeof(DEFS_CACHE_MAGIC) + 4 * sizeof(boost::uint32_t)));
+	valid = valid && (memcmp(&buffer[pos], DEFS_CACHE_MAGIC, sizeof(DEFS_CACHE_MAGIC)) == 0);
+	pos += sizeof(DEFS_CACHE_MAGIC);
+
+	if (valid) {
+		memcpy(&version, &buffer[pos], sizeof(version)); pos += sizeof(version);
+		memcpy(&keySize, &buffer[pos], sizeof(keySize)); pos += sizeof(keySize);
+		valid = (version == DEFS_CACHE_VERSION) && (keySize == key.size()) && ((pos + keySize + 2 * sizeof(boost::uint32_t)) <= buffer.size());
+	}
+	if (valid) {
+		// guards against (very unlikely) hash collisions of the file name
+		valid = (memcmp(&buffer[pos], key.data(), keySize) == 0);
+		pos += keySize;
+	}
+	if (valid) {
+		memcpy(&checksum, &buffer[pos], sizeof(checksum)); pos += sizeof(checksum);
+		memcpy(&dataSize, &buffer[pos], sizeof(dataSize)); pos += sizeof(dataSize);
+		valid = ((pos + dataSize) == buffer.size());
+	}
+	if (!valid) {
+		LOG_L(L_WARNING, "ignoring outdated or invalid defs cache %s", filePath.c_str());
+		return false;
+	}
+
+	const std::string data(&buffer[pos], dataSize);
+
+	if (GetChecksum(data) != checksum) {
+		LOG_L(L_WARNING, "ignoring corrupt defs cache %s", filePath.c_str());
+		return false;
+	}
+	if (!parser->LoadRootData(data)) {
+		LOG_L(L_WARNING, "ignoring defs cache %s: %s", filePath.c_str(), parser->GetErrorLog().c_str());
+		return false;
+	}
+
+	dataChecksum = checksum;
+
+	LOG("loaded defs from cache %s (%u bytes, checksum %08x)", fileName.c_str(), dataSize, dataChecksum);
+	return true;
+}
+
+
+void CDefsCache::Store(LuaParser* parser, bool writeFile)
+{
+	std::string data;
+
+	if (!parser->SaveRootData(data)) {
+		LOG_L(L_WARNING, "the defs can not be cached, they contain functions or similar");
+		dataChecksum = 0;
+		return;
+	}
+
+	dataChecksum = GetChecksum(data);
+
+	if (!writeFile) {
+		return;
+	}
+
+	// write to a temporary file first, so no half-written cache is ever read
+	const std::string filePath = dataDirsAccess.LocateFile(fileName, FileQueryFlags::WRITE | FileQueryFlags::CREATE_DIRS);
+	const std::string tmpFilePath = filePath + ".tmp";
+
+	FILE* out = fopen(tmpFilePath.c_str(), "wb");
+	if (out == NULL) {
+		LOG_L(L_WARNING, "failed to write defs cache %s", tmpFilePath.c_str());
+		return;
+	}
+
+	const boost::uint32_t version = DEFS_CACHE_VERSION;
+	const boost::uint32_t keySize = key.size();
+	const boost::uint32_t checksum = dataChecksum;
+	const boost::uint32_t dataSize = data.size();
+
+	bool good = (fwrite(DEFS_CACHE_MAGIC, sizeof(DEFS_CACHE_MAGIC), 1, out) == 1);
+	good = good && (fwrite(&version, sizeof(version), 1, out) == 1);
+	good = good && (fwrite(&keySize, sizeof(keySize), 1, out) == 1);
+	good = good && (fwrite(key.data(), keySize, 1, out) == 1);
+	good = good && (fwrite(&checksum, sizeof(checksum), 1, out) == 1);
+	good = good && (fwrite(&dataSize, sizeof(dataSize), 1, out) == 1);
+	good = good && (fwrite(data.data(), dataSize, 1, out) == 1);
+	good = (fclose(out) == 0) && good;
+
+#ifdef _WIN32
+	// rename() does not replace existing files on windows
+	remove(filePath.c_str());
+#endif
+	if (!good || (rename(tmpFilePath.c_str(), filePath.c_str()) != 0)) {
+		LOG_L(L_WARNING, "failed to write defs cache %s", filePath.c_str());
+		remove(tmpFilePath.c_str());
+		return;
+	}
+
+	LOG("cached defs in %s (%u bytes, checksum %08x)", fileName.c_str(), dataSize, dataChecksum);
+}
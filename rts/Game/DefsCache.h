@@ -0,0 +1,62 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef DEFS_CACHE_H
+#define DEFS_CACHE_H
+
+#include <map>
+#include <string>
+
+class LuaParser;
+
+/**
+ * Binary cache of the table returned by gamedata/defs.lua.
+ * Running the defs scripts loads and post-processes every unit, weapon,
+ * feature, armor and move definition file, which takes several seconds for
+ * big games. With the cache, later starts of the same setup rebuild the
+ * table directly, and the def handlers read it exactly as if the scripts
+ * had run.
+ *
+ * A cache file is only used if everything the scripts can see matches:
+ * the game and map archives (by checksum, including dependencies), the
+ * mod- and map-options and the engine sync version. The defs environment
+ * offers no other inputs (no random numbers, no time, no files outside the
+ * VFS), so the result is equal for all players, cached or not.
+ */
+class CDefsCache
+{
+public:
+	CDefsCache(
+		const std::string& modArchive,
+		const std::string& mapArchive,
+		const std::map<std::string, std::string>& modOptions,
+		const std::map<std::string, std::string>& mapOptions);
+
+	/**
+	 * Fills the (not yet executed) parser from the cache file.
+	 * @return false if there is no valid cache file for this setup
+	 */
+	bool Load(LuaParser* parser);
+
+	/**
+	 * Serializes the table of the executed parser to get its checksum,
+	 * and if writeFile is set, stores it in the cache file.
+	 */
+	void Store(LuaParser* parser, bool writeFile);
+
+	/**
+	 * Checksum over the canonical form of the defs table, which is equal
+	 * for cached and executed defs (0 if it could not be serialized).
+	 * Feeding it to the sync checker detects divergent defs right away.
+	 */
+	unsigned int GetDataChecksum() const { return dataChecksum; }
+
+private:
+	/// all inputs of the defs scripts, stored in the file for validation
+	std::string key;
+	/// relative to the write-dir, named by a hash of the key
+	std::string fileName;
+
+	unsigned int dataChecksum;
+};
+
+#endif // DEFS_CACHE_H
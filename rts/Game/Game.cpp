@@ -22,6 +22,7 @@
 #include "ClientSetup.h"
 #include "CommandMessage.h"
 #include "ConsoleHistory.h"
+#include "DefsCache.h"
 #include "GameHelper.h"
 #include "GameServer.h"
 #include "GameVersion.h"
@@ -154,6 +155,7 @@
 #include "System/Platform/Watchdog.h"
 #include "System/Sound/ISound.h"
 #include "System/Sound/SoundChannels.h"
+#include "System/Sync/SyncedPrimitive.h"
 #include "System/Sync/SyncedPrimitiveIO.h"
 #include "System/Sync/SyncTracer.h"
 #include "System/TimeProfiler.h"
@@ -168,6 +170,8 @@ extern gmlClientServer<void, int,CUnit*>* gmlProcessor;
 #endif
 
 
+CONFIG(bool, DefsCache).defaultValue(true).safemodeValue(false).description("Cache the unit-, weapon- and feature-definitions of each game setup, so gamedata/defs.lua does not need to run on the next start.");
+CONFIG(bool, PreloadModels).defaultValue(true).safemodeValue(false).description("Load the models of all unit-, weapon- and feature-definitions while loading the game (parsing them concurrently), instead of on first use.");
 CONFIG(bool, WindowedEdgeMove).defaultValue(true);
 CONFIG(bool, FullscreenEdgeMove).defaultValue(true);
 CONFIG(bool, ShowFPS).defaultValue(false);
@@ -485,10 +489,26 @@ void CGame::LoadDefs()
 		defsParser->AddFunc("GetMapOptions", LuaSyncedRead::GetMapOptions);
 		defsParser->EndTable();
 
-		// run the parser
-		if (!defsParser->Execute()) {
-			throw content_error("Defs-Parser: " + defsParser->GetErrorLog());
+		const bool useDefsCache = configHandler->GetBool("DefsCache");
+		CDefsCache defsCache(
+			archiveScanner->ArchiveFromName(gameSetup->modName),
+			archiveScanner->ArchiveFromName(gameSetup->mapName),
+			gameSetup->modOptions,
+			gameSetup->mapOptions);
+
+		if (!useDefsCache || !defsCache.Load(defsParser)) {
+			// run the parser
+			if (!defsParser->Execute()) {
+				throw content_error("Defs-Parser: " + defsParser->GetErrorLog());
+			}
+			// the checksum is needed even without cache, see below
+			defsCache.Store(defsParser, useDefsCache);
 		}
+
+		// all players must end up with the same defs, cached or not
+		LOG("[%s] defs checksum: %08x", __FUNCTION__, defsCache.GetDataChecksum());
+		{ SyncedUint tmp(defsCache.GetDataChecksum()); }
+
 		const LuaTable root = defsParser->GetRoot();
 		if (!root.IsValid()) {
 			throw content_error("Error loading gamedata definitions");
@@ -567,6 +587,12 @@ void CGame::PostLoadSimulation()
 	loadscreen->SetLoadMessage("Loading Feature Definitions");
 	featureHandler = new CFeatureHandler();
 
+	if (configHandler->GetBool("PreloadModels")) {
+		ScopedOnceTimer timer("Game::PostLoadSimulation (Models)");
+		loadscreen->SetLoadMessage("Loading Models");
+		PreloadModels();
+	}
+
 	loshandler = new CLosHandler();
 	radarhandler = new CRadarHandler(false);
 
@@ -608,6 +634,34 @@ void CGame::PreLoadRendering()
 	sky = ISky::GetSky();
 }
 
+void CGame::PreloadModels()
+{
+	// everything SolidObjectDef::LoadModel and WeaponDef::LoadModel
+	// would otherwise load on demand, one at a time
+	std::vector<std::string> modelNames;
+
+	for (std::vector<UnitDef*>::const_iterator it = unitDefHandler->unitDefs.begin(); it != unitDefHandler->unitDefs.end(); ++it) {
+		if ((*it) != NULL && !(*it)->modelName.empty()) {
+			modelNames.push_back((*it)->modelName);
+		}
+	}
+	for (std::vector<WeaponDef>::const_iterator it = weaponDefHandler->weaponDefs.begin(); it != weaponDefHandler->weaponDefs.end(); ++it) {
+		if (!it->visuals.modelName.empty()) {
+			modelNames.push_back(it->visuals.modelName);
+		}
+	}
+
+	const std::map<std::string, const FeatureDef*>& featureDefs = featureHandler->GetFeatureDefs();
+
+	for (std::map<std::string, const FeatureDef*>::const_iterator it = featureDefs.begin(); it != featureDefs.end(); ++it) {
+		if (!it->second->modelName.empty()) {
+			modelNames.push_back(it->second->modelName);
+		}
+	}
+
+	modelParser->PreloadModels(modelNames);
+}
+
 void CGame::PostLoadRendering() {
 	worldDrawer = new CWorldDrawer();
 }
@@ -910,6 +964,15 @@ bool CGame::Update()
 	if (gs->frameNum == 0 || gs->paused)
 		eventHandler.UpdateObjects(); // we must add new rendering objects even if the game has not started yet
 
+	// collect Lua garbage here instead of during call-ins, see LuaGCBudget*
+	{
+		SCOPED_TIMER("Lua GC");
+
+		if (luaUI != NULL) luaUI->CollectGarbage();
+		if (luaGaia != NULL) luaGaia->CollectGarbage();
+		if (luaRules != NULL) luaRules->CollectGarbage();
+	}
+
 	return true;
 }
 
@@ -1505,6 +1568,7 @@ void CGame::SimFrame() {
 	GUnitScriptEngine.Tick(33);
 	wind.Update();
 	loshandler->Update();
+	radarhandler->Update();
 	interceptHandler.Update(false);
 
 	teamHandler->GameFrame(gs->frameNum);
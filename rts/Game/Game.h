@@ -61,6 +61,7 @@ private:
 	void PreLoadSimulation(const std::string& mapName);
 	void PostLoadSimulation();
 	void PreLoadRendering();
+	void PreloadModels();
 	void PostLoadRendering();
 	void LoadInterface();
 	void LoadLua();
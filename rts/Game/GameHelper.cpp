@@ -55,14 +55,6 @@ CGameHelper::CGameHelper()
 CGameHelper::~CGameHelper()
 {
 	delete stdExplosionGenerator;
-
-	for (int a = 0; a < 128; ++a) {
-		std::list<WaitingDamage*>* wd = &waitingDamages[a];
-		while (!wd->empty()) {
-			delete wd->back();
-			wd->pop_back();
-		}
-	}
 }
 
 
@@ -71,6 +63,23 @@ CGameHelper::~CGameHelper()
 // Explosions/Damage
 //////////////////////////////////////////////////////////////////////
 
+int CGameHelper::AddWaitingDamageArray(const DamageArray& damages, const float damageMult)
+{
+	int damageIdx;
+
+	if (freeDamageArrayIndices.empty()) {
+		damageIdx = waitingDamageArrays.size();
+		waitingDamageArrays.push_back(damages);
+	} else {
+		damageIdx = freeDamageArrayIndices.back();
+		freeDamageArrayIndices.pop_back();
+		waitingDamageArrays[damageIdx] = damages;
+	}
+
+	waitingDamageArrays[damageIdx] *= damageMult;
+	return damageIdx;
+}
+
 void CGameHelper::DoExplosionDamage(
 	CUnit* unit,
 	CUnit* owner,
@@ -124,15 +133,14 @@ void CGameHelper::DoExplosionDamage(
 	const float3 impulseDir = (colVolPos - expPos).SafeNormalize();
 	const float3 expImpulse = impulseDir * modImpulseScale;
 
-	const DamageArray expDamages = damages * expMod;
-
 	if (expDist < (expSpeed * DIRECT_EXPLOSION_DAMAGE_SPEED_SCALE)) {
 		// damage directly
-		unit->DoDamage(expDamages, expImpulse, owner, weaponDefID);
+		unit->DoDamage(damages * expMod, expImpulse, owner, weaponDefID);
 	} else {
 		// damage later
-		WaitingDamage* wd = new WaitingDamage((owner? owner->id: -1), unit->id, expDamages, expImpulse, weaponDefID);
-		waitingDamages[(gs->frameNum + int(expDist / expSpeed) - 3) & 127].push_front(wd);
+		const int frameIdx = (gs->frameNum + int(expDist / expSpeed) - 3) & 127;
+		const int damageIdx = AddWaitingDamageArray(damages, expMod);
+		waitingDamages[frameIdx].push_back(WaitingDamage((owner? owner->id: -1), unit->id, damageIdx, expImpulse, weaponDefID));
 	}
 }
 
@@ -980,18 +988,23 @@ float3 CGameHelper::ClosestBuildSite(int team, const UnitDef* unitDef, float3 po
 
 void CGameHelper::Update()
 {
-	std::list<WaitingDamage*>* wd = &waitingDamages[gs->frameNum & 127];
+	std::vector<WaitingDamage>& wd = waitingDamages[gs->frameNum & 127];
+
+	// NOTE: DoDamage can queue new damages into this bucket,
+	// those are processed (in order) by the next iteration
+	while (!wd.empty()) {
+		processedDamages.swap(wd);
 
-	while (!wd->empty()) {
-		WaitingDamage* w = wd->back();
-		wd->pop_back();
+		for (std::vector<WaitingDamage>::const_iterator w = processedDamages.begin(); w != processedDamages.end(); ++w) {
+			CUnit* attackee = uh->units[w->target];
+			CUnit* attacker = (w->attacker == -1)? NULL: uh->units[w->attacker];
 
-		CUnit* attackee = uh->units[w->target];
-		CUnit* attacker = (w->attacker == -1)? NULL: uh->units[w->attacker];
+			if (attackee != NULL)
+				attackee->DoDamage(waitingDamageArrays[w->damageIdx], w->impulse, attacker, w->weaponId);
 
-		if (attackee != NULL)
-			attackee->DoDamage(w->damage, w->impulse, attacker, w->weaponId);
+			freeDamageArrayIndices.push_back(w->damageIdx);
+		}
 
-		delete w;
+		processedDamages.clear();
 	}
 }
@@ -6,9 +6,8 @@
 #include "Sim/Misc/DamageArray.h"
 #include "Sim/Projectiles/ExplosionListener.h"
 #include "System/float3.h"
-#include "System/MemPool.h"
 
-#include <list>
+#include <deque>
 #include <map>
 #include <vector>
 
@@ -109,36 +108,41 @@ public:
 private:
 	CStdExplosionGenerator* stdExplosionGenerator;
 
+	/// stores damages * damageMult in the pool, returns its index
+	int AddWaitingDamageArray(const DamageArray& damages, const float damageMult);
+
 	struct WaitingDamage{
-#if !defined(SYNCIFY)
-		inline void* operator new(size_t size) {
-			return mempool.Alloc(size);
-		};
-		inline void operator delete(void* p, size_t size) {
-			mempool.Free(p, size);
-		};
-#endif
-		WaitingDamage(int attacker, int target, const DamageArray& damage, const float3& impulse, const int weaponId)
+		WaitingDamage(int attacker, int target, int damageIdx, const float3& impulse, const int weaponId)
 			:	target(target),
 				attacker(attacker),
 				weaponId(weaponId),
-				damage(damage),
+				damageIdx(damageIdx),
 				impulse(impulse)
 		{}
 
 		int target;
 		int attacker;
 		int weaponId;
-		DamageArray damage;
+		int damageIdx; ///< into waitingDamageArrays
 		float3 impulse;
 	};
 
 	/**
-	 * probably a symptom of some other problems,
-	 * but im getting paranoid about putting whole classes
-	 * into high trafic STL containers instead of pointers to them
+	 * ring buffer of delayed explosion damages, one bucket per frame;
+	 * buckets keep their capacity so steady-state bombardments do not
+	 * allocate per damage entry
+	 */
+	std::vector<WaitingDamage> waitingDamages[128];
+	/// the bucket being processed by Update, swapped with the current one
+	std::vector<WaitingDamage> processedDamages;
+
+	/**
+	 * damages of the waiting entries; freed arrays are reused, so they
+	 * keep the capacity of their per-armor-type damages. A deque, as
+	 * DoDamage can add entries while Update refers to one of them.
 	 */
-	std::list<WaitingDamage*> waitingDamages[128];
+	std::deque<DamageArray> waitingDamageArrays;
+	std::vector<int> freeDamageArrayIndices;
 };
 
 extern CGameHelper* helper;
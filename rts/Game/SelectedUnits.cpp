@@ -926,7 +926,7 @@ void CSelectedUnits::SendCommand(const Command& c)
 		selectionChanged = false;
 	}
 
-	net->Send(CBaseNetProtocol::Get().SendCommand(gu->myPlayerNum, c.GetID(), c.options, c.params));
+	net->Send(CBaseNetProtocol::Get().SendCommand(gu->myPlayerNum, c.GetID(), c.options, c.params.begin(), c.params.size()));
 }
 
 
@@ -998,7 +998,9 @@ void CSelectedUnits::SendCommandsToUnits(const std::vector<int>& unitIDs, const
 			*packet << cmd.options;
 		if (sameCmdParamSize == 0xFFFF)
 			*packet << static_cast<unsigned short>(cmd.params.size());
-		*packet << cmd.params;
+		for (unsigned p = 0; p < cmd.params.size(); ++p) {
+			*packet << cmd.params[p];
+		}
 	}
 
 	net->Send(boost::shared_ptr<netcode::RawPacket>(packet));
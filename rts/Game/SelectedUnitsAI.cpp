@@ -11,7 +11,9 @@
 #include "Sim/Misc/GlobalSynced.h"
 #include "Sim/Misc/QuadField.h"
 #include "Sim/Misc/TeamHandler.h"
+#include "Sim/MoveTypes/MoveDefHandler.h"
 #include "Sim/MoveTypes/MoveType.h"
+#include "Sim/Path/IPathManager.h"
 #include "Sim/Units/UnitHandler.h"
 #include "Sim/Units/CommandAI/CommandAI.h"
 #include "Sim/Units/Unit.h"
@@ -23,6 +25,13 @@ const int CMDPARAM_MOVE_Y = 1;
 const int CMDPARAM_MOVE_Z = 2;
 
 
+/// half the size of the approximate square a group forms at a single goal position
+static inline float GroupSquareLength(int numUnits)
+{
+	return (100.0f + (math::sqrt((float)numUnits) * 32.0f));
+}
+
+
 // Global object
 CSelectedUnitsAI selectedUnitsAI;
 
@@ -176,7 +185,7 @@ void CSelectedUnitsAI::GiveCommandNet(Command &c, int player)
 		const float3 sideDir = frontdir.cross(UpVector);
 
 		// calculate so that the units form in an aproximate square
-		float length = 100.0f + (math::sqrt((float)nbrOfSelectedUnits) * 32.0f);
+		float length = GroupSquareLength(nbrOfSelectedUnits);
 
 		// push back some extra params so it confer with a front move
 		c.PushPos(pos + (sideDir * length));
@@ -226,6 +235,10 @@ void CSelectedUnitsAI::GiveCommandNet(Command &c, int player)
 		}
 	}
 	else {
+		if (((cmd_id == CMD_MOVE) || (cmd_id == CMD_FIGHT)) && (c.GetParamsCount() >= 3)) {
+			RequestGroupPaths(c, player, c.GetPos(0), GroupSquareLength(nbrOfSelectedUnits));
+		}
+
 		for (ui = netSelected.begin(); ui != netSelected.end(); ++ui) {
 			CUnit* unit = uh->units[*ui];
 			if (unit) {
@@ -315,6 +328,8 @@ void CSelectedUnitsAI::MakeFrontMove(Command* c,int player)
 	float3 nextPos(0.0f, 0.0f, 0.0f);//it's in "front" coordinates (rotated to real, moved by rightPos)
 
 	if(centerPos.distance(rightPos)<selectedUnits.netSelected[player].size()+33){	//Strange line! treat this as a standard move if the front isnt long enough
+		RequestGroupPaths(*c, player, centerPos, GroupSquareLength(selectedUnits.netSelected[player].size()));
+
 		for(std::vector<int>::iterator ui = selectedUnits.netSelected[player].begin(); ui != selectedUnits.netSelected[player].end(); ++ui) {
 			CUnit* unit=uh->units[*ui];
 			if(unit){
@@ -340,6 +355,10 @@ void CSelectedUnitsAI::MakeFrontMove(Command* c,int player)
 	if(numColumns==0)
 		numColumns=1;
 
+	// the rows of the formation extend backwards from the front
+	const int numRows = (int)math::ceil((sumLength * 2 * 8) / frontLength);
+	RequestGroupPaths(*c, player, centerPos, (frontLength * 0.5f) + (numRows * avgLength * 2 * 8));
+
 	std::multimap<float,int> orderedUnits;
 	CreateUnitOrder(orderedUnits,player);
 
@@ -397,6 +416,68 @@ void CSelectedUnitsAI::MakeFrontMove(Command* c,int player)
 }
 
 
+struct PathGroup {
+	PathGroup(): moveDef(NULL), center(ZeroVector), radius(0.0f), numUnits(0) {}
+
+	const MoveDef* moveDef;
+	float3 center;
+	float radius;
+	int numUnits;
+};
+
+//
+// Let the units of each path-type share one coarse path to the goal area,
+// instead of each of them searching nearly the same one. Has to be called
+// before the units get their orders, as they request their paths right away.
+//
+void CSelectedUnitsAI::RequestGroupPaths(const Command& c, int player, const float3& goalPos, float goalRadius)
+{
+	// queued orders are executed later, from other positions
+	if (c.options & SHIFT_KEY)
+		return;
+
+	const std::vector<int>& netSelected = selectedUnits.netSelected[player];
+	std::vector<int>::const_iterator ui;
+
+	std::map<int, PathGroup> groups;
+	std::map<int, PathGroup>::iterator gi;
+
+	for (ui = netSelected.begin(); ui != netSelected.end(); ++ui) {
+		const CUnit* unit = uh->units[*ui];
+		if (unit == NULL || unit->moveDef == NULL)
+			continue;
+
+		PathGroup& group = groups[unit->moveDef->pathType];
+		group.moveDef = unit->moveDef;
+		group.center += unit->pos;
+		group.numUnits += 1;
+	}
+
+	for (gi = groups.begin(); gi != groups.end(); ++gi) {
+		gi->second.center /= gi->second.numUnits;
+	}
+
+	for (ui = netSelected.begin(); ui != netSelected.end(); ++ui) {
+		const CUnit* unit = uh->units[*ui];
+		if (unit == NULL || unit->moveDef == NULL)
+			continue;
+
+		PathGroup& group = groups[unit->moveDef->pathType];
+		group.radius = std::max(group.radius, group.center.distance2D(unit->pos) + SQUARE_SIZE);
+	}
+
+	for (gi = groups.begin(); gi != groups.end(); ++gi) {
+		const PathGroup& group = gi->second;
+
+		// a single unit gains nothing from sharing its path
+		if (group.numUnits < 2)
+			continue;
+
+		pathManager->RequestGroupPath(group.moveDef, group.center, group.radius, goalPos, goalRadius);
+	}
+}
+
+
 void CSelectedUnitsAI::CreateUnitOrder(std::multimap<float,int>& out,int player)
 {
 	const vector<int>& netUnits = selectedUnits.netSelected[player];
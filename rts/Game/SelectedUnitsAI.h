@@ -33,6 +33,7 @@ public:
 private:
 	void CalculateGroupData(int player, bool queueing);
 	void MakeFrontMove(Command* c, int player);
+	void RequestGroupPaths(const Command& c, int player, const float3& goalPos, float goalRadius);
 	void CreateUnitOrder(std::multimap<float, int>& out, int player);
 	float3 MoveToPos(int unit, float3 nextCornerPos, float3 dir, Command* command, std::vector<std::pair<int, Command> >* frontcmds, bool* newline);
 	void AddUnitSetMaxSpeedCommand(CUnit* unit, unsigned char options);
@@ -4,6 +4,7 @@
 
 #include "ProfileDrawer.h"
 #include "System/TimeProfiler.h"
+#include "Lua/LuaMemPool.h"
 #include "Rendering/GL/myGL.h"
 #include "Rendering/glFont.h"
 #include "Rendering/GL/VertexArray.h"
@@ -82,6 +83,16 @@ void ProfileDrawer::Draw()
 		fStartX += 0.01f;
 		font->glFormat(fStartX, fStartY, 0.7f, FONT_BASELINE | FONT_SCALE | FONT_NORM, "%s", pi->first.c_str());
 	}
+
+	// print the memory used by all Lua states (if they use LuaMemPool)
+	const LuaMemPool::Stats luaMemStats = LuaMemPool::GetGlobalStats();
+	if (luaMemStats.numPools > 0) {
+		const float fStartY = end_y - profiler.profile.size() * 0.024f - 0.03f;
+		font->glFormat(start_x + 0.005f, fStartY, 0.7f, FONT_BASELINE | FONT_SCALE | FONT_NORM,
+				"Lua: %.1f MB in %u blocks, %.1f MB pooled, %u states",
+				luaMemStats.allocBytes / (1024.0f * 1024.0f), (unsigned int) luaMemStats.allocObjects,
+				luaMemStats.poolBytes / (1024.0f * 1024.0f), (unsigned int) luaMemStats.numPools);
+	}
 	font->End();
 
 	// draw the Timer selection boxes
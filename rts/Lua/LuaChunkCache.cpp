@@ -0,0 +1,326 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "LuaChunkCache.h"
+
+#include "LuaInclude.h"
+#include "Game/GameVersion.h"
+#include "System/CRC.h"
+#include "System/FileSystem/DataDirsAccess.h"
+#include "System/FileSystem/FileHandler.h"
+#include "System/FileSystem/FileQueryFlags.h"
+#include "System/FileSystem/VFSModes.h"
+#include "System/Log/ILog.h"
+
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <vector>
+#include <boost/cstdint.hpp>
+#include <boost/thread/mutex.hpp>
+
+#define LOG_SECTION_LUA_CHUNK_CACHE "LuaChunkCache"
+LOG_REGISTER_SECTION_GLOBAL(LOG_SECTION_LUA_CHUNK_CACHE)
+
+// use the specific section for all LOG*() calls in this source file
+#ifdef LOG_SECTION_CURRENT
+	#undef LOG_SECTION_CURRENT
+#endif
+#define LOG_SECTION_CURRENT LOG_SECTION_LUA_CHUNK_CACHE
+
+
+static const std::string CHUNK_CACHE_DIR = "cache/lua/";
+static const char CHUNK_CACHE_MAGIC[8] = {'S', 'p', 'r', 'L', 'u', 'a', 'C', 'C'};
+/// increase when the file format, or the bytecode of the bundled Lua, changes
+static const boost::uint32_t CHUNK_CACHE_VERSION = 2;
+/// sources and bytecode of all entries; when exceeded, the cache starts over
+static const size_t MAX_MEMORY_CACHE_SIZE = 64 * 1024 * 1024;
+
+
+namespace {
+	struct CachedChunk {
+		std::string source;
+		std::string bytecode;
+	};
+
+	typedef std::map<std::string, CachedChunk> ChunkMap;
+
+	ChunkMap cachedChunks;
+	size_t cachedChunksSize = 0;
+	bool enabled = false;
+	bool writeFailed = false;
+
+	boost::mutex cacheMutex;
+}
+
+
+static int ChunkWriter(lua_State* L, const void* p, size_t size, void* userData)
+{
+	static_cast<std::string*>(userData)->append(static_cast<const char*>(p), size);
+	return 0;
+}
+
+static unsigned int GetChecksum(const std::string& data)
+{
+	CRC crc;
+	crc.Update(data.data(), data.size());
+	return crc.GetDigest();
+}
+
+static std::string GetCacheFileName(const char* chunkName, const std::string& source)
+{
+	// bytecode is only valid for the Lua VM of the engine which made it
+	const std::string& engineVersion = SpringVersion::GetSync();
+
+	CRC crc;
+	crc.Update(engineVersion.c_str(), engineVersion.size() + 1);
+	crc.Update(chunkName, strlen(chunkName) + 1);
+	crc.Update(source.data(), source.size());
+
+	char hashString[16];
+	sprintf(hashString, "%08x", crc.GetDigest());
+	return (CHUNK_CACHE_DIR + hashString + ".luac");
+}
+
+
+static bool ReadString(const std::vector<char>& buffer, size_t& pos, std::string& str)
+{
+	boost::uint32_t size = 0;
+
+	if ((buffer.size() - pos) < sizeof(size))
+		return false;
+
+	memcpy(&size, &buffer[pos], sizeof(size));
+	pos += sizeof(size);
+
+	if ((buffer.size() - pos) < size)
+		return false;
+
+	str.assign(buffer.begin() + pos, buffer.begin() + pos + size);
+	pos += size;
+	return true;
+}
+
+static bool WriteString(FILE* out, const std::string& str)
+{
+	const boost::uint32_t size = str.size();
+
+	if (fwrite(&size, sizeof(size), 1, out) != 1)
+		return false;
+
+	return (size == 0 || fwrite(str.data(), size, 1, out) == 1);
+}
+
+
+/// layout: magic, version, engine version, chunk name, source, bytecode checksum, bytecode
+static bool LoadCacheFile(const char* chunkName, const std::string& source, std::string& bytecode)
+{
+	const std::string fileName = GetCacheFileName(chunkName, source);
+	const std::string filePath = dataDirsAccess.LocateFile(fileName);
+
+	FILE* in = fopen(filePath.c_str(), "rb");
+	if (in == NULL)
+		return false;
+
+	std::vector<char> buffer;
+	char readBuffer[64 * 1024];
+	size_t numRead = 0;
+	while ((numRead = fread(readBuffer, 1, sizeof(readBuffer), in)) > 0) {
+		buffer.insert(buffer.end(), readBuffer, readBuffer + numRead);
+	}
+	fclose(in);
+
+	size_t pos = 0;
+	boost::uint32_t version = 0, checksum = 0;
+	std::string fileEngineVersion, fileChunkName, fileSource;
+
+	bool valid = (buffer.size() >= (sizeof(CHUNK_CACHE_MAGIC) + sizeof(version)));
+	valid = valid && (memcmp(&buffer[0], CHUNK_CACHE_MAGIC, sizeof(CHUNK_CACHE_MAGIC)) == 0);
+	pos += sizeof(CHUNK_CACHE_MAGIC);
+
+	if (valid) {
+		memcpy(&version, &buffer[pos], sizeof(version)); pos += sizeof(version);
+		valid = (version == CHUNK_CACHE_VERSION);
+	}
+
+	// the complete source is compared, so (unlikely) hash collisions of
+	// the file name can never load the wrong code
+	valid = valid && ReadString(buffer, pos, fileEngineVersion) && (fileEngineVersion == SpringVersion::GetSync());
+	valid = valid && ReadString(buffer, pos, fileChunkName) && (fileChunkName == chunkName);
+	valid = valid && ReadString(buffer, pos, fileSource) && (fileSource == source);
+	valid = valid && ((buffer.size() - pos) >= sizeof(checksum));
+
+	if (valid) {
+		memcpy(&checksum, &buffer[pos], sizeof(checksum)); pos += sizeof(checksum);
+		valid = ReadString(buffer, pos, bytecode) && (pos == buffer.size());
+	}
+	if (!valid || (GetChecksum(bytecode) != checksum)) {
+		LOG_L(L_DEBUG, "ignoring outdated or invalid chunk cache %s for %s", fileName.c_str(), chunkName);
+		bytecode.clear();
+		return false;
+	}
+
+	return true;
+}
+
+static void StoreCacheFile(const char* chunkName, const std::string& source, const std::string& bytecode)
+{
+	if (writeFailed)
+		return;
+
+	// write to a temporary file first, so no half-written cache is ever read
+	const std::string fileName = GetCacheFileName(chunkName, source);
+	const std::string filePath = dataDirsAccess.LocateFile(fileName, FileQueryFlags::WRITE | FileQueryFlags::CREATE_DIRS);
+	const std::string tmpFilePath = filePath + ".tmp";
+
+	FILE* out = fopen(tmpFilePath.c_str(), "wb");
+	bool good = (out != NULL);
+
+	if (good) {
+		const boost::uint32_t version = CHUNK_CACHE_VERSION;
+		const boost::uint32_t checksum = GetChecksum(bytecode);
+
+		good = good && (fwrite(CHUNK_CACHE_MAGIC, sizeof(CHUNK_CACHE_MAGIC), 1, out) == 1);
+		good = good && (fwrite(&version, sizeof(version), 1, out) == 1);
+		good = good && WriteString(out, SpringVersion::GetSync());
+		good = good && WriteString(out, chunkName);
+		good = good && WriteString(out, source);
+		good = good && (fwrite(&checksum, sizeof(checksum), 1, out) == 1);
+		good = good && WriteString(out, bytecode);
+		good = (fclose(out) == 0) && good;
+
+	#ifdef _WIN32
+		// rename() does not replace existing files on windows
+		remove(filePath.c_str());
+	#endif
+		good = good && (rename(tmpFilePath.c_str(), filePath.c_str()) == 0);
+	}
+
+	if (!good) {
+		// do not retry for every chunk, the cache dir is probably not writable
+		LOG_L(L_WARNING, "failed to write chunk cache %s, only caching in memory", filePath.c_str());
+		remove(tmpFilePath.c_str());
+		writeFailed = true;
+	}
+}
+
+
+static void AddToMemoryCache(const char* chunkName, const std::string& source, const std::string& bytecode)
+{
+	if ((cachedChunksSize + source.size() + bytecode.size()) > MAX_MEMORY_CACHE_SIZE) {
+		cachedChunks.clear();
+		cachedChunksSize = 0;
+	}
+
+	CachedChunk& chunk = cachedChunks[chunkName];
+
+	cachedChunksSize -= (chunk.source.size() + chunk.bytecode.size());
+	cachedChunksSize += (source.size() + bytecode.size());
+
+	chunk.source = source;
+	chunk.bytecode = bytecode;
+}
+
+
+void CLuaChunkCache::SetEnabled(bool enable)
+{
+	boost::mutex::scoped_lock lock(cacheMutex);
+
+	enabled = enable;
+	writeFailed = false;
+}
+
+bool CLuaChunkCache::IsEnabled()
+{
+	return enabled;
+}
+
+void CLuaChunkCache::Clear()
+{
+	boost::mutex::scoped_lock lock(cacheMutex);
+
+	cachedChunks.clear();
+	cachedChunksSize = 0;
+}
+
+
+int CLuaChunkCache::LoadBuffer(lua_State* L, const char* buf, size_t size, const char* chunkName)
+{
+	// precompiled chunks are left to lua_load (as is everything if disabled)
+	if (!enabled || (chunkName == NULL) || (size == 0) || (buf[0] == LUA_SIGNATURE[0]))
+		return luaL_loadbuffer(L, buf, size, chunkName);
+
+	const std::string source(buf, size);
+	std::string bytecode;
+
+	{
+		boost::mutex::scoped_lock lock(cacheMutex);
+
+		const ChunkMap::const_iterator it = cachedChunks.find(chunkName);
+
+		if (it != cachedChunks.end() && it->second.source == source) {
+			bytecode = it->second.bytecode;
+		} else if (LoadCacheFile(chunkName, source, bytecode)) {
+			AddToMemoryCache(chunkName, source, bytecode);
+		}
+	}
+
+	if (!bytecode.empty()) {
+		if (luaL_loadbuffer(L, bytecode.data(), bytecode.size(), chunkName) == 0)
+			return 0;
+
+		// should not happen, the bytecode was verified; compile it again
+		LOG_L(L_WARNING, "failed to load cached chunk %s: %s", chunkName, lua_tostring(L, -1));
+		lua_pop(L, 1);
+	}
+
+	const int error = luaL_loadbuffer(L, buf, size, chunkName);
+
+	if (error != 0)
+		return error;
+
+	bytecode.clear();
+
+	if (lua_dump(L, ChunkWriter, &bytecode) != 0 || bytecode.empty())
+		return 0;
+
+	{
+		boost::mutex::scoped_lock lock(cacheMutex);
+
+		AddToMemoryCache(chunkName, source, bytecode);
+		StoreCacheFile(chunkName, source, bytecode);
+	}
+
+	return 0;
+}
+
+
+bool CLuaChunkCache::IsCacheableChunkName(const char* str, const char* chunkName)
+{
+	if (!enabled || (chunkName == str))
+		return false;
+
+	return CFileHandler::FileExists(chunkName, SPRING_VFS_ALL);
+}
+
+int CLuaChunkCache::LoadString(lua_State* L)
+{
+	size_t len;
+	const char* str = luaL_checklstring(L, 1, &len);
+	const char* chunkName = luaL_optstring(L, 2, str);
+
+	int status = 0;
+
+	if (IsCacheableChunkName(str, chunkName)) {
+		status = LoadBuffer(L, str, len, chunkName);
+	} else {
+		status = luaL_loadbuffer(L, str, len, chunkName);
+	}
+
+	if (status != 0) {
+		lua_pushnil(L);
+		lua_insert(L, -2);
+		return 2; // nil, then the error message
+	}
+
+	return 1;
+}
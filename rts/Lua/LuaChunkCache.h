@@ -0,0 +1,61 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef LUA_CHUNK_CACHE_H
+#define LUA_CHUNK_CACHE_H
+
+#include <string>
+
+struct lua_State;
+
+/**
+ * Cache of compiled Lua chunks.
+ * Reloading LuaRules or LuaUI compiles every gadget and widget again, which
+ * for big games takes several seconds. With the cache enabled, a chunk is
+ * only compiled the first time its source is seen; afterwards its bytecode
+ * (as written by lua_dump) is loaded instead, from memory or from a file in
+ * the cache dir, which also makes it survive restarts of the engine.
+ *
+ * Entries are keyed by chunk name and verified against the complete source
+ * text, so a changed file is always compiled again, and the loaded function
+ * behaves exactly like a freshly compiled one (including debug info).
+ * The cache only ever loads bytecode it produced itself; precompiled chunks
+ * passed in by the caller are handed to luaL_loadbuffer unchanged.
+ */
+class CLuaChunkCache
+{
+public:
+	/**
+	 * Disabled by default, so tools sharing the Lua code (unitsync,
+	 * the dedicated server) behave as before; the engine enables it
+	 * according to the LuaChunkCache config variable.
+	 */
+	static void SetEnabled(bool enable);
+	static bool IsEnabled();
+
+	/**
+	 * Drop-in replacement for luaL_loadbuffer, see the class description.
+	 * @return 0 and the chunk on the stack, or the lua_load error code and
+	 *   the error message on the stack
+	 */
+	static int LoadBuffer(lua_State* L, const char* buf, size_t size, const char* chunkName);
+	static int LoadBuffer(lua_State* L, const std::string& code, const std::string& chunkName) {
+		return LoadBuffer(L, code.data(), code.size(), chunkName.c_str());
+	}
+
+	/**
+	 * Replacement for the base library loadstring(str [, chunkname]).
+	 * As loadstring is also used for short-lived generated code, only
+	 * strings which are explicitly named after an existing VFS file
+	 * (gadget- and widget-handlers load their files like this) go through
+	 * the cache.
+	 */
+	static int LoadString(lua_State* L);
+
+	/// Whether loadstring(str, chunkName) should use the cache
+	static bool IsCacheableChunkName(const char* str, const char* chunkName);
+
+	/// Drops all in-memory entries (the files in the cache dir are kept)
+	static void Clear();
+};
+
+#endif // LUA_CHUNK_CACHE_H
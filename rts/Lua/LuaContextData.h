@@ -19,7 +19,8 @@ class CLuaHandle;
 struct luaContextData {
 	luaContextData() : fullCtrl(false), fullRead(false), ctrlTeam(CEventClient::NoAccessTeam),
 		readTeam(0), readAllyTeam(0), selectTeam(CEventClient::NoAccessTeam), synced(false),
-		owner(NULL), drawingEnabled(false), running(0), listMode(false) {}
+		owner(NULL), drawingEnabled(false), running(0), listMode(false),
+		gcCycleRunning(false), gcMemAfterCycle(0) {}
 	bool fullCtrl;
 	bool fullRead;
 	int  ctrlTeam;
@@ -39,6 +40,8 @@ struct luaContextData {
 	int running; //< is currently running? (0: not running; >0: is running)
 	MatrixStateData matrixData; // [>0] = stack depth for mode, [0] = matrix mode
 	bool listMode; // if creating display list
+	bool gcCycleRunning; // if CLuaHandle::CollectGarbage has started a GC cycle that is not finished yet
+	int gcMemAfterCycle; // memory use in KB after the last finished GC cycle
 
 	MatrixStateData PushMatrixState() {
 		MatrixStateData md;
@@ -22,6 +22,7 @@
 #include "Sim/Units/Unit.h"
 #include "Sim/Units/UnitDef.h"
 #include "Sim/Units/CommandAI/Command.h"
+#include "System/Config/ConfigHandler.h"
 #include "System/FileSystem/FileHandler.h"
 #include "System/FileSystem/FileSystem.h"
 #include "System/Util.h"
@@ -70,6 +71,7 @@ CLuaGaia::CLuaGaia()
 	}
 
 	teamsLocked = true;
+	SetGCBudget(configHandler->GetFloat("LuaGCBudgetGaia"));
 
 	SetFullCtrl(true, true);
 	SetFullRead(true, true);
@@ -7,6 +7,8 @@
 #include "LuaUI.h"
 
 #include "LuaCallInCheck.h"
+#include "LuaChunkCache.h"
+#include "LuaMemPool.h"
 #include "LuaHashString.h"
 #include "LuaOpenGL.h"
 #include "LuaBitOps.h"
@@ -45,13 +47,30 @@
 #include <SDL_mouse.h>
 #include <SDL_timer.h>
 
+#include <algorithm>
 #include <string>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
 
 
 bool CLuaHandle::devMode = false;
 bool CLuaHandle::modUICtrl = true;
 bool CLuaHandle::useDualStates = false;
 
+/// KB of allocations per incremental GC step (see LUA_GCSTEP)
+static const int GC_STEP_SIZE = 16;
+/// see StepGarbageCollector, 2 is the default pause of the regular collector
+static const int GC_PAUSE_FACTOR = 2;
+/// see NeedsCallInGC
+static const int GC_FALLBACK_FACTOR = 4;
+static const int GC_FALLBACK_MIN_MEM = 16 * 1024;
+
+CONFIG(bool, LuaMemPool).defaultValue(true).safemodeValue(false).description("Allocate the memory of Lua states from pools, instead of the system allocator.");
+CONFIG(int, LuaMemSoftLimit).defaultValue(0).minimumValue(0).description("Memory use in MB of an unsynced Lua state (LuaUI), above which a full garbage collection is done after the current call-in (0 = no limit). Requires LuaMemPool.");
+CONFIG(int, LuaMemHardLimit).defaultValue(0).minimumValue(0).description("Memory use in MB of an unsynced Lua state (LuaUI), above which allocations in call-ins fail with a Lua error (0 = no limit). Requires LuaMemPool.");
+CONFIG(float, LuaGCBudgetUI).defaultValue(1.0f).minimumValue(0.0f).description("Time in ms per game update for incremental garbage collection of LuaUI; 0 collects during call-ins instead.");
+CONFIG(float, LuaGCBudgetRules).defaultValue(1.0f).minimumValue(0.0f).description("Time in ms per game update for incremental garbage collection of the unsynced LuaRules state (with separate synced and unsynced states only); 0 collects during call-ins instead. The synced state always collects during call-ins.");
+CONFIG(float, LuaGCBudgetGaia).defaultValue(0.5f).minimumValue(0.0f).description("Time in ms per game update for incremental garbage collection of the unsynced LuaGaia state (with separate synced and unsynced states only); 0 collects during call-ins instead. The synced state always collects during call-ins.");
+
 
 /******************************************************************************/
 /******************************************************************************/
@@ -66,15 +85,30 @@ CLuaHandle::CLuaHandle(const string& _name, int _order, bool _userMode)
 	, printTracebacks(false)
 #endif
 	, callinErrors(0)
+	, gcBudget(0.0f)
 {
 	UpdateThreading();
 
 	SetSynced(false, true);
-	D_Sim.owner = this;
-	L_Sim = LUA_OPEN(&D_Sim, GetUserMode(), true);
+	if (configHandler->GetBool("LuaMemPool")) {
+		LuaMemPool* poolSim = new LuaMemPool();
+		LuaMemPool* poolDraw = new LuaMemPool();
+		const size_t softLimit = size_t(configHandler->GetInt("LuaMemSoftLimit")) * 1024 * 1024;
+		const size_t hardLimit = size_t(configHandler->GetInt("LuaMemHardLimit")) * 1024 * 1024;
+		poolSim->SetLimits(softLimit, hardLimit);
+		poolDraw->SetLimits(softLimit, hardLimit);
+
+		D_Sim.owner = this;
+		L_Sim = LUA_OPEN(&D_Sim, GetUserMode(), true, LuaMemPool::Alloc, poolSim);
+		D_Draw.owner = this;
+		L_Draw = LUA_OPEN(&D_Draw, GetUserMode(), false, LuaMemPool::Alloc, poolDraw);
+	} else {
+		D_Sim.owner = this;
+		L_Sim = LUA_OPEN(&D_Sim, GetUserMode(), true);
+		D_Draw.owner = this;
+		L_Draw = LUA_OPEN(&D_Draw, GetUserMode(), false);
+	}
 	LUA_OPEN_LIB(L_Sim, luaopen_debug);
-	D_Draw.owner = this;
-	L_Draw = LUA_OPEN(&D_Draw, GetUserMode(), false);
 	LUA_OPEN_LIB(L_Draw, luaopen_debug);
 }
 
@@ -114,7 +148,9 @@ void CLuaHandle::KillLua()
 		lua_State* L_Old = L_Sim;
 		L_Sim = L_Draw;
 		SetRunning(L_Draw, true);
+		LuaMemPool* memPool = GetMemPool(L_Draw);
 		LUA_CLOSE(L_Draw);
+		delete memPool;
 		//SetRunning(L_Draw, false); --nope, the state is deleted
 		L_Draw = NULL;
 		L_Sim = L_Old;
@@ -123,7 +159,9 @@ void CLuaHandle::KillLua()
 		lua_State* L_Old = L_Draw;
 		L_Draw = L_Sim;
 		SetRunning(L_Sim, true);
+		LuaMemPool* memPool = GetMemPool(L_Sim);
 		LUA_CLOSE(L_Sim);
+		delete memPool;
 		//SetRunning(L_Sim, false); --nope, the state is deleted
 		L_Sim = NULL;
 		L_Draw = L_Old;
@@ -131,6 +169,146 @@ void CLuaHandle::KillLua()
 }
 
 
+LuaMemPool* CLuaHandle::GetMemPool(lua_State* L)
+{
+	void* allocData = NULL;
+
+	if (lua_getallocf(L, &allocData) != LuaMemPool::Alloc)
+		return NULL;
+
+	return static_cast<LuaMemPool*>(allocData);
+}
+
+
+void CLuaHandle::GetMemUsage(size_t& allocBytes, size_t& allocObjects) const
+{
+	allocBytes = 0;
+	allocObjects = 0;
+
+	const lua_State* states[2] = {L_Sim, L_Draw};
+
+	for (int i = 0; i < 2; ++i) {
+		if (states[i] == NULL || (i == 1 && states[1] == states[0]))
+			continue;
+
+		const LuaMemPool* memPool = GetMemPool(const_cast<lua_State*>(states[i]));
+
+		if (memPool == NULL)
+			continue;
+
+		allocBytes += memPool->GetStats().allocBytes;
+		allocObjects += memPool->GetStats().allocObjects;
+	}
+}
+
+
+void CLuaHandle::ClearMemLimits()
+{
+	lua_State* states[2] = {L_Sim, L_Draw};
+
+	for (int i = 0; i < 2; ++i) {
+		LuaMemPool* memPool = (states[i] != NULL) ? GetMemPool(states[i]) : NULL;
+
+		if (memPool != NULL) {
+			memPool->SetLimits(0, 0);
+		}
+	}
+}
+
+
+void CLuaHandle::CheckMemSoftLimit(lua_State* L)
+{
+	LuaMemPool* memPool = GetMemPool(L);
+
+	if (memPool == NULL || !memPool->NeedsCollect())
+		return;
+
+	// works whether the collector is stopped or not (see NeedsCallInGC)
+	lua_gc(L, LUA_GCCOLLECT, 0);
+	memPool->Collected();
+
+	L->lcd->gcCycleRunning = false;
+	L->lcd->gcMemAfterCycle = lua_gc(L, LUA_GCCOUNT, 0);
+
+	if (memPool->GetStats().allocBytes > memPool->GetSoftLimit()) {
+		LOG_L(L_WARNING, "%s: Lua state uses %.1f MB after a full garbage collection (LuaMemSoftLimit: %.1f MB)",
+				GetName().c_str(),
+				memPool->GetStats().allocBytes / (1024.0f * 1024.0f),
+				memPool->GetSoftLimit() / (1024.0f * 1024.0f));
+	}
+}
+
+
+bool CLuaHandle::NeedsCallInGC(lua_State* L) const
+{
+	if (gcBudget <= 0.0f)
+		return true;
+
+	// a time budget would make the collection progress (and so weak tables
+	// and collectgarbage("count")) differ between clients, synced states
+	// keep collecting during call-ins, driven by their allocations only
+	if (IsSyncedState(L))
+		return true;
+
+	// CollectGarbage is not called while loading, and its budget might not
+	// keep up with the allocations of the call-ins, so fall back to the
+	// regular collector when the memory use grows too much
+	const int memLimit = std::max(L->lcd->gcMemAfterCycle * GC_FALLBACK_FACTOR, GC_FALLBACK_MIN_MEM);
+
+	return (lua_gc(L, LUA_GCCOUNT, 0) > memLimit);
+}
+
+
+static void StepGarbageCollector(lua_State* L, const boost::posix_time::ptime& endTime)
+{
+	luaContextData* lcd = L->lcd;
+
+	// like the regular collector, do not start a new cycle before the memory
+	// use has grown enough since the last one
+	if (!lcd->gcCycleRunning && lua_gc(L, LUA_GCCOUNT, 0) < (lcd->gcMemAfterCycle * GC_PAUSE_FACTOR))
+		return;
+
+	lcd->gcCycleRunning = true;
+
+	do {
+		if (lua_gc(L, LUA_GCSTEP, GC_STEP_SIZE) != 0) {
+			lcd->gcCycleRunning = false;
+			lcd->gcMemAfterCycle = lua_gc(L, LUA_GCCOUNT, 0);
+			break;
+		}
+	} while (boost::posix_time::microsec_clock::universal_time() < endTime);
+
+	// stepping restarts the collector, stop it again (see RunCallInTraceback)
+	lua_gc(L, LUA_GCSTOP, 0);
+}
+
+
+void CLuaHandle::CollectGarbage()
+{
+	if (gcBudget <= 0.0f || !IsValid())
+		return;
+
+	GML_DRCMUTEX_LOCK(lua); // CollectGarbage
+
+	const boost::posix_time::ptime startTime = boost::posix_time::microsec_clock::universal_time();
+	const boost::posix_time::time_duration budget = boost::posix_time::microseconds(int(gcBudget * 1000.0f));
+
+	// synced states are not collected here, see NeedsCallInGC
+	lua_State* states[2];
+	int numStates = 0;
+
+	if (!IsSyncedState(L_Sim))
+		states[numStates++] = L_Sim;
+	if (L_Draw != L_Sim && !IsSyncedState(L_Draw))
+		states[numStates++] = L_Draw;
+
+	// a later state also gets what the earlier one did not need
+	for (int i = 0; i < numStates; ++i) {
+		StepGarbageCollector(states[i], startTime + (budget * (i + 1)) / numStates);
+	}
+}
+
+
 /******************************************************************************/
 /******************************************************************************/
 
@@ -191,9 +369,11 @@ bool CLuaHandle::LoadCode(lua_State *L, const string& code, const string& debug)
 	int callError = 0;
 	bool ret = true;
 
-	if ((loadError = luaL_loadbuffer(L, code.c_str(), code.size(), debug.c_str())) == 0) {
+	if ((loadError = CLuaChunkCache::LoadBuffer(L, code, debug)) == 0) {
 		SetRunning(L, true);
 
+		LuaMemPool::ProtectedScope memLimitScope(GetMemPool(L));
+
 		if ((callError = lua_pcall(L, 0, 0, 0)) != 0) {
 			LOG_L(L_ERROR, "Lua LoadCode pcall error = %i, %s, %s", loadError, debug.c_str(), lua_tostring(L, -1));
 			lua_pop(L, 1);
@@ -415,12 +595,21 @@ int CLuaHandle::RunCallInTraceback(const LuaHashString* hs, int inArgs, int outA
 	SELECT_LUA_STATE();
 	SetRunning(L, true);
 	// disable GC outside of this scope to prevent sync errors and similar
-	lua_gc(L, LUA_GCRESTART, 0);
+	// (with a GC budget, it runs in CollectGarbage instead, see NeedsCallInGC)
+	if (NeedsCallInGC(L))
+		lua_gc(L, LUA_GCRESTART, 0);
 	MatrixStateData prevMSD = L->lcd->PushMatrixState();
 	LuaOpenGL::InitMatrixState(L, hs);
-	const int error = lua_pcall(L, inArgs, outArgs, errfuncIndex);
+	int error = 0;
+	{
+		// the arguments were pushed outside of the limit, as failing
+		// allocations there would not be caught
+		LuaMemPool::ProtectedScope memLimitScope(GetMemPool(L));
+		error = lua_pcall(L, inArgs, outArgs, errfuncIndex);
+	}
 	LuaOpenGL::CheckMatrixState(L, hs, error);
 	L->lcd->PopMatrixState(prevMSD);
+	CheckMemSoftLimit(L);
 	lua_gc(L, LUA_GCSTOP, 0);
 
 	SetRunning(L, false);
@@ -944,7 +1133,7 @@ void CLuaHandle::UnitCommand(const CUnit* unit, const Command& command)
 	lua_pushnumber(L, command.GetID());
 	lua_pushnumber(L, command.options);
 
-	const vector<float> &params = command.params;
+	const CommandParams& params = command.params;
 	lua_createtable(L, params.size(), 0);
 	for (unsigned int i = 0; i < params.size(); i++) {
 		lua_pushnumber(L, i + 1);
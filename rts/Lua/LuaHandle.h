@@ -36,6 +36,7 @@ using std::set;
 
 class CUnit;
 class CWeapon;
+class LuaMemPool;
 class CFeature;
 class CProjectile;
 struct Command;
@@ -275,12 +276,44 @@ class CLuaHandle : public CEventClient
 
 		void UpdateThreading();
 
+		/// live bytes and blocks in the Lua states of this handle (0 without LuaMemPool)
+		void GetMemUsage(size_t& allocBytes, size_t& allocObjects) const;
+		/// the pool the state allocates from, or NULL
+		static LuaMemPool* GetMemPool(lua_State* L);
+
+		/**
+		 * Runs incremental garbage collection steps on the unsynced Lua states of
+		 * this handle, for at most the GC budget.
+		 * Called once per CGame::Update, so collection pauses do not land
+		 * in (time critical) call-ins.
+		 */
+		void CollectGarbage();
+
 	protected:
 		CLuaHandle(const string& name, int order, bool userMode);
 		virtual ~CLuaHandle();
 
 		void KillLua();
 
+		/**
+		 * Failing allocations, and garbage collections that depend on the
+		 * (client-specific) limits and memory use, would make synced code
+		 * client-dependent.
+		 */
+		void ClearMemLimits();
+		/// runs a full garbage collection if the state exceeds its soft limit
+		void CheckMemSoftLimit(lua_State* L);
+
+		/**
+		 * @param budget time in ms per CollectGarbage call;
+		 *   with 0, the collector runs during call-ins instead
+		 */
+		void SetGCBudget(float budget) { gcBudget = budget; }
+		/// whether the collector has to run during call-ins
+		bool NeedsCallInGC(lua_State* L) const;
+		/// whether L runs synced code (the only state of a synced handle, or its L_Sim)
+		bool IsSyncedState(const lua_State* L) const { return (!userMode && (SingleState() || L == L_Sim)); }
+
 		bool AddBasicCalls(lua_State* L);
 		bool LoadCode(lua_State* L, const string& code, const string& debug);
 		bool AddEntriesToTable(lua_State* L, const char* name, bool (*entriesFunc)(lua_State*));
@@ -348,6 +381,8 @@ class CLuaHandle : public CEventClient
 
 		int callinErrors;
 
+		float gcBudget;
+
 	protected: // call-outs
 		static int KillActiveHandle(lua_State* L);
 		static int CallOutGetName(lua_State* L);
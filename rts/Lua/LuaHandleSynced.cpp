@@ -10,6 +10,7 @@
 #include "LuaInclude.h"
 
 #include "LuaCallInCheck.h"
+#include "LuaChunkCache.h"
 #include "LuaUtils.h"
 #include "LuaConstGL.h"
 #include "LuaConstCMD.h"
@@ -67,6 +68,7 @@ CLuaHandleSynced::CLuaHandleSynced(const string& _name, int _order)
 	UpdateThreading();
 	SetAllowChanges(false, true);
 	printTracebacks = true;
+	ClearMemLimits();
 }
 
 
@@ -523,7 +525,7 @@ bool CLuaHandleSynced::LoadUnsyncedCode(lua_State *L, const string& code, const
 	lua_settop(L, 0);
 
 	int error;
-	error = luaL_loadbuffer(L, code.c_str(), code.size(), debug.c_str());
+	error = CLuaChunkCache::LoadBuffer(L, code, debug);
 	if (error != 0) {
 		LOG_L(L_ERROR, "error = %i, %s, %s",
 				error, debug.c_str(), lua_tostring(L, -1));
@@ -972,7 +974,12 @@ int CLuaHandleSynced::LoadStringData(lua_State* L)
 	size_t len;
 	const char *str    = luaL_checklstring(L, 1, &len);
 	const char *chunkname = luaL_optstring(L, 2, str);
-	int status = luaL_loadbuffer(L, str, len, chunkname);
+	int status = 0;
+	if (CLuaChunkCache::IsCacheableChunkName(str, chunkname)) {
+		status = CLuaChunkCache::LoadBuffer(L, str, len, chunkname);
+	} else {
+		status = luaL_loadbuffer(L, str, len, chunkname);
+	}
 	if (status != 0) {
 		lua_pushnil(L);
 		lua_insert(L, -2);
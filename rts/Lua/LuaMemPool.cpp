@@ -0,0 +1,213 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "LuaMemPool.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <set>
+#include <boost/thread/mutex.hpp>
+
+/// granularity of the size-classes, also the alignment of pooled blocks
+static const size_t BLOCK_ALIGN = 8;
+/// bigger blocks are passed on to malloc
+static const size_t MAX_POOLED_SIZE = 256;
+static const size_t NUM_SIZE_CLASSES = MAX_POOLED_SIZE / BLOCK_ALIGN;
+static const size_t PAGE_SIZE = 64 * 1024;
+
+
+namespace {
+	std::set<LuaMemPool*> pools;
+	boost::mutex poolsMutex;
+}
+
+
+/// 0 for empty, NUM_SIZE_CLASSES for blocks handled by malloc
+static inline size_t GetSizeClass(size_t size)
+{
+	if (size > MAX_POOLED_SIZE)
+		return NUM_SIZE_CLASSES;
+
+	return ((size + BLOCK_ALIGN - 1) / BLOCK_ALIGN);
+}
+
+
+LuaMemPool::LuaMemPool()
+	: freeLists(NUM_SIZE_CLASSES + 1, NULL)
+	, pageCur(NULL)
+	, pageEnd(NULL)
+	, softLimit(0)
+	, hardLimit(0)
+	, collectThreshold(0)
+	, numLimitErrors(0)
+	, protectedDepth(0)
+{
+	boost::mutex::scoped_lock lock(poolsMutex);
+	pools.insert(this);
+}
+
+LuaMemPool::~LuaMemPool()
+{
+	{
+		boost::mutex::scoped_lock lock(poolsMutex);
+		pools.erase(this);
+	}
+
+	// blocks still allocated from malloc are owned by the (closed) state,
+	// which has freed them already
+	for (size_t i = 0; i < pages.size(); ++i) {
+		free(pages[i]);
+	}
+}
+
+
+void* LuaMemPool::Alloc(void* ud, void* ptr, size_t osize, size_t nsize)
+{
+	return (static_cast<LuaMemPool*>(ud))->Realloc(ptr, osize, nsize);
+}
+
+
+void* LuaMemPool::AllocBlock(size_t sizeClass)
+{
+	void* block = freeLists[sizeClass];
+
+	if (block != NULL) {
+		freeLists[sizeClass] = *static_cast<void**>(block);
+		return block;
+	}
+
+	const size_t blockSize = sizeClass * BLOCK_ALIGN;
+
+	if ((pageCur + blockSize) > pageEnd) {
+		// the rest of the current page is not used any further
+		char* page = static_cast<char*>(malloc(PAGE_SIZE));
+
+		if (page == NULL)
+			return NULL;
+
+		pages.push_back(page);
+		pageCur = page;
+		pageEnd = page + PAGE_SIZE;
+		stats.poolBytes += PAGE_SIZE;
+	}
+
+	block = pageCur;
+	pageCur += blockSize;
+	return block;
+}
+
+void LuaMemPool::FreeBlock(void* ptr, size_t sizeClass)
+{
+	*static_cast<void**>(ptr) = freeLists[sizeClass];
+	freeLists[sizeClass] = ptr;
+}
+
+
+void* LuaMemPool::Realloc(void* ptr, size_t osize, size_t nsize)
+{
+	// Lua passes the exact size of every block it frees or resizes,
+	// so the size-class does not need to be stored with the block
+	if (ptr == NULL)
+		osize = 0;
+
+	const size_t oldClass = GetSizeClass(osize);
+	const size_t newClass = GetSizeClass(nsize);
+
+	if (nsize == 0) {
+		if (ptr != NULL) {
+			if (oldClass == NUM_SIZE_CLASSES) {
+				free(ptr);
+			} else {
+				FreeBlock(ptr, oldClass);
+			}
+
+			stats.allocBytes -= osize;
+			stats.allocObjects -= 1;
+		}
+		return NULL;
+	}
+
+	// Lua can not handle failing shrinks, so only growth is limited
+	if (hardLimit > 0 && protectedDepth > 0 && nsize > osize && (stats.allocBytes - osize + nsize) > hardLimit) {
+		numLimitErrors += 1;
+		return NULL;
+	}
+
+	void* newPtr = NULL;
+
+	if (ptr != NULL && oldClass == newClass) {
+		if (newClass == NUM_SIZE_CLASSES) {
+			if ((newPtr = realloc(ptr, nsize)) == NULL)
+				return NULL;
+		} else {
+			newPtr = ptr;
+		}
+	} else {
+		if (newClass == NUM_SIZE_CLASSES) {
+			newPtr = malloc(nsize);
+		} else {
+			newPtr = AllocBlock(newClass);
+		}
+
+		if (newPtr == NULL) {
+			// out of system memory; a shrinking block can stay where it is
+			// (when it is freed later, it goes to the free-list of the
+			// smaller size-class, which it is big enough for)
+			if (ptr != NULL && nsize < osize && oldClass != NUM_SIZE_CLASSES) {
+				stats.allocBytes -= (osize - nsize);
+				return ptr;
+			}
+			return NULL;
+		}
+
+		if (ptr != NULL) {
+			memcpy(newPtr, ptr, std::min(osize, nsize));
+
+			if (oldClass == NUM_SIZE_CLASSES) {
+				free(ptr);
+			} else {
+				FreeBlock(ptr, oldClass);
+			}
+		} else {
+			stats.allocObjects += 1;
+		}
+	}
+
+	stats.allocBytes += nsize;
+	stats.allocBytes -= osize;
+	return newPtr;
+}
+
+
+void LuaMemPool::SetLimits(size_t _softLimit, size_t _hardLimit)
+{
+	softLimit = _softLimit;
+	hardLimit = _hardLimit;
+	collectThreshold = softLimit;
+}
+
+void LuaMemPool::Collected()
+{
+	// if the live data alone exceeds the soft limit, do not collect after
+	// every call again, but only once it has grown by another quarter
+	collectThreshold = std::max(softLimit, stats.allocBytes + stats.allocBytes / 4);
+}
+
+
+LuaMemPool::Stats LuaMemPool::GetGlobalStats()
+{
+	boost::mutex::scoped_lock lock(poolsMutex);
+
+	Stats globalStats;
+
+	for (std::set<LuaMemPool*>::const_iterator it = pools.begin(); it != pools.end(); ++it) {
+		const Stats& poolStats = (*it)->GetStats();
+
+		globalStats.allocBytes   += poolStats.allocBytes;
+		globalStats.allocObjects += poolStats.allocObjects;
+		globalStats.poolBytes    += poolStats.poolBytes;
+		globalStats.numPools     += 1;
+	}
+
+	return globalStats;
+}
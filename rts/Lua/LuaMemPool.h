@@ -0,0 +1,105 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef LUA_MEM_POOL_H
+#define LUA_MEM_POOL_H
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * Memory allocator for a single Lua state (see lua_Alloc).
+ * Lua allocates huge numbers of small, short-lived blocks (table nodes,
+ * strings, closures), which are served from size-class free-lists carved
+ * from big pages here, instead of going through the system malloc each time.
+ * Bigger blocks are passed on to malloc.
+ *
+ * As every state has its own pool, no locking is needed; all pages are
+ * released together with the state.
+ * The pool also counts the live bytes and blocks of its state, and
+ * enforces optional limits:
+ * - exceeding the soft limit asks the owner to run a full garbage
+ *   collection (see NeedsCollect)
+ * - allocations which would exceed the hard limit fail, which raises a
+ *   "not enough memory" error in the Lua code; this is only done inside
+ *   protected calls (see ProtectedScope), as Lua exits the program on
+ *   errors raised outside of them
+ */
+class LuaMemPool
+{
+public:
+	struct Stats {
+		Stats(): allocBytes(0), allocObjects(0), poolBytes(0), numPools(0) {}
+
+		/// bytes requested by Lua and not yet freed
+		size_t allocBytes;
+		/// number of live blocks
+		size_t allocObjects;
+		/// bytes held in pages (used or not)
+		size_t poolBytes;
+		size_t numPools;
+	};
+
+	/**
+	 * Enforces the hard limit of the pool (if any) during its lifetime;
+	 * to be placed around lua_pcall. Can be nested.
+	 */
+	class ProtectedScope {
+	public:
+		ProtectedScope(LuaMemPool* pool): pool(pool) { if (pool != NULL) { pool->protectedDepth += 1; } }
+		~ProtectedScope() { if (pool != NULL) { pool->protectedDepth -= 1; } }
+	private:
+		LuaMemPool* pool;
+	};
+
+public:
+	LuaMemPool();
+	~LuaMemPool();
+
+	/// lua_Alloc compatible entry point, ud has to be the pool
+	static void* Alloc(void* ud, void* ptr, size_t osize, size_t nsize);
+
+	void* Realloc(void* ptr, size_t osize, size_t nsize);
+
+	/// limits in bytes, 0 for none
+	void SetLimits(size_t softLimit, size_t hardLimit);
+	size_t GetSoftLimit() const { return softLimit; }
+	size_t GetHardLimit() const { return hardLimit; }
+
+	/// whether the owner should run a full garbage collection
+	bool NeedsCollect() const { return (softLimit > 0 && stats.allocBytes > collectThreshold); }
+	/// to be called after the collection requested by NeedsCollect
+	void Collected();
+
+	const Stats& GetStats() const { return stats; }
+	/// number of allocations refused because of the hard limit
+	size_t GetNumLimitErrors() const { return numLimitErrors; }
+
+	/**
+	 * Sum of the stats of all existing pools.
+	 * Pools owned by other threads may be updated at the same time,
+	 * so this is only suitable for statistics.
+	 */
+	static Stats GetGlobalStats();
+
+private:
+	void* AllocBlock(size_t sizeClass);
+	void FreeBlock(void* ptr, size_t sizeClass);
+
+private:
+	std::vector<void*> freeLists;
+	std::vector<char*> pages;
+
+	char* pageCur;
+	char* pageEnd;
+
+	size_t softLimit;
+	size_t hardLimit;
+	size_t collectThreshold;
+	size_t numLimitErrors;
+	/// number of ProtectedScopes, the hard limit applies if > 0
+	int protectedDepth;
+
+	Stats stats;
+};
+
+#endif // LUA_MEM_POOL_H
@@ -5,12 +5,14 @@
 
 #include <algorithm>
 #include <limits.h>
+#include <boost/cstdint.hpp>
 #include <boost/regex.hpp>
 
 #include "lib/streflop/streflop_cond.h"
 
 #include "System/float3.h"
 #include "System/float4.h"
+#include "LuaChunkCache.h"
 #include "LuaInclude.h"
 
 #include "LuaIO.h"
@@ -178,7 +180,7 @@ bool LuaParser::Execute()
 	}
 
 	int error;
-	error = luaL_loadbuffer(L, code.c_str(), code.size(), codeLabel.c_str());
+	error = CLuaChunkCache::LoadBuffer(L, code, codeLabel);
 	if (error != 0) {
 		errorLog = lua_tostring(L, -1);
 		LOG_L(L_ERROR, "%i, %s, %s",
@@ -230,6 +232,241 @@ bool LuaParser::Execute()
 }
 
 
+/******************************************************************************/
+//
+//  Root table (de)serialization
+//
+
+namespace {
+	enum SerializedType {
+		SERIALIZED_NUMBER  = 1,
+		SERIALIZED_STRING  = 2,
+		SERIALIZED_BOOLEAN = 3,
+		SERIALIZED_TABLE   = 4
+	};
+	static const int SERIALIZED_MAX_DEPTH = 64;
+
+	template<typename T> void WriteRaw(string& data, const T& value) {
+		data.append(reinterpret_cast<const char*>(&value), sizeof(T));
+	}
+	void WriteString(string& data, const char* str, size_t len) {
+		WriteRaw(data, (boost::uint32_t) len);
+		data.append(str, len);
+	}
+
+	class DataReader {
+	public:
+		DataReader(const string& data): data(data), pos(0), good(true) {}
+
+		template<typename T> T ReadRaw() {
+			T value = T();
+			if (good && ((pos + sizeof(T)) <= data.size())) {
+				memcpy(&value, &data[pos], sizeof(T));
+				pos += sizeof(T);
+			} else {
+				good = false;
+			}
+			return value;
+		}
+		/// pushes the string onto the stack
+		void PushString(lua_State* L) {
+			const boost::uint32_t len = ReadRaw<boost::uint32_t>();
+			if (good && ((pos + len) <= data.size())) {
+				lua_pushlstring(L, data.data() + pos, len);
+				pos += len;
+			} else {
+				good = false;
+				lua_pushnil(L);
+			}
+		}
+
+		bool IsGood() const { return good; }
+		bool AtEnd() const { return (pos == data.size()); }
+
+	private:
+		const string& data;
+		size_t pos;
+		bool good;
+	};
+}
+
+static bool SerializeValue(lua_State* L, int index, string& data, int depth);
+
+static bool SerializeTable(lua_State* L, int table, string& data, int depth)
+{
+	if ((depth > SERIALIZED_MAX_DEPTH) || !lua_checkstack(L, 4)) {
+		return false;
+	}
+
+	vector<lua_Number> numKeys;
+	vector<string> strKeys;
+
+	for (lua_pushnil(L); lua_next(L, table) != 0; lua_pop(L, 1)) {
+		if (lua_israwnumber(L, -2)) {
+			numKeys.push_back(lua_tonumber(L, -2));
+		} else if (lua_israwstring(L, -2)) {
+			size_t len = 0;
+			const char* str = lua_tolstring(L, -2, &len);
+			strKeys.push_back(string(str, len));
+		} else {
+			lua_pop(L, 2);
+			return false;
+		}
+	}
+
+	std::sort(numKeys.begin(), numKeys.end());
+	std::sort(strKeys.begin(), strKeys.end());
+
+	WriteRaw(data, (boost::uint32_t) numKeys.size());
+	WriteRaw(data, (boost::uint32_t) strKeys.size());
+
+	for (size_t k = 0; k < numKeys.size(); ++k) {
+		WriteRaw(data, numKeys[k]);
+		lua_pushnumber(L, numKeys[k]);
+		lua_rawget(L, table);
+		const bool ok = SerializeValue(L, lua_gettop(L), data, depth);
+		lua_pop(L, 1);
+		if (!ok) { return false; }
+	}
+	for (size_t k = 0; k < strKeys.size(); ++k) {
+		WriteString(data, strKeys[k].data(), strKeys[k].size());
+		lua_pushlstring(L, strKeys[k].data(), strKeys[k].size());
+		lua_rawget(L, table);
+		const bool ok = SerializeValue(L, lua_gettop(L), data, depth);
+		lua_pop(L, 1);
+		if (!ok) { return false; }
+	}
+
+	return true;
+}
+
+static bool SerializeValue(lua_State* L, int index, string& data, int depth)
+{
+	switch (lua_type(L, index)) {
+		case LUA_TNUMBER: {
+			data += (char) SERIALIZED_NUMBER;
+			WriteRaw(data, lua_tonumber(L, index));
+		} break;
+		case LUA_TSTRING: {
+			size_t len = 0;
+			const char* str = lua_tolstring(L, index, &len);
+			data += (char) SERIALIZED_STRING;
+			WriteString(data, str, len);
+		} break;
+		case LUA_TBOOLEAN: {
+			data += (char) SERIALIZED_BOOLEAN;
+			data += (char) lua_toboolean(L, index);
+		} break;
+		case LUA_TTABLE: {
+			data += (char) SERIALIZED_TABLE;
+			return SerializeTable(L, index, data, depth + 1);
+		} break;
+		default: {
+			// functions, userdata, threads can not be stored
+			return false;
+		}
+	}
+	return true;
+}
+
+/// pushes the value, or nil on error
+static bool DeserializeValue(lua_State* L, DataReader& reader, int depth)
+{
+	if ((depth > SERIALIZED_MAX_DEPTH) || !lua_checkstack(L, 4)) {
+		lua_pushnil(L);
+		return false;
+	}
+
+	switch (reader.ReadRaw<char>()) {
+		case SERIALIZED_NUMBER: {
+			lua_pushnumber(L, reader.ReadRaw<lua_Number>());
+		} break;
+		case SERIALIZED_STRING: {
+			reader.PushString(L);
+		} break;
+		case SERIALIZED_BOOLEAN: {
+			lua_pushboolean(L, reader.ReadRaw<char>());
+		} break;
+		case SERIALIZED_TABLE: {
+			const boost::uint32_t numKeys = reader.ReadRaw<boost::uint32_t>();
+			const boost::uint32_t strKeys = reader.ReadRaw<boost::uint32_t>();
+			if (!reader.IsGood()) {
+				lua_pushnil(L);
+				return false;
+			}
+
+			lua_createtable(L, std::min(numKeys, 1u << 16), std::min(strKeys, 1u << 16));
+
+			for (boost::uint32_t k = 0; k < (numKeys + strKeys); ++k) {
+				if (k < numKeys) {
+					lua_pushnumber(L, reader.ReadRaw<lua_Number>());
+				} else {
+					reader.PushString(L);
+				}
+				if (!DeserializeValue(L, reader, depth + 1) || !reader.IsGood()) {
+					lua_pop(L, 2);
+					return false;
+				}
+				lua_rawset(L, -3);
+			}
+		} break;
+		default: {
+			lua_pushnil(L);
+			return false;
+		}
+	}
+
+	return reader.IsGood();
+}
+
+
+bool LuaParser::SaveRootData(string& data)
+{
+	data.clear();
+
+	if (!IsValid() || !valid) {
+		return false;
+	}
+
+	lua_rawgeti(L, LUA_REGISTRYINDEX, rootRef);
+	const bool ok = lua_istable(L, -1) && SerializeValue(L, lua_gettop(L), data, 0);
+	lua_settop(L, 0);
+
+	if (!ok) {
+		data.clear();
+	}
+	return ok;
+}
+
+
+bool LuaParser::LoadRootData(const string& data)
+{
+	if (!IsValid()) {
+		errorLog = "could not initialize LUA library";
+		return false;
+	}
+
+	assert(initDepth == 0);
+
+	DataReader reader(data);
+
+	if (!DeserializeValue(L, reader, 0) || !reader.AtEnd() || !lua_istable(L, -1)) {
+		errorLog = "invalid serialized table data";
+		lua_settop(L, 0);
+		return false;
+	}
+
+	initDepth = -1;
+	rootRef = luaL_ref(L, LUA_REGISTRYINDEX);
+
+	lua_settop(L, 0);
+
+	valid = true;
+
+	return true;
+}
+
+
 void LuaParser::AddTable(LuaTable* tbl)
 {
 	tables.insert(tbl);
@@ -510,7 +747,7 @@ int LuaParser::Include(lua_State* L)
  		lua_error(L);
 	}
 
-	int error = luaL_loadbuffer(L, code.c_str(), code.size(), filename.c_str());
+	int error = CLuaChunkCache::LoadBuffer(L, code, filename);
 	if (error != 0) {
 		char buf[1024];
 		SNPRINTF(buf, sizeof(buf), "error = %i, %s, %s\n",
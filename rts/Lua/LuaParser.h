@@ -131,6 +131,19 @@ class LuaParser {
 
 		bool Execute();
 
+		/**
+		 * Serializes the root table (after Execute) into a canonical binary
+		 * form, with sorted keys, so equal tables always give equal data.
+		 * @return false if the table holds anything but numbers, strings,
+		 *   booleans and tables, or nests too deep (eg. cycles)
+		 */
+		bool SaveRootData(string& data);
+		/**
+		 * Rebuilds the root table from SaveRootData output, instead of
+		 * running any code with Execute.
+		 */
+		bool LoadRootData(const string& data);
+
 		bool IsValid() const { return (L != NULL); }
 
 		LuaTable GetRoot();
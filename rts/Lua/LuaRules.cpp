@@ -32,6 +32,7 @@
 #include "Sim/Units/UnitHandler.h"
 #include "Sim/Units/Scripts/CobInstance.h"
 #include "Sim/Weapons/Weapon.h"
+#include "System/Config/ConfigHandler.h"
 #include "System/Log/ILog.h"
 #include "System/FileSystem/FileHandler.h"
 #include "System/FileSystem/FileSystem.h"
@@ -81,6 +82,8 @@ CLuaRules::CLuaRules()
 		return;
 	}
 
+	SetGCBudget(configHandler->GetFloat("LuaGCBudgetRules"));
+
 	SetFullCtrl(true, true);
 	SetFullRead(true, true);
 	SetCtrlTeam(AllAccessTeam, true);
@@ -1357,6 +1357,7 @@ int LuaSyncedCtrl::SetUnitLosMask(lua_State* L)
 
 	unit->losStatus[allyTeam] = state;
 	unit->SetLosStatus(allyTeam, unit->CalcLosStatus(allyTeam));
+	unit->ForceLosStatusUpdate();
 
 	return 0;
 }
@@ -1378,6 +1379,7 @@ int LuaSyncedCtrl::SetUnitLosState(lua_State* L)
 	const unsigned short state = (losStatus & 0xFF00) | newState;
 
 	unit->SetLosStatus(allyTeam, state);
+	unit->ForceLosStatusUpdate();
 
 	return 0;
 }
@@ -9,6 +9,7 @@
 
 #include "LuaUnsyncedCtrl.h"
 #include "LuaCallInCheck.h"
+#include "LuaChunkCache.h"
 #include "LuaConstGL.h"
 #include "LuaConstCMD.h"
 #include "LuaConstCMDTYPE.h"
@@ -123,6 +124,7 @@ CLuaUI::CLuaUI()
 {
 	GML::SetLuaUIState(L_Sim);
 	luaUI = this;
+	SetGCBudget(configHandler->GetFloat("LuaGCBudgetUI"));
 
 	BEGIN_ITERATE_LUA_STATES();
 
@@ -189,6 +191,9 @@ CLuaUI::CLuaUI()
 
 	AddBasicCalls(L); // into Global
 
+	// widgets are loaded via loadstring(text, filename), let it use the chunk cache
+	LuaPushNamedCFunc(L, "loadstring", CLuaChunkCache::LoadString);
+
 	lua_pushstring(L, "Script");
 	lua_rawget(L, -2);
 	LuaPushNamedCFunc(L, "UpdateCallIn", CallOutUnsyncedUpdateCallIn);
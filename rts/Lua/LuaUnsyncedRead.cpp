@@ -5,6 +5,7 @@
 #include "LuaInclude.h"
 #include "LuaHandle.h"
 #include "LuaHashString.h"
+#include "LuaMemPool.h"
 #include "LuaUtils.h"
 #include "Game/Camera.h"
 #include "Game/CameraHandler.h"
@@ -83,6 +84,7 @@ bool LuaUnsyncedRead::PushEntries(lua_State* L)
 	REGISTER_LUA_CFUNC(GetFrameTimeOffset);
 	REGISTER_LUA_CFUNC(GetLastUpdateSeconds);
 	REGISTER_LUA_CFUNC(GetHasLag);
+	REGISTER_LUA_CFUNC(GetLuaMemUsage);
 
 	REGISTER_LUA_CFUNC(GetViewGeometry);
 	REGISTER_LUA_CFUNC(GetWindowGeometry);
@@ -421,6 +423,24 @@ int LuaUnsyncedRead::GetHasLag(lua_State* L)
 	return 1;
 }
 
+int LuaUnsyncedRead::GetLuaMemUsage(lua_State* L)
+{
+	CheckNoArgs(L, __FUNCTION__);
+
+	size_t handleBytes = 0;
+	size_t handleObjects = 0;
+	CLuaHandle::GetHandle(L)->GetMemUsage(handleBytes, handleObjects);
+
+	const LuaMemPool::Stats globalStats = LuaMemPool::GetGlobalStats();
+
+	// kilobytes, as collectgarbage("count") returns
+	lua_pushnumber(L, handleBytes / 1024.0f);
+	lua_pushnumber(L, handleObjects);
+	lua_pushnumber(L, globalStats.allocBytes / 1024.0f);
+	lua_pushnumber(L, globalStats.allocObjects);
+	return 4;
+}
+
 int LuaUnsyncedRead::IsAABBInView(lua_State* L)
 {
 	float3 mins = float3(luaL_checkfloat(L, 1),
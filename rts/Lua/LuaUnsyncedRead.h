@@ -20,6 +20,7 @@ class LuaUnsyncedRead {
 		static int GetFrameTimeOffset(lua_State* L);
 		static int GetLastUpdateSeconds(lua_State* L);
 		static int GetHasLag(lua_State* L);
+		static int GetLuaMemUsage(lua_State* L);
 
 		static int GetViewGeometry(lua_State* L);
 		static int GetWindowGeometry(lua_State* L);
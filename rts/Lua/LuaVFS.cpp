@@ -7,6 +7,7 @@
 #include "LuaVFS.h"
 
 #include "LuaInclude.h"
+#include "LuaChunkCache.h"
 
 #include "LuaHandle.h"
 #include "LuaHashString.h"
@@ -168,7 +169,7 @@ int LuaVFS::Include(lua_State* L, bool synced)
  		lua_error(L);
 	}
 
-	int error = luaL_loadbuffer(L, code.c_str(), code.size(), filename.c_str());
+	int error = CLuaChunkCache::LoadBuffer(L, code, filename);
 	if (error != 0) {
 		char buf[1024];
 		SNPRINTF(buf, sizeof(buf), "error = %i, %s, %s",
@@ -249,10 +249,20 @@ void CBasicMapDamage::Update()
 			}
 		}
 		if (e->ttl == 0) {
-			RecalcArea(x1 - 2, x2 + 2, y1 - 2, y2 + 2);
+			recalcAreas.push_back(SRectangle(x1 - 2, y1 - 2, x2 + 2, y2 + 2));
 		}
 	}
 
+	if (!recalcAreas.empty()) {
+		recalcAreas.Optimize();
+
+		for (CRectangleOptimizer::iterator ri = recalcAreas.begin(); ri != recalcAreas.end(); ++ri) {
+			RecalcArea(ri->x1, ri->x2, ri->z1, ri->z2);
+		}
+
+		recalcAreas.clear();
+	}
+
 	while (!explosions.empty() && explosions.front()->ttl == 0) {
 		delete explosions.front();
 		explosions.pop_front();
@@ -4,6 +4,7 @@
 #define _BASIC_MAP_DAMAGE_H
 
 #include "MapDamage.h"
+#include "System/Misc/RectangleOptimizer.h"
 
 #include <deque>
 #include <vector>
@@ -46,6 +47,13 @@ private:
 
 	std::deque<Explo*> explosions;
 
+	/**
+	 * Areas of craters that finished deforming during the current Update;
+	 * overlapping ones are merged so derived data (normals, slopes, path
+	 * costs, ...) is recalculated once per merged region.
+	 */
+	CRectangleOptimizer recalcAreas;
+
 	struct RelosSquare {
 		int x;
 		int y;
@@ -21,6 +21,11 @@
 #include "System/FileSystem/FileSystem.h"
 #include "System/LoadSave/LoadSaveInterface.h"
 #include "System/Misc/RectangleOptimizer.h"
+#include "System/OpenMP_cond.h"
+
+#ifndef DEDICATED_NOSSE
+#include <xmmintrin.h>
+#endif
 
 #ifdef USE_UNSYNCED_HEIGHTMAP
 #include "Game/GlobalUnsynced.h"
@@ -189,7 +194,13 @@ void CReadMap::Initialize()
 	assert(heightMapUnsyncedPtr != NULL);
 
 	CalcHeightmapChecksum();
-	UpdateHeightMapSynced(SRectangle(0, 0, gs->mapx, gs->mapy), true);
+
+	{
+		char timerName[128];
+		SNPRINTF(timerName, sizeof(timerName), "CReadMap::Initialize (derived maps, %dx%d)", gs->mapx, gs->mapy);
+		ScopedOnceTimer timer(timerName);
+		UpdateHeightMapSynced(SRectangle(0, 0, gs->mapx, gs->mapy), true);
+	}
 	//FIXME can't call that yet cause sky & skyLight aren't created yet (crashes in SMFReadMap.cpp)
 	//UpdateDraw(); 
 }
@@ -328,19 +339,38 @@ void CReadMap::UpdateCenterHeightmap(const SRectangle& rect)
 {
 	const float* heightmapSynced = GetCornerHeightMapSynced();
 
-	for (int y = rect.z1; y <= rect.z2; y++) {
-		for (int x = rect.x1; x <= rect.x2; x++) {
-			const int idxTL = (y    ) * gs->mapxp1 + x;
-			const int idxTR = (y    ) * gs->mapxp1 + x + 1;
-			const int idxBL = (y + 1) * gs->mapxp1 + x;
-			const int idxBR = (y + 1) * gs->mapxp1 + x + 1;
+	int y;
+	#pragma omp parallel for private(y)
+	for (y = rect.z1; y <= rect.z2; y++) {
+		const float* rowT = &heightmapSynced[(y    ) * gs->mapxp1];
+		const float* rowB = &heightmapSynced[(y + 1) * gs->mapxp1];
+		float* rowC = &centerHeightMap[y * gs->mapx];
+
+		int x = rect.x1;
+
+	#ifndef DEDICATED_NOSSE
+		// four squares at a time, using the same order of additions
+		// as the scalar loop so the (synced) results are bit-identical
+		const __m128 quarter = _mm_set1_ps(0.25f);
+
+		for (; (x + 3) <= rect.x2; x += 4) {
+			const __m128 hTL = _mm_loadu_ps(rowT + x    );
+			const __m128 hTR = _mm_loadu_ps(rowT + x + 1);
+			const __m128 hBL = _mm_loadu_ps(rowB + x    );
+			const __m128 hBR = _mm_loadu_ps(rowB + x + 1);
+			const __m128 height = _mm_add_ps(_mm_add_ps(_mm_add_ps(hTL, hTR), hBL), hBR);
+
+			_mm_storeu_ps(rowC + x, _mm_mul_ps(height, quarter));
+		}
+	#endif
 
+		for (; x <= rect.x2; x++) {
 			const float height =
-				heightmapSynced[idxTL] +
-				heightmapSynced[idxTR] +
-				heightmapSynced[idxBL] +
-				heightmapSynced[idxBR];
-			centerHeightMap[y * gs->mapx + x] = height * 0.25f;
+				rowT[x    ] +
+				rowT[x + 1] +
+				rowB[x    ] +
+				rowB[x + 1];
+			rowC[x] = height * 0.25f;
 		}
 	}
 }
@@ -355,8 +385,11 @@ void CReadMap::UpdateMipHeightmaps(const SRectangle& rect)
 		const int ex = (rect.x2 >> i);
 		const int sy = (rect.z1 >> i) & (~1);
 		const int ey = (rect.z2 >> i);
-		
-		for (int y = sy; y < ey; y += 2) {
+
+		// rows of one level are independent, levels are not
+		int y;
+		#pragma omp parallel for private(y)
+		for (y = sy; y < ey; y += 2) {
 			for (int x = sx; x < ex; x += 2) {
 				const float height =
 					mipPointerHeightMaps[i][(x    ) + (y    ) * hmapx] +
@@ -440,8 +473,10 @@ void CReadMap::UpdateSlopemap(const SRectangle& rect)
 	const int ex = std::min(gs->hmapx - 1, (rect.x2 / 2) + 1);
 	const int sy = std::max(0, (rect.z1 / 2) - 1);
 	const int ey = std::min(gs->hmapy - 1, (rect.z2 / 2) + 1);
-	
-	for (int y = sy; y <= ey; y++) {
+
+	int y;
+	#pragma omp parallel for private(y)
+	for (y = sy; y <= ey; y++) {
 		for (int x = sx; x <= ex; x++) {
 			const int idx0 = (y*2    ) * (gs->mapx) + x*2;
 			const int idx1 = (y*2 + 1) * (gs->mapx) + x*2;
@@ -93,33 +93,65 @@ void LocalModel::ReloadDisplayLists()
 	}
 }
 
-LocalModelPiece* LocalModel::CreateLocalModelPieces(const S3DModelPiece* mpParent, size_t pieceNum)
+LocalModelPiece* LocalModel::CreateLocalModelPieces(const S3DModelPiece* mpParent, int parentIdx)
 {
-	LocalModelPiece* lmpParent = new LocalModelPiece(mpParent);
+	const unsigned int pieceIdx = pieces.size();
+
+	LocalModelPiece* lmpParent = new LocalModelPiece(mpParent, this, pieceIdx);
 	LocalModelPiece* lmpChild = NULL;
 
 	pieces.push_back(lmpParent);
+	pieceParents.push_back(parentIdx);
+	subtreeSizes.push_back(1);
 
 	for (unsigned int i = 0; i < mpParent->GetChildCount(); i++) {
-		lmpChild = CreateLocalModelPieces(mpParent->GetChild(i), ++pieceNum);
+		lmpChild = CreateLocalModelPieces(mpParent->GetChild(i), pieceIdx);
 		lmpChild->SetParent(lmpParent);
 		lmpParent->AddChild(lmpChild);
 	}
 
+	subtreeSizes[pieceIdx] = pieces.size() - pieceIdx;
 	return lmpParent;
 }
 
+void LocalModel::UpdateDirtyPieceMatrices()
+{
+	// one linear pass over the dirty range; as parents precede their
+	// children, a parent's model-space matrix is always final when a
+	// child needs it, and pieces outside the range did not change
+	for (unsigned int i = dirtyBegin; i < dirtyEnd; i++) {
+		const int parentIdx = pieceParents[i];
+		const bool parentUpdated = (parentIdx >= int(dirtyBegin)) && matrixUpdated[parentIdx];
+		const bool pieceUpdated = pieces[i]->UpdateDirtyMatrix();
+
+		matrixUpdated[i] = (pieceUpdated || parentUpdated);
+
+		if (!matrixUpdated[i])
+			continue;
+
+		if (parentIdx < 0) {
+			pieceMatrices[i] = pieces[i]->GetPieceSpaceMatrix();
+		} else {
+			pieceMatrices[i] = pieces[i]->GetPieceSpaceMatrix() * pieceMatrices[parentIdx];
+		}
+	}
+
+	dirtyBegin = pieces.size();
+	dirtyEnd = 0;
+}
+
 
 
 /** ****************************************************************************************************
  * LocalModelPiece
  */
 
-LocalModelPiece::LocalModelPiece(const S3DModelPiece* piece)
+LocalModelPiece::LocalModelPiece(const S3DModelPiece* piece, LocalModel* model, unsigned int pieceIdx)
 	: colvol(new CollisionVolume(piece->GetCollisionVolume()))
+	, localModel(model)
 
-	, numUpdatesSynced(1)
-	, lastMatrixUpdate(0)
+	, lmodelPieceIndex(pieceIdx)
+	, dirty(true)
 
 	, scriptSetVisible(!piece->isEmpty)
 	, identityTransform(true)
@@ -129,8 +161,9 @@ LocalModelPiece::LocalModelPiece(const S3DModelPiece* piece)
 {
 	assert(piece != NULL);
 
-	dispListID =  piece->dispListID;
-	pos        =  piece->offset;
+	dispListID    =  piece->dispListID;
+	pos           =  piece->offset;
+	modelSpaceMat = &model->pieceMatrices[pieceIdx];
 
 	childs.reserve(piece->childs.size());
 
@@ -147,6 +180,12 @@ LocalModelPiece::~LocalModelPiece() {
 	delete colvol; colvol = NULL;
 }
 
+void LocalModelPiece::SetDirty()
+{
+	dirty = true;
+	localModel->PieceUpdated(lmodelPieceIndex);
+}
+
 bool LocalModelPiece::UpdateMatrix()
 {
 	bool r = true;
@@ -164,25 +203,14 @@ bool LocalModelPiece::UpdateMatrix()
 	return r;
 }
 
-void LocalModelPiece::UpdateMatricesRec(bool updateChildMatrices)
+bool LocalModelPiece::UpdateDirtyMatrix()
 {
-	if (lastMatrixUpdate != numUpdatesSynced) {
-		lastMatrixUpdate = numUpdatesSynced;
-		identityTransform = UpdateMatrix();
-		updateChildMatrices = true;
-	}
-
-	if (updateChildMatrices) {
-		if (parent == NULL) {
-			modelSpaceMat = pieceSpaceMat;
-		} else {
-			modelSpaceMat = pieceSpaceMat * parent->modelSpaceMat;
-		}
-	}
+	if (!dirty)
+		return false;
 
-	for (unsigned int i = 0; i < childs.size(); i++) {
-		childs[i]->UpdateMatricesRec(updateChildMatrices);
-	}
+	dirty = false;
+	identityTransform = UpdateMatrix();
+	return true;
 }
 
 
@@ -193,7 +221,7 @@ void LocalModelPiece::Draw() const
 		return;
 
 	glPushMatrix();
-	glMultMatrixf(modelSpaceMat);
+	glMultMatrixf(*modelSpaceMat);
 	glCallList(dispListID);
 	glPopMatrix();
 }
@@ -204,7 +232,7 @@ void LocalModelPiece::DrawLOD(unsigned int lod) const
 		return;
 
 	glPushMatrix();
-	glMultMatrixf(modelSpaceMat);
+	glMultMatrixf(*modelSpaceMat);
 	glCallList(lodDispLists[lod]);
 	glPopMatrix();
 }
@@ -233,7 +261,7 @@ __attribute__ ((force_align_arg_pointer))
 #endif
 float3 LocalModelPiece::GetAbsolutePos() const
 {
-	float3 pos = modelSpaceMat.GetPos();
+	float3 pos = modelSpaceMat->GetPos();
 	pos.x = -pos.x;
 	return pos;
 }
@@ -249,14 +277,14 @@ bool LocalModelPiece::GetEmitDirPos(float3& pos, float3& dir) const
 	const unsigned int count = piece->GetVertexCount();
 
 	if (count == 0) {
-		pos = modelSpaceMat.GetPos();
-		dir = modelSpaceMat.Mul(float3(0.0f, 0.0f, 1.0f)) - pos;
+		pos = modelSpaceMat->GetPos();
+		dir = modelSpaceMat->Mul(float3(0.0f, 0.0f, 1.0f)) - pos;
 	} else if (count == 1) {
-		pos = modelSpaceMat.GetPos();
-		dir = modelSpaceMat.Mul(piece->GetVertexPos(0)) - pos;
+		pos = modelSpaceMat->GetPos();
+		dir = modelSpaceMat->Mul(piece->GetVertexPos(0)) - pos;
 	} else if (count >= 2) {
-		float3 p1 = modelSpaceMat.Mul(piece->GetVertexPos(0));
-		float3 p2 = modelSpaceMat.Mul(piece->GetVertexPos(1));
+		float3 p1 = modelSpaceMat->Mul(piece->GetVertexPos(0));
+		float3 p2 = modelSpaceMat->Mul(piece->GetVertexPos(1));
 
 		pos = p1;
 		dir = p2 - p1;
@@ -3,6 +3,7 @@
 #ifndef _3DMODEL_H
 #define _3DMODEL_H
 
+#include <algorithm>
 #include <vector>
 #include <string>
 #include <set>
@@ -152,7 +153,7 @@ public:
 
 struct LocalModelPiece
 {
-	LocalModelPiece(const S3DModelPiece* piece);
+	LocalModelPiece(const S3DModelPiece* piece, LocalModel* model, unsigned int pieceIdx);
 	~LocalModelPiece();
 
 	void AddChild(LocalModelPiece* c) { childs.push_back(c); }
@@ -163,13 +164,13 @@ struct LocalModelPiece
 	void SetLODCount(unsigned int count);
 
 	bool UpdateMatrix();
-	void UpdateMatricesRec(bool updateChildMatrices);
+	bool UpdateDirtyMatrix();
 
 	bool GetEmitDirPos(float3& pos, float3& dir) const;
 	float3 GetAbsolutePos() const;
 
-	void SetPosition(const float3& p) { pos = p; ++numUpdatesSynced; }
-	void SetRotation(const float3& r) { rot = r; ++numUpdatesSynced; }
+	void SetPosition(const float3& p) { pos = p; SetDirty(); }
+	void SetRotation(const float3& r) { rot = r; SetDirty(); }
 	void SetDirection(const float3& d) { dir = d; } // unused
 
 	const float3& GetPosition() const { return pos; }
@@ -177,23 +178,26 @@ struct LocalModelPiece
 	const float3& GetDirection() const { return dir; }
 
 	const CMatrix44f& GetPieceSpaceMatrix() const { return pieceSpaceMat; }
-	const CMatrix44f& GetModelSpaceMatrix() const { return modelSpaceMat; }
+	const CMatrix44f& GetModelSpaceMatrix() const { return *modelSpaceMat; }
 
 	const CollisionVolume* GetCollisionVolume() const { return colvol; }
 	      CollisionVolume* GetCollisionVolume()       { return colvol; }
 
 private:
+	void SetDirty();
+
 	float3 pos; // translation relative to parent LMP
 	float3 rot; // orientation relative to parent LMP, in radians
 	float3 dir; // direction from vertex[0] to vertex[1] (constant!)
 
 	CMatrix44f pieceSpaceMat; // transform relative to parent LMP (SYNCED), combines <pos> and <rot>
-	CMatrix44f modelSpaceMat; // transform relative to root LMP (SYNCED)
+	CMatrix44f* modelSpaceMat; // transform relative to root LMP (SYNCED), points into LocalModel::pieceMatrices
 
 	CollisionVolume* colvol;
+	LocalModel* localModel;
 
-	unsigned numUpdatesSynced; // triggers UpdateMatrix (via UpdateMatricesRec) if != lastMatrixUpdate
-	unsigned lastMatrixUpdate;
+	unsigned int lmodelPieceIndex; // index in LocalModel::pieces
+	bool dirty; // pos or rot changed since the last UpdateDirtyMatrix
 
 public:
 	bool scriptSetVisible;  // TODO: add (visibility) maxradius!
@@ -213,12 +217,21 @@ struct LocalModel
 {
 	LocalModel(const S3DModel* model)
 		: original(model)
-		, dirtyPieces(model->numPieces)
+		, dirtyBegin(0)
+		, dirtyEnd(model->numPieces)
 		, lodCount(0)
 	{
 		assert(model->numPieces >= 1);
+
+		// must not reallocate later, the pieces point into it
+		pieceMatrices.resize(model->numPieces);
+		matrixUpdated.resize(model->numPieces, false);
+
 		pieces.reserve(model->numPieces);
-		CreateLocalModelPieces(model->GetRootPiece());
+		pieceParents.reserve(model->numPieces);
+		subtreeSizes.reserve(model->numPieces);
+
+		CreateLocalModelPieces(model->GetRootPiece(), -1);
 		assert(pieces.size() == model->numPieces);
 	}
 
@@ -243,10 +256,9 @@ struct LocalModel
 	}
 
 	void UpdatePieceMatrices() {
-		if (dirtyPieces > 0) {
-			pieces[0]->UpdateMatricesRec(false);
+		if (dirtyBegin < dirtyEnd) {
+			UpdateDirtyPieceMatrices();
 		}
-		dirtyPieces = 0;
 	}
 
 
@@ -255,10 +267,17 @@ struct LocalModel
 	void DrawPiecesLOD(unsigned int lod) const;
 
 	void SetLODCount(unsigned int count);
-	void PieceUpdated(unsigned int pieceIdx) { dirtyPieces += 1; }
+	/// called by LocalModelPiece whenever it is transformed
+	void PieceUpdated(unsigned int pieceIdx) {
+		dirtyBegin = std::min(dirtyBegin, pieceIdx);
+		dirtyEnd = std::max(dirtyEnd, pieceIdx + subtreeSizes[pieceIdx]);
+	}
 
 	void ReloadDisplayLists();
 
+	/// model-space matrices of all pieces, in the order of <pieces>
+	const CMatrix44f* GetPieceMatrices() const { return &pieceMatrices[0]; }
+
 	// raw forms, the piece-index must be valid
 	// NOTE:
 	//   GetRawPieceDirection is only useful for special pieces (used for emit-sfx)
@@ -266,19 +285,30 @@ struct LocalModel
 	void GetRawEmitDirPos(int pieceIdx, float3& pos, float3& dir) const { pieces[pieceIdx]->GetEmitDirPos(pos, dir); }
 	float3 GetRawPiecePos(int pieceIdx) const { return pieces[pieceIdx]->GetAbsolutePos(); }
 	float3 GetRawPieceDirection(int pieceIdx) const { return pieces[pieceIdx]->GetDirection(); }
-	const CMatrix44f& GetRawPieceMatrix(int pieceIdx) const { return pieces[pieceIdx]->GetModelSpaceMatrix(); }
+	const CMatrix44f& GetRawPieceMatrix(int pieceIdx) const { return pieceMatrices[pieceIdx]; }
 
 private:
-	LocalModelPiece* CreateLocalModelPieces(const S3DModelPiece* mpParent, size_t pieceNum = 0);
+	LocalModelPiece* CreateLocalModelPieces(const S3DModelPiece* mpParent, int parentIdx);
+	void UpdateDirtyPieceMatrices();
 
 public:
 	const S3DModel* original;
 
-	// increased by UnitScript whenever a piece is transformed
-	unsigned int dirtyPieces;
+	// pieces transformed since the last UpdatePieceMatrices, and all
+	// their children, lie in the index range [dirtyBegin, dirtyEnd)
+	unsigned int dirtyBegin;
+	unsigned int dirtyEnd;
 	unsigned int lodCount;
 
+	// in depth-first order, so parents always precede their children
+	// and the subtree of piece i is [i, i + subtreeSizes[i])
 	std::vector<LocalModelPiece*> pieces;
+
+	std::vector<int> pieceParents; // -1 for the root
+	std::vector<unsigned int> subtreeSizes;
+
+	std::vector<CMatrix44f> pieceMatrices;
+	std::vector<bool> matrixUpdated; // scratch space of UpdateDirtyPieceMatrices
 };
 
 #endif /* _3DMODEL_H */
@@ -13,7 +13,11 @@
 #include "System/Log/ILog.h"
 #include "System/Platform/errorhandler.h"
 #include "System/Exceptions.h"
+#include "System/CRC.h"
+#include "System/Config/ConfigHandler.h"
+#include "System/FileSystem/DataDirsAccess.h"
 #include "System/FileSystem/FileHandler.h"
+#include "System/FileSystem/FileQueryFlags.h"
 #include "System/FileSystem/FileSystem.h"
 
 #include "lib/assimp/include/assimp/config.h"
@@ -28,11 +32,18 @@
 	#include "Rendering/GL/myGL.h"
 #endif
 
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+#include <boost/cstdint.hpp>
+
 
 #define IS_QNAN(f) (f != f)
 static const float DEGTORAD = PI / 180.f;
 static const float RADTODEG = 180.f / PI;
 
+CONFIG(bool, AssimpModelCache).defaultValue(true).safemodeValue(false).description("Cache models imported by Assimp (all formats but 3DO, S3O and OBJ) in binary form, to skip the import on later loads.");
+
 //! triangulate guarantees the most complex mesh is a triangle
 //! sortbytype ensure only 1 type of primitive type per mesh is used
 static const int ASS_POSTPROCESS_OPTIONS =
@@ -114,7 +125,78 @@ S3DModel* CAssParser::Load(const std::string& modelFilePath)
 		LOG_S(LOG_SECTION_MODEL, "Found valid model metadata in '%s'", metaFileName.c_str());
 	}
 
+	int maxIndices  = 1024;
+	int maxVertices = 1024;
+#ifndef BITMAP_NO_OPENGL
+	glGetIntegerv(GL_MAX_ELEMENTS_INDICES,  &maxIndices);
+	glGetIntegerv(GL_MAX_ELEMENTS_VERTICES, &maxVertices); //FIXME returns not optimal data, at best compute it ourself! (pre-TL cache size!)
+#endif
+
+	//! The processed model only depends on the model file, the metafile
+	//! and the mesh size limits, so a cached copy can replace the import
+	const bool useCache = configHandler->GetBool("AssimpModelCache");
+	const std::string cacheKey = GetCacheKey(modelFilePath, metaFileName, maxVertices, maxIndices);
+
+	SAssModel* model = NULL;
+
+	if (useCache) {
+		model = LoadCachedModel(modelFilePath, cacheKey);
+	}
+	if (model == NULL) {
+		model = ImportModel(modelFilePath, metaTable, maxVertices, maxIndices);
+
+		if (useCache) {
+			StoreCachedModel(model, cacheKey);
+		}
+	}
+
+	//! Assign textures
+	//! The S3O texture handler uses two textures.
+	//! The first contains diffuse color (RGB) and teamcolor (A)
+	//! The second contains glow (R), reflectivity (G) and 1-bit Alpha (A).
+	if (metaTable.KeyExists("tex1")) {
+		model->tex1 = metaTable.GetString("tex1", "default.png");
+	} else {
+		//! Search for a texture
+		std::vector<std::string> files = CFileHandler::FindFiles("unittextures/", modelName + ".*");
+		for(std::vector<std::string>::iterator fi = files.begin(); fi != files.end(); ++fi) {
+			model->tex1 = FileSystem::GetFilename(*fi);
+			break; //! there can be only one!
+		}
+	}
+	if (metaTable.KeyExists("tex2")) {
+		model->tex2 = metaTable.GetString("tex2", "");
+	} else {
+		//! Search for a texture
+		std::vector<std::string> files = CFileHandler::FindFiles("unittextures/", modelName + "2.*");
+		for(std::vector<std::string>::iterator fi = files.begin(); fi != files.end(); ++fi) {
+			model->tex2 = FileSystem::GetFilename(*fi);
+			break; //! there can be only one!
+		}
+	}
+	model->flipTexY = metaTable.GetBool("fliptextures", true); //! Flip texture upside down
+	model->invertTexAlpha = metaTable.GetBool("invertteamcolor", true); //! Reverse teamcolor levels
+
+	//! Load textures
+	LOG_S(LOG_SECTION_MODEL, "Loading textures. Tex1: '%s' Tex2: '%s'",
+			model->tex1.c_str(), model->tex2.c_str());
+	texturehandlerS3O->LoadS3OTexture(model);
 
+	//! Verbose logging of model properties
+	LOG_SL(LOG_SECTION_MODEL, L_DEBUG, "model->name: %s", model->name.c_str());
+	LOG_SL(LOG_SECTION_MODEL, L_DEBUG, "model->numobjects: %d", model->numPieces);
+	LOG_SL(LOG_SECTION_MODEL, L_DEBUG, "model->radius: %f", model->radius);
+	LOG_SL(LOG_SECTION_MODEL, L_DEBUG, "model->height: %f", model->height);
+	LOG_SL(LOG_SECTION_MODEL, L_DEBUG, "model->mins: (%f,%f,%f)", model->mins[0], model->mins[1], model->mins[2]);
+	LOG_SL(LOG_SECTION_MODEL, L_DEBUG, "model->maxs: (%f,%f,%f)", model->maxs[0], model->maxs[1], model->maxs[2]);
+
+	LOG_S(LOG_SECTION_MODEL, "Model %s Imported.", model->name.c_str());
+	return model;
+}
+
+
+SAssModel* CAssParser::ImportModel(const std::string& modelFilePath, const LuaTable& metaTable, int maxVertices, int maxIndices)
+{
 	//! LOAD MODEL DATA
 	//! Create a model importer instance
 	Assimp::Importer importer;
@@ -132,10 +214,6 @@ S3DModel* CAssParser::Load(const std::string& modelFilePath)
 
 #ifndef BITMAP_NO_OPENGL
 	//! Optimize VBO-Mesh sizes/ranges
-	GLint maxIndices  = 1024;
-	GLint maxVertices = 1024;
-	glGetIntegerv(GL_MAX_ELEMENTS_INDICES,  &maxIndices);
-	glGetIntegerv(GL_MAX_ELEMENTS_VERTICES, &maxVertices); //FIXME returns not optimal data, at best compute it ourself! (pre-TL cache size!)
 	importer.SetPropertyInteger(AI_CONFIG_PP_SLM_VERTEX_LIMIT,   maxVertices);
 	importer.SetPropertyInteger(AI_CONFIG_PP_SLM_TRIANGLE_LIMIT, maxIndices/3);
 #endif
@@ -149,8 +227,7 @@ S3DModel* CAssParser::Load(const std::string& modelFilePath)
 				modelFilePath.c_str(), scene->mNumMeshes, scene->mNumMaterials,
 				scene->mNumTextures );
 	} else {
-		LOG_SL(LOG_SECTION_MODEL, L_ERROR, "Model Import: %s",
-				importer.GetErrorString());
+		throw content_error("[AssParser] Model Import: " + std::string(importer.GetErrorString()));
 	}
 
 	SAssModel* model = new SAssModel;
@@ -162,38 +239,6 @@ S3DModel* CAssParser::Load(const std::string& modelFilePath)
 	//! Gather per mesh info
 	CalculatePerMeshMinMax(model);
 
-	//! Assign textures
-	//! The S3O texture handler uses two textures.
-	//! The first contains diffuse color (RGB) and teamcolor (A)
-	//! The second contains glow (R), reflectivity (G) and 1-bit Alpha (A).
-	if (metaTable.KeyExists("tex1")) {
-		model->tex1 = metaTable.GetString("tex1", "default.png");
-	} else {
-		//! Search for a texture
-		std::vector<std::string> files = CFileHandler::FindFiles("unittextures/", modelName + ".*");
-		for(std::vector<std::string>::iterator fi = files.begin(); fi != files.end(); ++fi) {
-			model->tex1 = FileSystem::GetFilename(*fi);
-			break; //! there can be only one!
-		}
-	}
-	if (metaTable.KeyExists("tex2")) {
-		model->tex2 = metaTable.GetString("tex2", "");
-	} else {
-		//! Search for a texture
-		std::vector<std::string> files = CFileHandler::FindFiles("unittextures/", modelName + "2.*");
-		for(std::vector<std::string>::iterator fi = files.begin(); fi != files.end(); ++fi) {
-			model->tex2 = FileSystem::GetFilename(*fi);
-			break; //! there can be only one!
-		}
-	}
-	model->flipTexY = metaTable.GetBool("fliptextures", true); //! Flip texture upside down
-	model->invertTexAlpha = metaTable.GetBool("invertteamcolor", true); //! Reverse teamcolor levels
-
-	//! Load textures
-	LOG_S(LOG_SECTION_MODEL, "Loading textures. Tex1: '%s' Tex2: '%s'",
-			model->tex1.c_str(), model->tex2.c_str());
-	texturehandlerS3O->LoadS3OTexture(model);
-
 	//! Load all pieces in the model
 	LOG_S(LOG_SECTION_MODEL, "Loading pieces from root node '%s'",
 			scene->mRootNode->mName.data);
@@ -214,15 +259,12 @@ S3DModel* CAssParser::Load(const std::string& modelFilePath)
 	if (model->radius < 0.0001f) CalculateRadius( model );
 	if (model->height < 0.0001f) CalculateHeight( model );
 
-	//! Verbose logging of model properties
-	LOG_SL(LOG_SECTION_MODEL, L_DEBUG, "model->name: %s", model->name.c_str());
-	LOG_SL(LOG_SECTION_MODEL, L_DEBUG, "model->numobjects: %d", model->numPieces);
-	LOG_SL(LOG_SECTION_MODEL, L_DEBUG, "model->radius: %f", model->radius);
-	LOG_SL(LOG_SECTION_MODEL, L_DEBUG, "model->height: %f", model->height);
-	LOG_SL(LOG_SECTION_MODEL, L_DEBUG, "model->mins: (%f,%f,%f)", model->mins[0], model->mins[1], model->mins[2]);
-	LOG_SL(LOG_SECTION_MODEL, L_DEBUG, "model->maxs: (%f,%f,%f)", model->maxs[0], model->maxs[1], model->maxs[2]);
+	//! the scene is owned by (and dies with) the importer
+	model->scene = NULL;
+	for (ModelPieceMap::const_iterator it = model->pieces.begin(); it != model->pieces.end(); ++it) {
+		static_cast<SAssPiece*>(it->second)->node = NULL;
+	}
 
-	LOG_S(LOG_SECTION_MODEL, "Model %s Imported.", model->name.c_str());
 	return model;
 }
 
@@ -475,12 +517,7 @@ SAssPiece* CAssParser::LoadPiece(SAssModel* model, aiNode* node, const LuaTable&
 		}
 	}
 
-	//! collision volume for piece (not sure about these coords)
-	// FIXME add metatable tags for this!!!!
-	const float3 cvScales = piece->maxs - piece->mins;
-	const float3 cvOffset = (piece->maxs - piece->offset) + (piece->mins - piece->offset);
-
-	piece->colvol = new CollisionVolume("box", cvScales, cvOffset);
+	SetPieceCollisionVolume(piece);
 
 	//! Get parent name from metadata or model
 	if (pieceTable.KeyExists("parent")) {
@@ -589,6 +626,310 @@ void CAssParser::CalculateHeight(S3DModel* model)
 }
 
 
+//! collision volume for piece (not sure about these coords)
+// FIXME add metatable tags for this!!!!
+void CAssParser::SetPieceCollisionVolume(SAssPiece* piece)
+{
+	const float3 cvScales = piece->maxs - piece->mins;
+	const float3 cvOffset = (piece->maxs - piece->offset) + (piece->mins - piece->offset);
+
+	piece->SetCollisionVolume(new CollisionVolume("box", cvScales, cvOffset));
+}
+
+
+
+/******************************************************************************/
+//! Model cache
+//! Stores the result of ImportModel, ie. everything but the textures, so
+//! later loads of an unchanged model skip Assimp (and its post-processing)
+//! entirely. The piece vertex, index and tangent arrays are stored as raw
+//! blocks, to be copied (or mapped) directly.
+
+static const std::string ASS_CACHE_DIR = "cache/models/";
+static const char ASS_CACHE_MAGIC[8] = {'S', 'p', 'r', 'A', 's', 's', 'M', 'C'};
+//! increase when the cache format, or the processing in ImportModel changes
+static const boost::uint32_t ASS_CACHE_VERSION = 1;
+
+static unsigned int GetFileChecksum(const std::string& fileName)
+{
+	CFileHandler file(fileName);
+	CRC crc;
+
+	if (!file.FileExists())
+		return 0;
+
+	std::vector<char> buffer(file.FileSize());
+
+	if (!buffer.empty()) {
+		file.Read(&buffer[0], buffer.size());
+		crc.Update(&buffer[0], buffer.size());
+	}
+
+	return crc.GetDigest();
+}
+
+static std::string GetCacheFileName(const std::string& cacheKey)
+{
+	CRC crc;
+	crc.Update(cacheKey.data(), cacheKey.size());
+
+	char hashString[16];
+	sprintf(hashString, "%08x", crc.GetDigest());
+	return (ASS_CACHE_DIR + hashString + ".bin");
+}
+
+
+template<typename T> static void WriteValue(std::string& buf, const T& value)
+{
+	buf.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+static void WriteString(std::string& buf, const std::string& str)
+{
+	WriteValue(buf, boost::uint32_t(str.size()));
+	buf.append(str);
+}
+
+template<typename T> static void WriteVector(std::string& buf, const std::vector<T>& vec)
+{
+	WriteValue(buf, boost::uint32_t(vec.size()));
+
+	if (!vec.empty()) {
+		buf.append(reinterpret_cast<const char*>(&vec[0]), vec.size() * sizeof(T));
+	}
+}
+
+
+class CacheReader
+{
+public:
+	CacheReader(const std::vector<char>& buffer, size_t offset)
+		: buf(buffer)
+		, pos(offset)
+		, valid(offset <= buffer.size())
+	{}
+
+	bool IsValid() const { return valid; }
+	bool AtEnd() const { return (pos == buf.size()); }
+
+	template<typename T> void ReadValue(T& value) {
+		if (!Check(sizeof(T)))
+			return;
+
+		memcpy(&value, &buf[pos], sizeof(T));
+		pos += sizeof(T);
+	}
+
+	void ReadString(std::string& str) {
+		boost::uint32_t size = 0;
+		ReadValue(size);
+
+		if (!Check(size))
+			return;
+
+		str.assign(&buf[pos], size);
+		pos += size;
+	}
+
+	template<typename T> void ReadVector(std::vector<T>& vec) {
+		boost::uint32_t size = 0;
+		ReadValue(size);
+
+		valid = valid && (size <= ((buf.size() - pos) / sizeof(T)));
+		if (!valid)
+			return;
+
+		vec.resize(size);
+
+		if (size > 0) {
+			memcpy(&vec[0], &buf[pos], size * sizeof(T));
+		}
+		pos += (size * sizeof(T));
+	}
+
+private:
+	bool Check(size_t size) {
+		valid = valid && ((buf.size() - pos) >= size);
+		return valid;
+	}
+
+	const std::vector<char>& buf;
+	size_t pos;
+	bool valid;
+};
+
+
+std::string CAssParser::GetCacheKey(const std::string& modelFilePath, const std::string& metaFileName, int maxVertices, int maxIndices)
+{
+	std::ostringstream key;
+	key << ASS_CACHE_VERSION << "\n";
+	key << sizeof(SAssVertex) << " " << sizeof(float3) << "\n";
+	key << ASS_POSTPROCESS_OPTIONS << " " << maxVertices << " " << maxIndices << "\n";
+	key << modelFilePath << "\n" << GetFileChecksum(modelFilePath) << "\n";
+	key << metaFileName << "\n" << GetFileChecksum(metaFileName) << "\n";
+	return key.str();
+}
+
+
+SAssModel* CAssParser::LoadCachedModel(const std::string& modelFilePath, const std::string& cacheKey)
+{
+	const std::string fileName = GetCacheFileName(cacheKey);
+	const std::string filePath = dataDirsAccess.LocateFile(fileName);
+
+	FILE* in = fopen(filePath.c_str(), "rb");
+	if (in == NULL)
+		return NULL;
+
+	std::vector<char> buffer;
+	char readBuffer[64 * 1024];
+	size_t numRead = 0;
+	while ((numRead = fread(readBuffer, 1, sizeof(readBuffer), in)) > 0) {
+		buffer.insert(buffer.end(), readBuffer, readBuffer + numRead);
+	}
+	fclose(in);
+
+	//! header: magic, key, data checksum
+	const size_t headerSize = sizeof(ASS_CACHE_MAGIC) + sizeof(boost::uint32_t) + cacheKey.size() + sizeof(boost::uint32_t);
+
+	bool valid = (buffer.size() >= headerSize);
+	valid = valid && (memcmp(&buffer[0], ASS_CACHE_MAGIC, sizeof(ASS_CACHE_MAGIC)) == 0);
+
+	CacheReader header(buffer, sizeof(ASS_CACHE_MAGIC));
+	std::string key;
+	boost::uint32_t checksum = 0;
+	header.ReadString(key);
+	header.ReadValue(checksum);
+
+	//! the key guards against (very unlikely) collisions of the file names
+	valid = valid && header.IsValid() && (key == cacheKey);
+
+	if (valid) {
+		CRC crc;
+		crc.Update(&buffer[headerSize], buffer.size() - headerSize);
+		valid = (crc.GetDigest() == checksum);
+	}
+	if (!valid) {
+		LOG_SL(LOG_SECTION_MODEL, L_WARNING, "ignoring outdated or invalid model cache %s", filePath.c_str());
+		return NULL;
+	}
+
+	CacheReader reader(buffer, headerSize);
+
+	SAssModel* model = new SAssModel;
+	model->name = modelFilePath;
+	model->type = MODELTYPE_ASS;
+
+	boost::uint32_t numPieces = 0;
+	reader.ReadValue(model->radius);
+	reader.ReadValue(model->height);
+	reader.ReadValue(model->relMidPos);
+	reader.ReadValue(model->mins);
+	reader.ReadValue(model->maxs);
+	reader.ReadValue(numPieces);
+
+	for (boost::uint32_t n = 0; (n < numPieces) && reader.IsValid(); ++n) {
+		SAssPiece* piece = new SAssPiece;
+		piece->type = MODELTYPE_OTHER;
+		piece->model = model;
+
+		reader.ReadString(piece->name);
+		reader.ReadString(piece->parentName);
+		reader.ReadValue(piece->isEmpty);
+		reader.ReadValue(piece->offset);
+		reader.ReadValue(piece->goffset);
+		reader.ReadValue(piece->rot);
+		reader.ReadValue(piece->scale);
+		reader.ReadValue(piece->mins);
+		reader.ReadValue(piece->maxs);
+		reader.ReadVector(piece->vertices);
+		reader.ReadVector(piece->vertexDrawOrder);
+		reader.ReadVector(piece->sTangents);
+		reader.ReadVector(piece->tTangents);
+
+		SetPieceCollisionVolume(piece);
+		model->pieces[piece->name] = piece;
+	}
+
+	if (!reader.IsValid() || !reader.AtEnd() || (model->pieces.size() != numPieces)) {
+		for (ModelPieceMap::iterator it = model->pieces.begin(); it != model->pieces.end(); ++it) {
+			delete it->second;
+		}
+		delete model;
+
+		LOG_SL(LOG_SECTION_MODEL, L_WARNING, "ignoring corrupt model cache %s", filePath.c_str());
+		return NULL;
+	}
+
+	BuildPieceHierarchy(model);
+
+	LOG_S(LOG_SECTION_MODEL, "Loaded model %s from cache %s", modelFilePath.c_str(), fileName.c_str());
+	return model;
+}
+
+
+void CAssParser::StoreCachedModel(const SAssModel* model, const std::string& cacheKey)
+{
+	std::string data;
+
+	WriteValue(data, model->radius);
+	WriteValue(data, model->height);
+	WriteValue(data, model->relMidPos);
+	WriteValue(data, model->mins);
+	WriteValue(data, model->maxs);
+	WriteValue(data, boost::uint32_t(model->pieces.size()));
+
+	for (ModelPieceMap::const_iterator it = model->pieces.begin(); it != model->pieces.end(); ++it) {
+		const SAssPiece* piece = static_cast<const SAssPiece*>(it->second);
+
+		WriteString(data, piece->name);
+		WriteString(data, piece->parentName);
+		WriteValue(data, piece->isEmpty);
+		WriteValue(data, piece->offset);
+		WriteValue(data, piece->goffset);
+		WriteValue(data, piece->rot);
+		WriteValue(data, piece->scale);
+		WriteValue(data, piece->mins);
+		WriteValue(data, piece->maxs);
+		WriteVector(data, piece->vertices);
+		WriteVector(data, piece->vertexDrawOrder);
+		WriteVector(data, piece->sTangents);
+		WriteVector(data, piece->tTangents);
+	}
+
+	CRC crc;
+	crc.Update(data.data(), data.size());
+
+	std::string header(ASS_CACHE_MAGIC, sizeof(ASS_CACHE_MAGIC));
+	WriteString(header, cacheKey);
+	WriteValue(header, boost::uint32_t(crc.GetDigest()));
+
+	//! write to a temporary file first, so no half-written cache is ever read
+	const std::string fileName = GetCacheFileName(cacheKey);
+	const std::string filePath = dataDirsAccess.LocateFile(fileName, FileQueryFlags::WRITE | FileQueryFlags::CREATE_DIRS);
+	const std::string tmpFilePath = filePath + ".tmp";
+
+	FILE* out = fopen(tmpFilePath.c_str(), "wb");
+	if (out == NULL) {
+		LOG_SL(LOG_SECTION_MODEL, L_WARNING, "failed to write model cache %s", tmpFilePath.c_str());
+		return;
+	}
+
+	bool good = (fwrite(header.data(), header.size(), 1, out) == 1);
+	good = good && (fwrite(data.data(), data.size(), 1, out) == 1);
+	good = (fclose(out) == 0) && good;
+
+#ifdef _WIN32
+	//! rename() does not replace existing files on windows
+	remove(filePath.c_str());
+#endif
+	if (!good || (rename(tmpFilePath.c_str(), filePath.c_str()) != 0)) {
+		LOG_SL(LOG_SECTION_MODEL, L_WARNING, "failed to write model cache %s", filePath.c_str());
+		remove(tmpFilePath.c_str());
+	}
+}
+
+
+
 void SAssPiece::DrawForList() const
 {
 	if (isEmpty) {
@@ -70,7 +70,14 @@ public:
 	S3DModel* Load(const std::string& modelFileName);
 
 private:
+	SAssModel* ImportModel(const std::string& modelFilePath, const LuaTable& metaTable, int maxVertices, int maxIndices);
+
+	static std::string GetCacheKey(const std::string& modelFilePath, const std::string& metaFileName, int maxVertices, int maxIndices);
+	static SAssModel* LoadCachedModel(const std::string& modelFilePath, const std::string& cacheKey);
+	static void StoreCachedModel(const SAssModel* model, const std::string& cacheKey);
+
 	static SAssPiece* LoadPiece(SAssModel* model, aiNode* node, const LuaTable& metaTable);
+	static void SetPieceCollisionVolume(SAssPiece* piece);
 	static void BuildPieceHierarchy(S3DModel* model);
 	static void CalculateRadius(S3DModel* model);
 	static void CalculateHeight(S3DModel* model);
@@ -3,6 +3,7 @@
 #include "Rendering/GL/myGL.h"
 #include <algorithm>
 #include <cctype>
+#include <stdexcept>
 
 #include "IModelParser.h"
 #include "3DModel.h"
@@ -17,6 +18,7 @@
 #include "System/Log/ILog.h"
 #include "System/Exceptions.h"
 #include "lib/gml/gml_base.h"
+#include "lib/streflop/streflop_cond.h"
 #include "lib/assimp/include/assimp/Importer.hpp"
 
 C3DModelLoader* modelParser = NULL;
@@ -159,16 +161,103 @@ S3DModel* C3DModelLoader::Load3DModel(std::string name)
 
 	StringToLowerInPlace(name);
 
+	IModelParser* parser = GetModelParser(name);
+
 	// search in cache first
 	ModelMap::iterator ci;
-	ParserMap::iterator pi;
 
 	if ((ci = cache.find(name)) != cache.end()) {
 		return ci->second;
 	}
 
+	if (parser == NULL) {
+		LOG_L(L_ERROR, "could not find a parser for model \"%s\" (unknown format?)", name.c_str());
+		return NULL;
+	}
+
 	// not found in cache, create the model and cache it
+	std::string error;
+	S3DModel* model = ParseModel(parser, name, error);
+
+	return (AddModel(parser, name, model, error));
+}
+
+void C3DModelLoader::PreloadModels(const std::vector<std::string>& names)
+{
+	GML_RECMUTEX_LOCK(model); // PreloadModels
+
+	std::vector<std::string> modelNames;
+	std::vector<IModelParser*> modelParsers;
+	std::set<std::string> modelNamesSet;
+
+	for (std::vector<std::string>::const_iterator it = names.begin(); it != names.end(); ++it) {
+		std::string name = StringToLower(*it);
+		IModelParser* parser = GetModelParser(name);
+
+		// unknown formats are reported when the model is requested
+		if (parser == NULL)
+			continue;
+		if (cache.find(name) != cache.end())
+			continue;
+		if (!modelNamesSet.insert(name).second)
+			continue;
+
+		modelNames.push_back(name);
+		modelParsers.push_back(parser);
+	}
+
+	const int numModels = modelNames.size();
+
+	std::vector<S3DModel*> models(numModels, (S3DModel*) NULL);
+	std::vector<std::string> errors(numModels);
+	std::vector<std::string> fatalErrors(numModels);
+
+	int numParallel = 0;
+	int i;
+
+	// parse (read, decode, compute tangents and extents) the models of
+	// the reentrant formats concurrently; exceptions must not leave the
+	// parallel region, so they are passed on below
+	#pragma omp parallel private(i) reduction(+:numParallel)
+	{
+		// this might not be the main thread's OpenMP team
+		streflop::streflop_init<streflop::Simple>();
+
+		#pragma omp for schedule(dynamic)
+		for (i = 0; i < numModels; ++i) {
+			if (!modelParsers[i]->IsReentrant())
+				continue;
+
+			try {
+				models[i] = ParseModel(modelParsers[i], modelNames[i], errors[i]);
+				numParallel++;
+			} catch (const std::exception& ex) {
+				fatalErrors[i] = ex.what();
+			}
+		}
+	}
+
+	// the other formats, and the GL resources of all models,
+	// on this thread in the order given (which sets the IDs)
+	for (i = 0; i < numModels; ++i) {
+		if (!fatalErrors[i].empty()) {
+			throw std::runtime_error("failed to load model \"" + modelNames[i] + "\": " + fatalErrors[i]);
+		}
+		if (!modelParsers[i]->IsReentrant()) {
+			models[i] = ParseModel(modelParsers[i], modelNames[i], errors[i]);
+		}
+
+		AddModel(modelParsers[i], modelNames[i], models[i], errors[i]);
+	}
+
+	LOG("[%s] loaded %i models (%i of them parsed concurrently)", __FUNCTION__, numModels, numParallel);
+}
+
+
+IModelParser* C3DModelLoader::GetModelParser(std::string& name)
+{
 	const std::string& fileExt = FileSystem::GetExtension(name);
+	ParserMap::const_iterator pi;
 
 	if (fileExt.empty()) {
 		// fallback (TODO: try all registered extensions?)
@@ -178,39 +267,51 @@ S3DModel* C3DModelLoader::Load3DModel(std::string name)
 		pi = parsers.find(fileExt);
 	}
 
-	if (pi != parsers.end()) {
-		IModelParser* p = pi->second;
-		S3DModel* model = NULL;
-		S3DModelPiece* root = NULL;
-
-		try {
-			model = p->Load("objects3d/" + name);
-		} catch (const content_error& ex) {
-			// crash-dummy
-			model = new S3DModel();
-			model->type = ModelExtToModelType(parsers, StringToLower(fileExt));
-			model->numPieces = 1;
-			// give it one dummy piece
-			model->SetRootPiece(ModelTypeToModelPiece(model->type));
-			model->GetRootPiece()->SetCollisionVolume(new CollisionVolume("box", UpVector * -1.0f, ZeroVector));
-
-			LOG_L(L_WARNING, "could not load model \"%s\" (reason: %s)", name.c_str(), ex.what());
-		}
+	if (pi == parsers.end())
+		return NULL;
 
-		if ((root = model->GetRootPiece()) != NULL) {
-			CreateLists(root);
-		}
+	return pi->second;
+}
 
-		cache[name] = model; // cache the model
-		model->id = cache.size(); // IDs start with 1
+S3DModel* C3DModelLoader::ParseModel(IModelParser* parser, const std::string& name, std::string& error) const
+{
+	try {
+		return (parser->Load("objects3d/" + name));
+	} catch (const content_error& ex) {
+		error = ex.what();
+	}
 
-		CheckModelNormals(model);
+	return NULL;
+}
+
+S3DModel* C3DModelLoader::AddModel(IModelParser* parser, const std::string& name, S3DModel* model, const std::string& error)
+{
+	S3DModelPiece* root = NULL;
+
+	if (model == NULL) {
+		// crash-dummy
+		model = new S3DModel();
+		model->type = ModelExtToModelType(parsers, FileSystem::GetExtension(name));
+		model->numPieces = 1;
+		// give it one dummy piece
+		model->SetRootPiece(ModelTypeToModelPiece(model->type));
+		model->GetRootPiece()->SetCollisionVolume(new CollisionVolume("box", UpVector * -1.0f, ZeroVector));
+
+		LOG_L(L_WARNING, "could not load model \"%s\" (reason: %s)", name.c_str(), error.c_str());
+	} else {
+		parser->Finalize(model);
+	}
 
-		return model;
+	if ((root = model->GetRootPiece()) != NULL) {
+		CreateLists(root);
 	}
 
-	LOG_L(L_ERROR, "could not find a parser for model \"%s\" (unknown format?)", name.c_str());
-	return NULL;
+	cache[name] = model; // cache the model
+	model->id = cache.size(); // IDs start with 1
+
+	CheckModelNormals(model);
+
+	return model;
 }
 
 void C3DModelLoader::Update() {
@@ -16,6 +16,17 @@ class IModelParser
 {
 public:
 	virtual S3DModel* Load(const std::string& name) = 0;
+	/**
+	 * Creates the GL resources (textures) of a model returned by Load,
+	 * always called on the thread owning the GL context.
+	 */
+	virtual void Finalize(S3DModel* model) {}
+	/**
+	 * Whether Load may run concurrently with other Load calls, see
+	 * C3DModelLoader::PreloadModels. Such parsers must not touch GL
+	 * (use Finalize instead) or any other shared state.
+	 */
+	virtual bool IsReentrant() const { return false; }
 	virtual ~IModelParser() {}
 };
 
@@ -30,6 +41,12 @@ public:
 	void DeleteLocalModel(LocalModel* model);
 
 	S3DModel* Load3DModel(std::string name);
+	/**
+	 * Loads all given models which are not cached yet, parsing those of
+	 * reentrant formats concurrently. The GL resources are created on the
+	 * calling thread afterwards, as with Load3DModel.
+	 */
+	void PreloadModels(const std::vector<std::string>& names);
 
 	typedef std::map<std::string, S3DModel*> ModelMap;
 	typedef std::map<std::string, IModelParser*> ParserMap;
@@ -44,6 +61,10 @@ private:
 	std::set<LocalModel*> fixLocalModels;
 	std::vector<LocalModel*> deleteLocalModels;
 
+	IModelParser* GetModelParser(std::string& name);
+	S3DModel* ParseModel(IModelParser* parser, const std::string& name, std::string& error) const;
+	S3DModel* AddModel(IModelParser* parser, const std::string& name, S3DModel* model, const std::string& error);
+
 	void CreateLists(S3DModelPiece* o);
 	void CreateListsNow(S3DModelPiece* o);
 
@@ -42,7 +42,6 @@ S3DModel* CS3OParser::Load(const std::string& name)
 		model->tex2 = (char*) &fileBuf[header.texture2];
 		model->mins = DEF_MIN_SIZE;
 		model->maxs = DEF_MAX_SIZE;
-	texturehandlerS3O->LoadS3OTexture(model);
 
 	SS3OPiece* rootPiece = LoadPiece(model, NULL, fileBuf, header.rootPiece);
 
@@ -57,6 +56,11 @@ S3DModel* CS3OParser::Load(const std::string& name)
 	return model;
 }
 
+void CS3OParser::Finalize(S3DModel* model)
+{
+	texturehandlerS3O->LoadS3OTexture(model);
+}
+
 SS3OPiece* CS3OParser::LoadPiece(S3DModel* model, SS3OPiece* parent, unsigned char* buf, int offset)
 {
 	model->numPieces++;
@@ -50,6 +50,8 @@ class CS3OParser: public IModelParser
 {
 public:
 	S3DModel* Load(const std::string& name);
+	void Finalize(S3DModel* model);
+	bool IsReentrant() const { return true; }
 
 private:
 	SS3OPiece* LoadPiece(S3DModel*, SS3OPiece*, unsigned char* buf, int offset);
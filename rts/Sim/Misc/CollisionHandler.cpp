@@ -13,11 +13,17 @@
 #include "System/Matrix44f.h"
 #include "System/Log/ILog.h"
 
+#ifndef DEDICATED_NOSSE
+#include <xmmintrin.h>
+#endif
+
 CR_BIND(CCollisionHandler, );
 
 unsigned int CCollisionHandler::numDiscTests = 0;
 unsigned int CCollisionHandler::numContTests = 0;
 
+const unsigned int CCollisionHandler::MAX_BATCH_VOLUMES;
+
 
 void CCollisionHandler::PrintStats()
 {
@@ -271,12 +277,53 @@ bool CCollisionHandler::MouseHit(const CUnit* u, const float3& p0, const float3&
 }
 
 
+/// fixed-size staging area for the visible piece-volumes of one piece tree
+struct CCollisionHandler::PieceTreeBatch {
+	PieceTreeBatch(): numVols(0), numHits(0), dstNearSq(1e30f) {}
+
+	// tests the staged volumes and keeps the closest hit in <q>
+	void Flush(const float3& p0, const float3& p1, CollisionQuery* q) {
+		CCollisionHandler::IntersectBatch(vols, mats, numVols, p0, p1, qs, hits);
+
+		for (unsigned int i = 0; i < numVols; i++) {
+			if (!hits[i])
+				continue;
+
+			const float dstSq = (qs[i].p0 - p0).SqLength();
+
+			if (q != NULL && dstSq < dstNearSq) {
+				dstNearSq = dstSq;
+
+				*q = qs[i];
+				q->lmp = pieces[i];
+			}
+
+			numHits += 1;
+		}
+
+		numVols = 0;
+	}
+
+	const CollisionVolume* vols[MAX_BATCH_VOLUMES];
+	CMatrix44f mats[MAX_BATCH_VOLUMES];
+	LocalModelPiece* pieces[MAX_BATCH_VOLUMES];
+	CollisionQuery qs[MAX_BATCH_VOLUMES];
+	bool hits[MAX_BATCH_VOLUMES];
+
+	unsigned int numVols;
+	unsigned int numHits;
+
+	float dstNearSq;
+};
+
+
 void CCollisionHandler::IntersectPieceTreeHelper(
 	LocalModelPiece* lmp,
 	CMatrix44f mat,
 	const float3& p0,
 	const float3& p1,
-	std::list<CollisionQuery>* hits)
+	PieceTreeBatch* batch,
+	CollisionQuery* q)
 {
 	const CollisionVolume* vol = lmp->GetCollisionVolume();
 	const float3& offset = vol->GetOffsets();
@@ -288,51 +335,37 @@ void CCollisionHandler::IntersectPieceTreeHelper(
 	mat.RotateZ(-rot[2]);
 
 	if (lmp->scriptSetVisible && !vol->IgnoreHits()) {
+		if (batch->numVols == MAX_BATCH_VOLUMES)
+			batch->Flush(p0, p1, q);
+
 		mat.Translate(offset);
 
-		CollisionQuery q;
-		if (CCollisionHandler::Intersect(vol, mat, p0, p1, &q)) {
-			q.lmp = lmp;
-			hits->push_back(q);
-		}
+		batch->vols[batch->numVols] = vol;
+		batch->mats[batch->numVols] = mat;
+		batch->pieces[batch->numVols] = lmp;
+		batch->numVols += 1;
 
 		mat.Translate(-offset);
 	}
 
 	for (unsigned int i = 0; i < lmp->childs.size(); i++) {
-		IntersectPieceTreeHelper(lmp->childs[i], mat, p0, p1, hits);
+		IntersectPieceTreeHelper(lmp->childs[i], mat, p0, p1, batch, q);
 	}
 }
 
 bool CCollisionHandler::IntersectPieceTree(const CUnit* u, const float3& p0, const float3& p1, CollisionQuery* q)
 {
-	std::list<CollisionQuery> hits;
-	std::list<CollisionQuery>::const_iterator hitsIt;
+	PieceTreeBatch batch;
 
 	// this probably needs an early-out test
 	CMatrix44f mat = u->GetTransformMatrix(true);
 	mat.Translate(u->relMidPos * float3(-1.0f, 0.0f, 1.0f));
 
-	IntersectPieceTreeHelper(u->localModel->GetRoot(), mat, p0, p1, &hits);
-
-	float dstNearSq = 1e30f;
-
-	// save the closest intersection
-	for (hitsIt = hits.begin(); hitsIt != hits.end(); ++hitsIt) {
-		const CollisionQuery& qTmp = *hitsIt;
-		const float dstSq = (qTmp.p0 - p0).SqLength();
-
-		if (q != NULL && dstSq < dstNearSq) {
-			dstNearSq = dstSq;
-
-			q->b0 = qTmp.b0; q->t0 = qTmp.t0; q->p0 = qTmp.p0;
-			q->b1 = qTmp.b1; q->t1 = qTmp.t1; q->p1 = qTmp.p1;
-
-			q->lmp = qTmp.lmp;
-		}
-	}
+	// hits are evaluated in tree order, the closest one ends up in <q>
+	IntersectPieceTreeHelper(u->localModel->GetRoot(), mat, p0, p1, &batch, q);
+	batch.Flush(p0, p1, q);
 
-	return (!hits.empty());
+	return (batch.numHits != 0);
 }
 
 
@@ -382,7 +415,6 @@ bool CCollisionHandler::Intersect(const CollisionVolume* v, const CMatrix44f& m,
 	CMatrix44f mInv = m.Invert();
 	const float3 pi0 = mInv.Mul(p0);
 	const float3 pi1 = mInv.Mul(p1);
-	bool intersect = false;
 
 	// minimum and maximum (x, y, z) coordinates of transformed ray
 	const float rminx = std::min(pi0.x, pi1.x), rminy = std::min(pi0.y, pi1.y), rminz = std::min(pi0.z, pi1.z);
@@ -398,6 +430,13 @@ bool CCollisionHandler::Intersect(const CollisionVolume* v, const CMatrix44f& m,
 	if (rmaxy < vminy || rminy > vmaxy) { return false; }
 	if (rmaxz < vminz || rminz > vmaxz) { return false; }
 
+	return (CCollisionHandler::IntersectVolume(v, m, pi0, pi1, q));
+}
+
+bool CCollisionHandler::IntersectVolume(const CollisionVolume* v, const CMatrix44f& m, const float3& pi0, const float3& pi1, CollisionQuery* q)
+{
+	bool intersect = false;
+
 	switch (v->GetVolumeType()) {
 		case CollisionVolume::COLVOL_TYPE_SPHERE: {
 			// sphere is special case of ellipsoid, reuse code
@@ -424,6 +463,104 @@ bool CCollisionHandler::Intersect(const CollisionVolume* v, const CMatrix44f& m,
 	return intersect;
 }
 
+
+unsigned int CCollisionHandler::IntersectBatch(
+	const CollisionVolume* const* vols,
+	const CMatrix44f* mats,
+	unsigned int numVols,
+	const float3& p0,
+	const float3& p1,
+	CollisionQuery* qs,
+	bool* hits)
+{
+	unsigned int numHits = 0;
+
+	for (unsigned int base = 0; base < numVols; base += MAX_BATCH_VOLUMES) {
+		const unsigned int n = std::min(numVols - base, MAX_BATCH_VOLUMES);
+
+		// volume-space ray terminals (AoS, for the narrow phase)
+		float3 pis0[MAX_BATCH_VOLUMES];
+		float3 pis1[MAX_BATCH_VOLUMES];
+
+		// ray terminals and volume half-scales per axis (SoA, for the
+		// bounding-box rejection); unused lanes stay zero and are ignored
+		float ri0[3][MAX_BATCH_VOLUMES] = {{0.0f}};
+		float ri1[3][MAX_BATCH_VOLUMES] = {{0.0f}};
+		float vhs[3][MAX_BATCH_VOLUMES] = {{0.0f}};
+
+		bool misses[MAX_BATCH_VOLUMES];
+
+		for (unsigned int i = 0; i < n; i++) {
+			const CMatrix44f mInv = mats[base + i].Invert();
+
+			pis0[i] = mInv.Mul(p0);
+			pis1[i] = mInv.Mul(p1);
+
+			for (unsigned int a = 0; a < 3; a++) {
+				ri0[a][i] = pis0[i][a];
+				ri1[a][i] = pis1[i][a];
+				vhs[a][i] = vols[base + i]->GetHScales()[a];
+			}
+		}
+
+		// check which ray segments miss the (bounding box around) their volume;
+		// only exact operations are used here (min, max, compare, sign-flip)
+		// so both paths agree with the scalar test in Intersect bit-for-bit
+		#ifndef DEDICATED_NOSSE
+		const __m128 signMask = _mm_set1_ps(-0.0f);
+
+		for (unsigned int i = 0; i < n; i += 4) {
+			__m128 miss = _mm_setzero_ps();
+
+			for (unsigned int a = 0; a < 3; a++) {
+				const __m128 r0 = _mm_loadu_ps(&ri0[a][i]);
+				const __m128 r1 = _mm_loadu_ps(&ri1[a][i]);
+				const __m128 vmax = _mm_loadu_ps(&vhs[a][i]);
+				const __m128 vmin = _mm_xor_ps(vmax, signMask);
+				// operand order matches std::min(r0, r1) and std::max(r0, r1)
+				const __m128 rmin = _mm_min_ps(r1, r0);
+				const __m128 rmax = _mm_max_ps(r1, r0);
+
+				miss = _mm_or_ps(miss, _mm_cmplt_ps(rmax, vmin));
+				miss = _mm_or_ps(miss, _mm_cmpgt_ps(rmin, vmax));
+			}
+
+			const int missBits = _mm_movemask_ps(miss);
+
+			for (unsigned int j = 0; j < 4 && (i + j) < n; j++) {
+				misses[i + j] = ((missBits >> j) & 1);
+			}
+		}
+		#else
+		for (unsigned int i = 0; i < n; i++) {
+			misses[i] = false;
+
+			for (unsigned int a = 0; a < 3; a++) {
+				const float rmin = std::min(ri0[a][i], ri1[a][i]);
+				const float rmax = std::max(ri0[a][i], ri1[a][i]);
+
+				misses[i] = misses[i] || (rmax < -vhs[a][i] || rmin > vhs[a][i]);
+			}
+		}
+		#endif
+
+		for (unsigned int i = 0; i < n; i++) {
+			CollisionQuery* q = (qs != NULL)? &qs[base + i]: NULL;
+
+			numContTests += 1;
+
+			if (q != NULL)
+				*q = CollisionQuery();
+
+			hits[base + i] = (!misses[i] && CCollisionHandler::IntersectVolume(vols[base + i], mats[base + i], pis0[i], pis1[i], q));
+			numHits += hits[base + i];
+		}
+	}
+
+	return numHits;
+}
+
+
 bool CCollisionHandler::IntersectEllipsoid(const CollisionVolume* v, const float3& pi0, const float3& pi1, CollisionQuery* q)
 {
 	// transform the volume-space points into (unit) sphere-space (requires fewer
@@ -5,7 +5,6 @@
 
 #include "System/creg/creg_cond.h"
 #include "System/float3.h"
-#include <list>
 
 struct CollisionVolume;
 class CMatrix44f;
@@ -54,7 +53,34 @@ class CCollisionHandler {
 		static bool DetectHit(const CFeature* f, const float3& p0, const float3& p1, CollisionQuery* q = NULL, bool forceTrace = false);
 		static bool MouseHit(const CUnit* u, const float3& p0, const float3& p1, const CollisionVolume* v, CollisionQuery* q);
 
+		/**
+		 * Test one ray segment against a batch of volumes. The volume-space
+		 * bounding-box rejection runs four volumes at a time (SSE), hits are
+		 * resolved by the same code as Intersect(vols[i], mats[i], ...) so
+		 * the results are bit-identical to calling it once per volume.
+		 * @param vols volumes
+		 * @param mats volume transformation matrices
+		 * @param qs receives one query per volume (may be NULL)
+		 * @param hits receives one hit-flag per volume
+		 * @return number of volumes hit
+		 */
+		static unsigned int IntersectBatch(
+			const CollisionVolume* const* vols,
+			const CMatrix44f* mats,
+			unsigned int numVols,
+			const float3& p0,
+			const float3& p1,
+			CollisionQuery* qs,
+			bool* hits
+		);
+
 	private:
+		// maximum number of volumes tested per IntersectBatch pass
+		// (must be a multiple of four for the SSE kernel)
+		static const unsigned int MAX_BATCH_VOLUMES = 32;
+
+		struct PieceTreeBatch;
+
 		// HITTEST_DISC helpers for DetectHit
 		static bool Collision(const CUnit* u, const float3& p, CollisionQuery* q);
 		static bool Collision(const CFeature* f, const float3& p, CollisionQuery* q);
@@ -80,8 +106,15 @@ class CCollisionHandler {
 		 * @param p1 end of ray (in world-coordinates)
 		 */
 		static bool Intersect(const CollisionVolume* v, const CMatrix44f& m, const float3& p0, const float3& p1, CollisionQuery* q);
+		/**
+		 * Narrow-phase part of Intersect, for segments that passed the
+		 * bounding-box test. Transforms the query points back by <m>.
+		 * @param pi0 start of ray (in volume-space)
+		 * @param pi1 end of ray (in volume-space)
+		 */
+		static bool IntersectVolume(const CollisionVolume* v, const CMatrix44f& m, const float3& pi0, const float3& pi1, CollisionQuery* q);
 		static bool IntersectPieceTree(const CUnit* u, const float3& p0, const float3& p1, CollisionQuery* q);
-		static void IntersectPieceTreeHelper(LocalModelPiece* lmp, CMatrix44f mat, const float3& p0, const float3& p1, std::list<CollisionQuery>* hits);
+		static void IntersectPieceTreeHelper(LocalModelPiece* lmp, CMatrix44f mat, const float3& p0, const float3& p1, PieceTreeBatch* batch, CollisionQuery* q);
 
 	public:
 		static bool IntersectEllipsoid(const CollisionVolume* v, const float3& pi0, const float3& pi1, CollisionQuery* q);
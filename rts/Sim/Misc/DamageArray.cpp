@@ -53,6 +53,13 @@ DamageArray DamageArray::operator * (float damageMult) const {
 	return da;
 }
 
+DamageArray& DamageArray::operator *= (float damageMult) {
+	for (unsigned int a = 0; a < damages.size(); ++a)
+		damages[a] *= damageMult;
+
+	return *this;
+}
+
 
 
 void DamageArray::creg_Serialize(creg::ISerializer& s)
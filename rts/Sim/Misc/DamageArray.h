@@ -18,6 +18,7 @@ public:
 
 	DamageArray& operator = (const DamageArray& other);
 	DamageArray operator * (float damageMult) const;
+	DamageArray& operator *= (float damageMult);
 
 	float& operator [] (int i)       { return damages.at(i); }
 	float  operator [] (int i) const { return damages.at(i); }
@@ -4,6 +4,7 @@
 #include <list>
 #include <cstdlib>
 #include <cstring>
+#include <utility>
 
 #include "LosHandler.h"
 #include "ModInfo.h"
@@ -12,6 +13,7 @@
 #include "Sim/Misc/TeamHandler.h"
 #include "Map/ReadMap.h"
 #include "System/Log/ILog.h"
+#include "System/OpenMP_cond.h"
 #include "System/TimeProfiler.h"
 #include "System/creg/STL_Deque.h"
 #include "System/creg/STL_List.h"
@@ -35,15 +37,33 @@ CR_REG_METADATA(LosInstance,(
 		CR_MEMBER(hashNum),
 		CR_MEMBER(baseHeight),
 		CR_MEMBER(toBeDeleted),
+		CR_MEMBER(addQueued),
+		CR_MEMBER(removeQueued),
+		CR_MEMBER(addedAirPos),
 		CR_RESERVED(16)
 		));
 
 void CLosHandler::PostLoad()
 {
+	// restore the sight that was on the maps when saving, and queue what
+	// was still waiting to be added or removed, so it changes in the next
+	// Update, like it would have without saving
 	for (int a = 0; a < LOSHANDLER_MAGIC_PRIME; ++a) {
 		for (std::list<LosInstance*>::iterator li = instanceHash[a].begin(); li != instanceHash[a].end(); ++li) {
-			if ((*li)->refCount) {
-				LosAdd(*li);
+			LosInstance* instance = *li;
+
+			if (instance->removeQueued || (instance->refCount > 0 && !instance->addQueued)) {
+				// losSquares is not saved, so the squares of a pending removal are
+				// calculated at the current position of the instance (addedAirPos
+				// is saved, the air LOS is restored exactly)
+				losAlgo.LosAdd(instance->basePos, instance->losSize, instance->baseHeight, instance->losSquares);
+
+				if (instance->losSize > 0) { losMaps[instance->allyteam].AddMapSquares(instance->losSquares, instance->allyteam, 1); }
+				if (instance->airLosSize > 0) { airLosMaps[instance->allyteam].AddMapArea(instance->addedAirPos, instance->allyteam, instance->airLosSize, 1); }
+			}
+
+			if (instance->addQueued || instance->removeQueued) {
+				QueueInstance(instance);
 			}
 		}
 	}
@@ -85,11 +105,28 @@ CLosHandler::CLosHandler() :
 	losSizeX(std::max(1, gs->mapx >> losMipLevel)),
 	losSizeY(std::max(1, gs->mapy >> losMipLevel)),
 	requireSonarUnderWater(modInfo.requireSonarUnderWater),
-	losAlgo(int2(losSizeX, losSizeY), -1e6f, 15, readmap->GetMIPHeightMapSynced(losMipLevel))
+	visMipLevel(min(min(losMipLevel, airMipLevel), int(CRadarHandler::RADAR_MIP_LEVEL))),
+	visChangesMipLevel(max(max(losMipLevel, airMipLevel), int(CRadarHandler::RADAR_MIP_LEVEL))),
+	invVisDiv(1.0f / (SQUARE_SIZE * (1 << visMipLevel))),
+	invVisChangesDiv(1.0f / (SQUARE_SIZE * (1 << visChangesMipLevel))),
+	visSizeX(std::max(1, gs->mapx >> visMipLevel)),
+	visSizeY(std::max(1, gs->mapy >> visMipLevel)),
+	visChangesSizeX(std::max(1, gs->mapx >> visChangesMipLevel)),
+	visChangesSizeY(std::max(1, gs->mapy >> visChangesMipLevel)),
+	losAlgo(int2(losSizeX, losSizeY), -1e6f, 15, readmap->GetMIPHeightMapSynced(losMipLevel)),
+	queuedInstances(teamHandler->ActiveAllyTeams()),
+	visibilityChanges(teamHandler->ActiveAllyTeams()),
+	globalLOSState(gs->globalLOS, gs->globalLOS + teamHandler->ActiveAllyTeams())
 {
+	commonVisibilityChanges.SetSize(int2(visChangesSizeX, visChangesSizeY));
+
 	for (int a = 0; a < teamHandler->ActiveAllyTeams(); ++a) {
 		losMaps[a].SetSize(losSizeX, losSizeY, true);
 		airLosMaps[a].SetSize(airSizeX, airSizeY, false);
+
+		visibilityChanges[a].SetSize(int2(visChangesSizeX, visChangesSizeY));
+		TrackVisibilityChanges(losMaps[a], losMipLevel, a);
+		TrackVisibilityChanges(airLosMaps[a], airMipLevel, a);
 	}
 }
 
@@ -139,7 +176,6 @@ void CLosHandler::MoveUnit(CUnit* unit, bool redoCurrent)
 		}
 		instance = unit->los;
 		CleanupInstance(instance);
-		instance->losSquares.clear();
 		instance->basePos.x = baseX;
 		instance->basePos.y = baseY;
 		instance->baseSquare = baseSquare; //this could be a problem if several units are sharing the same instance
@@ -189,10 +225,80 @@ void CLosHandler::LosAdd(LosInstance* instance)
 	assert(instance);
 	assert(teamHandler->IsValidAllyTeam(instance->allyteam));
 
-	losAlgo.LosAdd(instance->basePos, instance->losSize, instance->baseHeight, instance->losSquares);
+	instance->addQueued = true;
+	QueueInstance(instance);
+}
+
+
+void CLosHandler::QueueInstance(LosInstance* instance)
+{
+	if (!instance->queued) {
+		instance->queued = true;
+		queuedInstances[instance->allyteam].push_back(instance);
+	}
+}
+
 
-	if (instance->losSize > 0) { losMaps[instance->allyteam].AddMapSquares(instance->losSquares, instance->allyteam, 1); }
-	if (instance->airLosSize > 0) { airLosMaps[instance->allyteam].AddMapArea(instance->baseAirPos, instance->allyteam, instance->airLosSize, 1); }
+void CLosHandler::AddQueuedInstances()
+{
+	SCOPED_TIMER("LOSHandler::AddQueuedInstances");
+
+	// every ally-team only touches its own maps (and visibility changes),
+	// so the results do not depend on the number of threads; the OpenMP
+	// threads are streflop-initialised too (see FPUCheck.cpp), so their
+	// ray-casts give the same results as on the main thread
+	const int numAllyTeams = teamHandler->ActiveAllyTeams();
+
+	int a;
+	#pragma omp parallel for private(a)
+	for (a = 0; a < numAllyTeams; ++a) {
+		AddQueuedInstances(a);
+	}
+}
+
+
+void CLosHandler::AddQueuedInstances(int allyTeam)
+{
+	std::vector<LosInstance*>& queue = queuedInstances[allyTeam];
+
+	// the sight to remove is collected while adding the new one, and only
+	// removed at the end, so squares that stay covered never become zero
+	std::vector<int> removedSquares;
+	std::vector< std::pair<int2, int> > removedAirAreas;
+
+	for (std::vector<LosInstance*>::const_iterator it = queue.begin(); it != queue.end(); ++it) {
+		LosInstance* instance = *it;
+		instance->queued = false;
+
+		if (instance->removeQueued) {
+			instance->removeQueued = false;
+
+			if (instance->losSize > 0) { removedSquares.insert(removedSquares.end(), instance->losSquares.begin(), instance->losSquares.end()); }
+			if (instance->airLosSize > 0) { removedAirAreas.push_back(std::make_pair(instance->addedAirPos, instance->airLosSize)); }
+		}
+
+		instance->losSquares.clear();
+
+		// false if the instance was cleaned up since it was queued
+		if (!instance->addQueued)
+			continue;
+
+		instance->addQueued = false;
+		instance->addedAirPos = instance->baseAirPos;
+
+		losAlgo.LosAdd(instance->basePos, instance->losSize, instance->baseHeight, instance->losSquares);
+
+		if (instance->losSize > 0) { losMaps[allyTeam].AddMapSquares(instance->losSquares, allyTeam, 1); }
+		if (instance->airLosSize > 0) { airLosMaps[allyTeam].AddMapArea(instance->addedAirPos, allyTeam, instance->airLosSize, 1); }
+	}
+
+	losMaps[allyTeam].AddMapSquares(removedSquares, allyTeam, -1);
+
+	for (std::vector< std::pair<int2, int> >::const_iterator it = removedAirAreas.begin(); it != removedAirAreas.end(); ++it) {
+		airLosMaps[allyTeam].AddMapArea(it->first, allyTeam, it->second, -1);
+	}
+
+	queue.clear();
 }
 
 
@@ -228,6 +334,12 @@ void CLosHandler::FreeInstance(LosInstance* instance)
 				return;
 			}
 
+			if (i->queued) {
+				// the queue still points to it, try again later
+				toBeDeleted.push_back(i);
+				return;
+			}
+
 			i->toBeDeleted = false;
 
 			if (i->refCount == 0) {
@@ -268,17 +380,42 @@ void CLosHandler::AllocInstance(LosInstance* instance)
 
 void CLosHandler::CleanupInstance(LosInstance* instance)
 {
-	if (instance->losSize > 0) { losMaps[instance->allyteam].AddMapSquares(instance->losSquares, instance->allyteam, -1); }
-	if (instance->airLosSize > 0) { airLosMaps[instance->allyteam].AddMapArea(instance->baseAirPos, instance->allyteam, instance->airLosSize, -1); }
+	if (instance->addQueued) {
+		// nothing was added since the last cleanup, the squares
+		// which are on the maps (if any) are queued for removal
+		instance->addQueued = false;
+		return;
+	}
+
+	// keep losSquares and addedAirPos until the removal is processed
+	instance->removeQueued = true;
+	QueueInstance(instance);
+}
+
+
+void CLosHandler::TrackVisibilityChanges(CLosMap& map, int mipLevel, int allyTeam)
+{
+	CLosMapChanges* changes = (allyTeam >= 0)? &visibilityChanges[allyTeam]: &commonVisibilityChanges;
+	map.SetChanges(changes, visChangesMipLevel - mipLevel);
 }
 
 
 void CLosHandler::Update()
 {
+	for (int a = 0; a < teamHandler->ActiveAllyTeams(); ++a) {
+		if (gs->globalLOS[a] != globalLOSState[a]) {
+			// every unit has to be checked again
+			globalLOSState[a] = gs->globalLOS[a];
+			visibilityChanges[a].MarkAll();
+		}
+	}
+
 	while (!delayQue.empty() && delayQue.front().timeoutTime < gs->frameNum) {
 		FreeInstance(delayQue.front().instance);
 		delayQue.pop_front();
 	}
+
+	AddQueuedInstances();
 }
 
 
@@ -48,6 +48,9 @@ private:
 		, hashNum(-1)
 		, baseHeight(0.0f)
 		, toBeDeleted(false)
+		, queued(false)
+		, addQueued(false)
+		, removeQueued(false)
 	{}
 
 public:
@@ -63,6 +66,9 @@ public:
 		, hashNum(hashNum)
 		, baseHeight(baseHeight)
 		, toBeDeleted(false)
+		, queued(false)
+		, addQueued(false)
+		, removeQueued(false)
 	{}
 
  	std::vector<int> losSquares;
@@ -76,6 +82,14 @@ public:
 	int hashNum;
 	float baseHeight;
 	bool toBeDeleted;
+	/// whether the instance is in the queue of its ally-team
+	bool queued;
+	/// whether the squares still have to be calculated and added
+	bool addQueued;
+	/// whether the added squares (losSquares, addedAirPos) still have to be removed
+	bool removeQueued;
+	/// baseAirPos at the time the air LOS was added
+	int2 addedAirPos;
 };
 
 /**
@@ -98,6 +112,15 @@ public:
  * LOS is not removed immediately when a unit gets killed. Instead,
  * DelayedFreeInstance is called. This keeps the LosInstance (including the
  * actual sight) alive until 1.5 game seconds after the unit got killed.
+ *
+ * New sight is not added right away either: LosAdd only queues the instance
+ * in the queue of its ally-team, and all queues are processed once per frame
+ * in Update, in parallel, as the ray-casting is expensive and the maps of
+ * different ally-teams are independent. So LOS gained during a frame becomes
+ * visible at the end of it.
+ * Sight that is lost (CleanupInstance) is queued the same way, and removed
+ * only after all the queued sight of the ally-team was added; so a unit that
+ * moves does not leave the LOS of its own squares for part of a frame.
  */
 class CLosHandler : public boost::noncopyable
 {
@@ -143,14 +166,14 @@ public:
 		if (gs->globalLOS[allyTeam]) { return true; }
 		const int gx = pos.x * invLosDiv;
 		const int gz = pos.z * invLosDiv;
-		return !!losMaps[allyTeam].At(gx, gz);
+		return losMaps[allyTeam].IsSetAt(gx, gz);
 	}
 
 	inline bool InAirLos(const float3& pos, int allyTeam) const {
 		if (gs->globalLOS[allyTeam]) { return true; }
 		const int gx = pos.x * invAirDiv;
 		const int gz = pos.z * invAirDiv;
-		return !!airLosMaps[allyTeam].At(gx, gz);
+		return airLosMaps[allyTeam].IsSetAt(gx, gz);
 	}
 
 
@@ -158,14 +181,48 @@ public:
 		if (gs->globalLOS[allyTeam]) { return true; }
 		const int gx = hmx * SQUARE_SIZE * invLosDiv;
 		const int gz = hmz * SQUARE_SIZE * invLosDiv;
-		return !!losMaps[allyTeam].At(gx, gz);
+		return losMaps[allyTeam].IsSetAt(gx, gz);
 	}
 	inline bool InAirLos(int hmx, int hmz, int allyTeam) const {
 		if (gs->globalLOS[allyTeam]) { return true; }
 		const int gx = hmx * SQUARE_SIZE * invAirDiv;
 		const int gz = hmz * SQUARE_SIZE * invAirDiv;
-		return !!airLosMaps[allyTeam].At(gx, gz);
+		return airLosMaps[allyTeam].IsSetAt(gx, gz);
+	}
+
+	/**
+	 * Square on the finest of the LOS, air LOS and radar maps; as long as a
+	 * unit stays on the same one, it stays on the same squares of all maps.
+	 */
+	inline int GetVisibilitySquare(const float3& pos) const {
+		const int gx = std::max(0, std::min(visSizeX - 1, int(pos.x * invVisDiv)));
+		const int gz = std::max(0, std::min(visSizeY - 1, int(pos.z * invVisDiv)));
+		return (gz * visSizeX) + gx;
+	}
+	/// cell of the visibility changes maps
+	inline int GetVisibilityCell(const float3& pos) const {
+		const int gx = std::max(0, std::min(visChangesSizeX - 1, int(pos.x * invVisChangesDiv)));
+		const int gz = std::max(0, std::min(visChangesSizeY - 1, int(pos.z * invVisChangesDiv)));
+		return (gz * visChangesSizeX) + gx;
+	}
+	/**
+	 * Whether any LOS, air LOS, radar or sonar map of the ally-team became
+	 * or stopped being zero in the cell, in or after the given frame.
+	 */
+	inline bool VisibilityChanged(int allyTeam, int cell, int sinceFrame) const {
+		return visibilityChanges[allyTeam].ChangedSince(cell, sinceFrame);
 	}
+	/// the same for the (common) jammer maps
+	inline bool CommonVisibilityChanged(int cell, int sinceFrame) const {
+		return commonVisibilityChanges.ChangedSince(cell, sinceFrame);
+	}
+
+	/**
+	 * Records the changes of a sensor map, which is used to calculate the
+	 * LOS status of units, into the visibility changes of the ally-team
+	 * (or the common ones, if allyTeam is -1).
+	 */
+	void TrackVisibilityChanges(CLosMap& map, int mipLevel, int allyTeam);
 
 	CLosHandler();
 	~CLosHandler();
@@ -186,11 +243,23 @@ public:
 
 	const bool requireSonarUnderWater;
 
+	const int visMipLevel;
+	const int visChangesMipLevel;
+	const float invVisDiv;
+	const float invVisChangesDiv;
+	const int visSizeX;
+	const int visSizeY;
+	const int visChangesSizeX;
+	const int visChangesSizeY;
+
 private:
 	static const unsigned int LOSHANDLER_MAGIC_PRIME = 2309;
 
 	void PostLoad();
 	void LosAdd(LosInstance* instance);
+	void QueueInstance(LosInstance* instance);
+	void AddQueuedInstances();
+	void AddQueuedInstances(int allyTeam);
 	int GetHashNum(CUnit* unit);
 	void AllocInstance(LosInstance* instance);
 	void CleanupInstance(LosInstance* instance);
@@ -209,6 +278,15 @@ private:
 
 	std::deque<DelayedInstance> delayQue;
 
+	/// per ally-team, instances waiting to be added or removed, see LosAdd
+	std::vector< std::vector<LosInstance*> > queuedInstances;
+
+	/// per ally-team, see VisibilityChanged
+	std::vector<CLosMapChanges> visibilityChanges;
+	CLosMapChanges commonVisibilityChanges;
+	/// to notice when global LOS gets toggled
+	std::vector<bool> globalLOSState;
+
 public:
 	void Update();
 	void DelayedFreeInstance(LosInstance* instance);
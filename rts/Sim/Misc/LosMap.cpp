@@ -4,8 +4,10 @@
 
 #include "LosMap.h"
 #include "Map/ReadMap.h"
+#include "Sim/Misc/GlobalSynced.h"
 #include "System/myMath.h"
 #include "System/float3.h"
+#include "System/creg/ISerializer.h"
 
 #ifdef USE_UNSYNCED_HEIGHTMAP
 #include "Game/GlobalUnsynced.h" // for myAllyTeam
@@ -18,46 +20,176 @@
 
 
 
+void CLosMapChanges::SetSize(int2 newSize)
+{
+	size = newSize;
+	frames.clear();
+	frames.resize(size.x * size.y, -1);
+}
+
+void CLosMapChanges::MarkAll()
+{
+	std::fill(frames.begin(), frames.end(), gs->frameNum);
+}
+
+void CLosMapChanges::Mark(int x, int y)
+{
+	x = std::min(x, size.x - 1);
+	y = std::min(y, size.y - 1);
+	frames[y * size.x + x] = gs->frameNum;
+}
+
+
+
 void CLosMap::SetSize(int2 newSize, bool newSendReadmapEvents)
 {
 	size = newSize;
 	sendReadmapEvents = newSendReadmapEvents;
 	map.clear();
 	map.resize(size.x * size.y, 0);
+	bits.clear();
+	bits.resize((size.x * size.y + 31) / 32, 0);
+	overflow.clear();
+	queuedAreas.clear();
+}
+
+void CLosMap::SerializeQueuedMapAreas(creg::ISerializer& s)
+{
+	int numAreas = queuedAreas.size();
+	s.SerializeInt(&numAreas, sizeof(numAreas));
+
+	if (s.IsWriting()) {
+		for (std::map<QueuedArea, int>::const_iterator it = queuedAreas.begin(); it != queuedAreas.end(); ++it) {
+			int area[4] = {it->first.x, it->first.y, it->first.radius, it->second};
+			s.Serialize(area, sizeof(area));
+		}
+	} else {
+		queuedAreas.clear();
+
+		for (int n = 0; n < numAreas; ++n) {
+			int area[4];
+			s.Serialize(area, sizeof(area));
+			queuedAreas[QueuedArea(int2(area[0], area[1]), area[2])] = area[3];
+		}
+	}
+}
+
+void CLosMap::SetChanges(CLosMapChanges* newChanges, int newChangesShift)
+{
+	changes = newChanges;
+	changesShift = newChangesShift;
+}
+
+void CLosMap::UpdateBits()
+{
+	std::fill(bits.begin(), bits.end(), 0);
+	overflow.clear();
+
+	for (int square = 0; square < size.x * size.y; ++square) {
+		if (map[square] != 0) {
+			bits[square >> 5] |= (1u << (square & 31));
+		}
+	}
+}
+
+bool CLosMap::AddToSaturatedSquare(int square, int amount)
+{
+	std::map<int, int>::iterator it = overflow.find(square);
+
+	const int oldCount = map[square] + ((it != overflow.end())? it->second: 0);
+	const int newCount = oldCount + amount;
+
+	if (newCount >= MAX_COUNT) {
+		map[square] = MAX_COUNT;
+
+		if (newCount > MAX_COUNT) {
+			overflow[square] = newCount - MAX_COUNT;
+		} else if (it != overflow.end()) {
+			overflow.erase(it);
+		}
+	} else {
+		map[square] = newCount;
+
+		if (it != overflow.end()) {
+			overflow.erase(it);
+		}
+	}
+
+	if ((oldCount != 0) == (map[square] != 0))
+		return false;
+
+	bits[square >> 5] ^= (1u << (square & 31));
+	return true;
 }
 
 
 
+/// @return the biggest dx with (dx * dx) <= rrx
+static inline int GetAreaSpan(int rrx)
+{
+	// the float result is only a guess, the span has to be exact for sync
+	int dx = (int) math::sqrt(float(rrx));
+
+	while ((dx * dx) > rrx) { --dx; }
+	while (((dx + 1) * (dx + 1)) <= rrx) { ++dx; }
+
+	return dx;
+}
+
+
+void CLosMap::QueueMapArea(int2 pos, int radius, int amount)
+{
+	const QueuedArea area(pos, radius);
+	std::map<QueuedArea, int>::iterator it = queuedAreas.find(area);
+
+	if (it == queuedAreas.end()) {
+		queuedAreas[area] = amount;
+	} else if ((it->second += amount) == 0) {
+		// eg. a unit which was removed and added again at the same position
+		queuedAreas.erase(it);
+	}
+}
+
+void CLosMap::AddQueuedMapAreas(int allyteam)
+{
+	for (std::map<QueuedArea, int>::const_iterator it = queuedAreas.begin(); it != queuedAreas.end(); ++it) {
+		AddMapArea(int2(it->first.x, it->first.y), allyteam, it->first.radius, it->second);
+	}
+
+	queuedAreas.clear();
+}
+
+
 void CLosMap::AddMapArea(int2 pos, int allyteam, int radius, int amount)
 {
 	#ifdef USE_UNSYNCED_HEIGHTMAP
-	static const int LOS2HEIGHT_X = gs->mapx / size.x;
-	static const int LOS2HEIGHT_Z = gs->mapy / size.y;
+	const int LOS2HEIGHT_X = gs->mapx / size.x;
+	const int LOS2HEIGHT_Z = gs->mapy / size.y;
 
 	const bool updateUnsyncedHeightMap = (sendReadmapEvents && allyteam >= 0 && (allyteam == gu->myAllyTeam || gu->spectatingFullView));
 	#endif
 
-	const int sx = std::max(         0, pos.x - radius);
-	const int ex = std::min(size.x - 1, pos.x + radius);
 	const int sy = std::max(         0, pos.y - radius);
 	const int ey = std::min(size.y - 1, pos.y + radius);
 
 	const int rr = (radius * radius);
 
 	for (int lmz = sy; lmz <= ey; ++lmz) {
-		const int rrx = rr - Square(pos.y - lmz);
+		// the squares of the row inside the circle form a single span
+		const int span = GetAreaSpan(rr - Square(pos.y - lmz));
+		const int sx = std::max(         0, pos.x - span);
+		const int ex = std::min(size.x - 1, pos.x + span);
+
 		for (int lmx = sx; lmx <= ex; ++lmx) {
 			const int losMapSquareIdx = (lmz * size.x) + lmx;
 			#ifdef USE_UNSYNCED_HEIGHTMAP
 			const bool squareEnteredLOS = (map[losMapSquareIdx] == 0 && amount > 0);
 			#endif
 
-			if (Square(pos.x - lmx) > rrx) {
-				continue;
+			if (AddToSquare(losMapSquareIdx, amount) && changes != NULL) {
+				changes->Mark(lmx >> changesShift, lmz >> changesShift);
 			}
 
-			map[losMapSquareIdx] += amount;
-
 			#ifdef USE_UNSYNCED_HEIGHTMAP
 			// update unsynced heightmap for all squares that
 			// cover LOSmap square <x, y> (LOSmap resolution
@@ -81,8 +213,8 @@ void CLosMap::AddMapArea(int2 pos, int allyteam, int radius, int amount)
 void CLosMap::AddMapSquares(const std::vector<int>& squares, int allyteam, int amount)
 {
 	#ifdef USE_UNSYNCED_HEIGHTMAP
-	static const int LOS2HEIGHT_X = gs->mapx / size.x;
-	static const int LOS2HEIGHT_Z = gs->mapy / size.y;
+	const int LOS2HEIGHT_X = gs->mapx / size.x;
+	const int LOS2HEIGHT_Z = gs->mapy / size.y;
 
 	const bool updateUnsyncedHeightMap = (sendReadmapEvents && allyteam >= 0 && (allyteam == gu->myAllyTeam || gu->spectatingFullView));
 	#endif
@@ -94,7 +226,9 @@ void CLosMap::AddMapSquares(const std::vector<int>& squares, int allyteam, int a
 		const bool squareEnteredLOS = (map[losMapSquareIdx] == 0 && amount > 0);
 		#endif
 
-		map[losMapSquareIdx] += amount;
+		if (AddToSquare(losMapSquareIdx, amount) && changes != NULL) {
+			changes->Mark((losMapSquareIdx % size.x) >> changesShift, (losMapSquareIdx / size.x) >> changesShift);
+		}
 
 		#ifdef USE_UNSYNCED_HEIGHTMAP
 		if (!updateUnsyncedHeightMap) { continue; }
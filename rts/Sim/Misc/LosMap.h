@@ -5,14 +5,55 @@
 #ifndef LOS_MAP_H
 #define LOS_MAP_H
 
+#include <map>
 #include <vector>
+#include <boost/cstdint.hpp>
 #include "System/Vec2.h"
 
-/// map containing counts of how many units have Line Of Sight (LOS) to each square
+namespace creg {
+	class ISerializer;
+}
+
+/**
+ * Records, at a coarse resolution, in which frame the counts of a group of
+ * CLosMaps last became or stopped being zero (ie. where visibility changed).
+ * Used to skip the LOS status updates of units in areas where nothing
+ * changed, see CUnit::UpdateLosStatus.
+ */
+class CLosMapChanges
+{
+public:
+	CLosMapChanges() : size(0, 0) {}
+
+	void SetSize(int2 size);
+	/// eg. after global LOS was toggled
+	void MarkAll();
+	void Mark(int x, int y);
+
+	/// @return whether the cell changed in or after the given frame
+	bool ChangedSince(int cell, int frame) const { return (frames[cell] >= frame); }
+
+private:
+	int2 size;
+	std::vector<int> frames;
+};
+
+
+/**
+ * map containing counts of how many units have Line Of Sight (LOS) to each square
+ *
+ * Besides the 16 bit counts, a bit-plane with one bit per square tells
+ * whether the count is non-zero; it is kept up to date whenever a count
+ * becomes or stops being zero, and is what the visibility tests use (see
+ * IsSet), as it touches far less memory than the counts.
+ * Counts which do not fit into 16 bits (eg. hundreds of radars stacked on one
+ * spot) saturate, and the excess is kept in a side-table, so they can never
+ * wrap around to zero.
+ */
 class CLosMap
 {
 public:
-	CLosMap() : size(0, 0), sendReadmapEvents(false) {}
+	CLosMap() : size(0, 0), sendReadmapEvents(false), changes(NULL), changesShift(0) {}
 
 	void SetSize(int2 size, bool sendReadmapEvents);
 	void SetSize(int w, int h, bool sendReadmapEvents) { SetSize(int2(w, h), sendReadmapEvents); }
@@ -20,9 +61,33 @@ public:
 	/// circular area, for airLosMap, circular radar maps, jammer maps, ...
 	void AddMapArea(int2 pos, int allyteam, int radius, int amount);
 
+	/**
+	 * Queue a circular area, which is added by the next AddQueuedMapAreas.
+	 * Queued areas of the same position and radius are merged, so an area
+	 * which is removed and added again costs nothing, and many identical
+	 * ones are added in a single pass.
+	 */
+	void QueueMapArea(int2 pos, int radius, int amount);
+	void AddQueuedMapAreas(int allyteam);
+	bool HasQueuedMapAreas() const { return !queuedAreas.empty(); }
+	/// saves or loads the queued areas, which are not added before saving
+	void SerializeQueuedMapAreas(creg::ISerializer& s);
+
 	/// arbitrary area, for losMap, non-circular radar maps, ...
 	void AddMapSquares(const std::vector<int>& squares, int allyteam, int amount);
 
+	/**
+	 * Record all squares which become or stop being zero in the given
+	 * changes map, which has a coarser resolution (by changesShift mip levels).
+	 */
+	void SetChanges(CLosMapChanges* changes, int changesShift);
+
+	/**
+	 * Rebuild the bit-plane and drop the overflow side-table, after the counts
+	 * were written directly through front() (eg. when loading a savegame).
+	 */
+	void UpdateBits();
+
 	int operator[] (int square) const { return map[square]; }
 
 	int At(int x, int y) const {
@@ -31,13 +96,66 @@ public:
 		return map[y * size.x + x];
 	}
 
+	/// @return whether the count of the square is non-zero
+	bool IsSet(int square) const { return ((bits[square >> 5] >> (square & 31)) & 1); }
+
+	bool IsSetAt(int x, int y) const {
+		x = std::max(0, std::min(size.x - 1, x));
+		y = std::max(0, std::min(size.y - 1, y));
+		return IsSet(y * size.x + x);
+	}
+
 	// FIXME temp fix for CBaseGroundDrawer and AI interface, which need raw data
 	unsigned short& front() { return map.front(); }
 
 protected:
+	/// @return whether the count became or stopped being zero
+	bool AddToSquare(int square, int amount) {
+		unsigned short& count = map[square];
+
+		if (count == MAX_COUNT || (count + amount) >= MAX_COUNT)
+			return AddToSaturatedSquare(square, amount);
+
+		const bool wasSet = (count != 0);
+		count += amount;
+
+		if (wasSet == (count != 0))
+			return false;
+
+		bits[square >> 5] ^= (1u << (square & 31));
+		return true;
+	}
+
+	bool AddToSaturatedSquare(int square, int amount);
+
+protected:
+	struct QueuedArea {
+		QueuedArea(int2 pos, int radius) : x(pos.x), y(pos.y), radius(radius) {}
+
+		bool operator < (const QueuedArea& a) const {
+			if (y != a.y) return (y < a.y);
+			if (x != a.x) return (x < a.x);
+			return (radius < a.radius);
+		}
+
+		int x;
+		int y;
+		int radius;
+	};
+
+	static const int MAX_COUNT = 0xFFFF;
+
 	int2 size;
 	std::vector<unsigned short> map;
+	std::vector<boost::uint32_t> bits;
+	/// count - MAX_COUNT, of the squares whose count is saturated
+	std::map<int, int> overflow;
+	/// summed amounts, see QueueMapArea
+	std::map<QueuedArea, int> queuedAreas;
 	bool sendReadmapEvents;
+
+	CLosMapChanges* changes;
+	int changesShift;
 };
 
 
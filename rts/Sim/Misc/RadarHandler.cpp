@@ -5,6 +5,7 @@
 #include "LosHandler.h"
 #include "Map/ReadMap.h"
 #include "Sim/Misc/TeamHandler.h"
+#include "System/OpenMP_cond.h"
 #include "System/TimeProfiler.h"
 
 
@@ -46,11 +47,42 @@ void CRadarHandler::Serialize(creg::ISerializer& s)
 	}
 	s.Serialize(&commonJammerMap.front(), size);
 	s.Serialize(&commonSonarJammerMap.front(), size);
+
+	// the queued areas are saved as they are, adding them here would
+	// change the maps (and the frame of their visibility changes) at a
+	// client-specific point, instead of in Update
+	for (int a = 0; a < teamHandler->ActiveAllyTeams(); ++a) {
+		airRadarMaps[a].SerializeQueuedMapAreas(s);
+		sonarMaps[a].SerializeQueuedMapAreas(s);
+		jammerMaps[a].SerializeQueuedMapAreas(s);
+#ifdef SONAR_JAMMER_MAPS
+		sonarJammerMaps[a].SerializeQueuedMapAreas(s);
+#endif
+		seismicMaps[a].SerializeQueuedMapAreas(s);
+	}
+	commonJammerMap.SerializeQueuedMapAreas(s);
+	commonSonarJammerMap.SerializeQueuedMapAreas(s);
+	s.Serialize(&hasQueuedAreas, sizeof(hasQueuedAreas));
+
+	if (!s.IsWriting()) {
+		for (int a = 0; a < teamHandler->ActiveAllyTeams(); ++a) {
+			radarMaps[a].UpdateBits();
+			airRadarMaps[a].UpdateBits();
+			sonarMaps[a].UpdateBits();
+			jammerMaps[a].UpdateBits();
+#ifdef SONAR_JAMMER_MAPS
+			sonarJammerMaps[a].UpdateBits();
+#endif
+			seismicMaps[a].UpdateBits();
+		}
+		commonJammerMap.UpdateBits();
+		commonSonarJammerMap.UpdateBits();
+	}
 }
 
 
 CRadarHandler::CRadarHandler(bool circularRadar)
-: radarMipLevel(3),
+: radarMipLevel(RADAR_MIP_LEVEL),
   radarDiv(SQUARE_SIZE * (1 << radarMipLevel)),
   invRadarDiv(1.0f / radarDiv),
   circularRadar(circularRadar),
@@ -58,7 +90,8 @@ CRadarHandler::CRadarHandler(bool circularRadar)
   xsize(std::max(1, gs->mapx >> radarMipLevel)),
   zsize(std::max(1, gs->mapy >> radarMipLevel)),
   targFacEffect(2),
-  radarAlgo(int2(xsize, zsize), -1000, 20, readmap->GetMIPHeightMapSynced(radarMipLevel))
+  radarAlgo(int2(xsize, zsize), -1000, 20, readmap->GetMIPHeightMapSynced(radarMipLevel)),
+  hasQueuedAreas(false)
 {
 	commonJammerMap.SetSize(xsize, zsize, false);
 	commonSonarJammerMap.SetSize(xsize, zsize, false);
@@ -74,6 +107,16 @@ CRadarHandler::CRadarHandler(bool circularRadar)
 	sonarJammerMaps.resize(teamHandler->ActiveAllyTeams(), tmp);
 #endif
 	radarErrorSize.resize(teamHandler->ActiveAllyTeams(), 96);
+
+	// all maps used by CUnit::CalcLosStatus (seismic and ally-team jammer
+	// maps are not)
+	for (int a = 0; a < teamHandler->ActiveAllyTeams(); ++a) {
+		loshandler->TrackVisibilityChanges(radarMaps[a], radarMipLevel, a);
+		loshandler->TrackVisibilityChanges(airRadarMaps[a], radarMipLevel, a);
+		loshandler->TrackVisibilityChanges(sonarMaps[a], radarMipLevel, a);
+	}
+	loshandler->TrackVisibilityChanges(commonJammerMap, radarMipLevel, -1);
+	loshandler->TrackVisibilityChanges(commonSonarJammerMap, radarMipLevel, -1);
 }
 
 
@@ -110,30 +153,31 @@ void CRadarHandler::MoveUnit(CUnit* unit)
 		RemoveUnit(unit);
 
 		if (unit->jammerRadius) {
-			jammerMaps[unit->allyteam].AddMapArea(newPos, -123, unit->jammerRadius, 1);
-			commonJammerMap.AddMapArea(newPos, -123, unit->jammerRadius, 1);
+			jammerMaps[unit->allyteam].QueueMapArea(newPos, unit->jammerRadius, 1);
+			commonJammerMap.QueueMapArea(newPos, unit->jammerRadius, 1);
 		}
 		if (unit->sonarJamRadius) {
 #ifdef SONAR_JAMMER_MAPS
-			sonarJammerMaps[unit->allyteam].AddMapArea(newPos, -123, unit->sonarJamRadius, 1);
+			sonarJammerMaps[unit->allyteam].QueueMapArea(newPos, unit->sonarJamRadius, 1);
 #endif
-			commonSonarJammerMap.AddMapArea(newPos, -123, unit->sonarJamRadius, 1);
+			commonSonarJammerMap.QueueMapArea(newPos, unit->sonarJamRadius, 1);
 		}
 		if (unit->radarRadius) {
-			airRadarMaps[unit->allyteam].AddMapArea(newPos, -123, unit->radarRadius, 1);
+			airRadarMaps[unit->allyteam].QueueMapArea(newPos, unit->radarRadius, 1);
 			if (!circularRadar) {
 				radarAlgo.LosAdd(newPos, unit->radarRadius, unit->radarHeight, unit->radarSquares);
 				radarMaps[unit->allyteam].AddMapSquares(unit->radarSquares, -123, 1);
 			}
 		}
 		if (unit->sonarRadius) {
-			sonarMaps[unit->allyteam].AddMapArea(newPos, -123, unit->sonarRadius, 1);
+			sonarMaps[unit->allyteam].QueueMapArea(newPos, unit->sonarRadius, 1);
 		}
 		if (unit->seismicRadius) {
-			seismicMaps[unit->allyteam].AddMapArea(newPos, -123, unit->seismicRadius, 1);
+			seismicMaps[unit->allyteam].QueueMapArea(newPos, unit->seismicRadius, 1);
 		}
 		unit->oldRadarPos = newPos;
 		unit->hasRadarPos = true;
+		hasQueuedAreas = true;
 	}
 }
 
@@ -148,28 +192,64 @@ void CRadarHandler::RemoveUnit(CUnit* unit)
 
 	if (unit->hasRadarPos) {
 		if (unit->jammerRadius) {
-			jammerMaps[unit->allyteam].AddMapArea(unit->oldRadarPos, -123, unit->jammerRadius, -1);
-			commonJammerMap.AddMapArea(unit->oldRadarPos, -123, unit->jammerRadius, -1);
+			jammerMaps[unit->allyteam].QueueMapArea(unit->oldRadarPos, unit->jammerRadius, -1);
+			commonJammerMap.QueueMapArea(unit->oldRadarPos, unit->jammerRadius, -1);
 		}
 		if (unit->sonarJamRadius) {
 #ifdef SONAR_JAMMER_MAPS
-			sonarJammerMaps[unit->allyteam].AddMapArea(unit->oldRadarPos, -123, unit->sonarJamRadius, -1);
+			sonarJammerMaps[unit->allyteam].QueueMapArea(unit->oldRadarPos, unit->sonarJamRadius, -1);
 #endif
-			commonSonarJammerMap.AddMapArea(unit->oldRadarPos, -123, unit->sonarJamRadius, -1);
+			commonSonarJammerMap.QueueMapArea(unit->oldRadarPos, unit->sonarJamRadius, -1);
 		}
 		if (unit->radarRadius) {
-			airRadarMaps[unit->allyteam].AddMapArea(unit->oldRadarPos, -123, unit->radarRadius, -1);
+			airRadarMaps[unit->allyteam].QueueMapArea(unit->oldRadarPos, unit->radarRadius, -1);
 			if (!circularRadar) {
 				radarMaps[unit->allyteam].AddMapSquares(unit->radarSquares, -123, -1);
 				unit->radarSquares.clear();
 			}
 		}
 		if (unit->sonarRadius) {
-			sonarMaps[unit->allyteam].AddMapArea(unit->oldRadarPos, -123, unit->sonarRadius, -1);
+			sonarMaps[unit->allyteam].QueueMapArea(unit->oldRadarPos, unit->sonarRadius, -1);
 		}
 		if (unit->seismicRadius) {
-			seismicMaps[unit->allyteam].AddMapArea(unit->oldRadarPos, -123, unit->seismicRadius, -1);
+			seismicMaps[unit->allyteam].QueueMapArea(unit->oldRadarPos, unit->seismicRadius, -1);
 		}
 		unit->hasRadarPos = false;
+		hasQueuedAreas = true;
+	}
+}
+
+
+void CRadarHandler::AddQueuedAreas()
+{
+	SCOPED_TIMER("RadarHandler::AddQueuedAreas");
+
+	// every task only touches its own maps (and visibility changes), so
+	// the results do not depend on the number of threads
+	const int numMapsIndices = teamHandler->ActiveAllyTeams() + 1;
+
+	int i;
+	#pragma omp parallel for private(i)
+	for (i = 0; i < numMapsIndices; ++i) {
+		AddQueuedAreas(i);
+	}
+
+	hasQueuedAreas = false;
+}
+
+void CRadarHandler::AddQueuedAreas(int mapsIndex)
+{
+	if (mapsIndex == teamHandler->ActiveAllyTeams()) {
+		// both record their changes into the common visibility changes
+		commonJammerMap.AddQueuedMapAreas(-123);
+		commonSonarJammerMap.AddQueuedMapAreas(-123);
+	} else {
+		airRadarMaps[mapsIndex].AddQueuedMapAreas(-123);
+		sonarMaps[mapsIndex].AddQueuedMapAreas(-123);
+		jammerMaps[mapsIndex].AddQueuedMapAreas(-123);
+#ifdef SONAR_JAMMER_MAPS
+		sonarJammerMaps[mapsIndex].AddQueuedMapAreas(-123);
+#endif
+		seismicMaps[mapsIndex].AddQueuedMapAreas(-123);
 	}
 }
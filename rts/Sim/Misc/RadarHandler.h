@@ -26,12 +26,27 @@ class CRadarHandler : public boost::noncopyable
 
 
 public:
+	static const int RADAR_MIP_LEVEL = 3;
+
 	CRadarHandler(bool circularRadar);
 	~CRadarHandler();
 
 	void MoveUnit(CUnit* unit);
 	void RemoveUnit(CUnit* unit);
 
+	/**
+	 * The circular coverage areas of moved and removed units are only
+	 * queued (see CLosMap::QueueMapArea), and added to the maps here, once
+	 * per frame; the maps of all ally-teams are updated in parallel.
+	 * Like with LOS, coverage gained or lost during a frame becomes visible
+	 * at the end of it.
+	 */
+	void Update() {
+		if (hasQueuedAreas) {
+			AddQueuedAreas();
+		}
+	}
+
 	inline int GetSquare(const float3& pos) const
 	{
 		const int gx = pos.x * invRadarDiv;
@@ -46,14 +61,14 @@ public:
 
 		if (pos.y < 0.0f) {
 			// position is underwater, only sonar can see it
-			return (sonarMaps[allyTeam][square] && !commonSonarJammerMap[square]);
+			return (sonarMaps[allyTeam].IsSet(square) && !commonSonarJammerMap.IsSet(square));
 		}
 		else if (circularRadar) {
 			// position is not in water, but height is irrelevant for this mode
-			return (airRadarMaps[allyTeam][square] && !commonJammerMap[square]);
+			return (airRadarMaps[allyTeam].IsSet(square) && !commonJammerMap.IsSet(square));
 		}
 		else {
-			return (radarMaps[allyTeam][square] && !commonJammerMap[square]);
+			return (radarMaps[allyTeam].IsSet(square) && !commonJammerMap.IsSet(square));
 		}
 	}
 
@@ -66,7 +81,7 @@ public:
 				return false;
 			}
 
-			return (!!sonarMaps[allyTeam][square] && !commonSonarJammerMap[square]);
+			return (sonarMaps[allyTeam].IsSet(square) && !commonSonarJammerMap.IsSet(square));
 		}
 		else if (circularRadar && unit->useAirLos) {
 			// circular mode and unit is an aircraft (and currently not landed)
@@ -74,7 +89,7 @@ public:
 				return false;
 			}
 
-			return (airRadarMaps[allyTeam][square] && !commonJammerMap[square]);
+			return (airRadarMaps[allyTeam].IsSet(square) && !commonJammerMap.IsSet(square));
 		}
 		else {
 			// (surface) units that are not completely submerged can potentially
@@ -82,13 +97,13 @@ public:
 			// the model is still inside water)
 			const bool radarVisible =
 				(!unit->stealth || unit->beingBuilt) &&
-				radarMaps[allyTeam][square] &&
-				!commonJammerMap[square];
+				radarMaps[allyTeam].IsSet(square) &&
+				!commonJammerMap.IsSet(square);
 			const bool sonarVisible = 
 				(unit->pos.y < 0.0f) &&
 				(!unit->sonarStealth || unit->beingBuilt) &&
-				sonarMaps[allyTeam][square] &&
-				!commonSonarJammerMap[square];
+				sonarMaps[allyTeam].IsSet(square) &&
+				!commonSonarJammerMap.IsSet(square);
 
 			return (radarVisible || sonarVisible);
 		}
@@ -96,7 +111,7 @@ public:
 
 	bool InSeismicDistance(const CUnit* unit, int allyTeam) const {
 		const int square = GetSquare(unit->pos);
-		return !!seismicMaps[allyTeam][square];
+		return seismicMaps[allyTeam].IsSet(square);
 	}
 
 	const int radarMipLevel;
@@ -123,7 +138,12 @@ public:
 	float targFacEffect;
 
 private:
+	void AddQueuedAreas();
+	/// the maps of an ally-team, or the common maps for the index past those
+	void AddQueuedAreas(int mapsIndex);
+
 	CLosAlgorithm radarAlgo;
+	bool hasQueuedAreas;
 
 	void Serialize(creg::ISerializer& s);
 };
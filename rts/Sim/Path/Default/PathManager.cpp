@@ -6,6 +6,7 @@
 #include "PathFinder.h"
 #include "PathEstimator.h"
 #include "Map/MapInfo.h"
+#include "Sim/Misc/GlobalConstants.h"
 #include "Sim/Misc/GlobalSynced.h"
 #include "Sim/MoveTypes/MoveDefHandler.h"
 #include "Sim/MoveTypes/MoveMath/MoveMath.h"
@@ -101,7 +102,15 @@ unsigned int CPathManager::RequestPath(
 	// It seems more logical to subtract goalRadius / SQUARE_SIZE here
 	const float goalDist2D = pfDef->Heuristic(startPos.x / SQUARE_SIZE, startPos.z / SQUARE_SIZE) + math::fabs(goalPos.y - startPos.y) / SQUARE_SIZE;
 
-	if (goalDist2D < DETAILED_DISTANCE) {
+	const GroupPath* groupPath = (synced && goalDist2D >= DETAILED_DISTANCE)? GetGroupPath(moveDef, startPos, goalPos): NULL;
+
+	if (groupPath != NULL) {
+		// follow the coarse path of the caller's group, only
+		// the refinements below are specific to this request
+		newPath->lowResPath = groupPath->lowResPath;
+		newPath->medResPath = groupPath->medResPath;
+		result = IPath::Ok;
+	} else if (goalDist2D < DETAILED_DISTANCE) {
 		result = maxResPF->GetPath(*moveDef, startPos, *pfDef, newPath->maxResPath, true, false, MAX_SEARCHED_NODES_PF >> 3, true, caller, synced);
 
 		#if (PM_UNCONSTRAINED_MAXRES_FALLBACK_SEARCH == 1)
@@ -186,6 +195,81 @@ unsigned int CPathManager::RequestPath(
 }
 
 
+/*
+Search the coarse path of a group once, so RequestPath can hand
+it to all units of the group which ask for a path in the next few
+frames (they do so right when they get their move orders).
+*/
+void CPathManager::RequestGroupPath(
+	const MoveDef* md,
+	const float3& startPos,
+	float startRadius,
+	const float3& goalPos,
+	float goalRadius
+) {
+	SCOPED_TIMER("PathManager::RequestGroupPath");
+
+	const MoveDef* moveDef = moveDefHandler->moveDefs[md->pathType];
+
+	float3 sp(startPos); sp.ClampInBounds();
+	float3 gp(goalPos); gp.ClampInBounds();
+
+	// short moves only need detailed searches, which can not be shared
+	const float groupDist2D = sp.distance2D(gp) / SQUARE_SIZE;
+
+	if ((groupDist2D - goalRadius / SQUARE_SIZE) < DETAILED_DISTANCE)
+		return;
+
+	CRangedGoalWithCircularConstraint pfDef(sp, gp, goalRadius, 3.0f, 2000);
+
+	GroupPath groupPath;
+	IPath::SearchResult result = IPath::Error;
+
+	// the refinements skip the waypoints near each unit, but units
+	// farther away from the group center than this would still have
+	// to double back to the first remaining one; they search their
+	// own paths instead
+	if (groupDist2D < ESTIMATE_DISTANCE) {
+		result = medResPE->GetPath(*moveDef, sp, pfDef, groupPath.medResPath, MAX_SEARCHED_NODES_PE >> 3, true);
+		startRadius = std::min(startRadius, MIN_DETAILED_DISTANCE * SQUARE_SIZE);
+	} else {
+		result = lowResPE->GetPath(*moveDef, sp, pfDef, groupPath.lowResPath, MAX_SEARCHED_NODES_PE >> 3, true);
+		startRadius = std::min(startRadius, MIN_ESTIMATE_DISTANCE * SQUARE_SIZE);
+	}
+
+	// if the group can not reach the goal area, each unit has to
+	// find out on its own how close it can get
+	if (result != IPath::Ok)
+		return;
+
+	groupPath.startPos = sp;
+	groupPath.goalPos = gp;
+	groupPath.startRadius = startRadius;
+	groupPath.goalRadius = goalRadius;
+	groupPath.pathType = moveDef->pathType;
+	groupPath.timeout = gs->frameNum + UNIT_SLOWUPDATE_RATE * 2;
+
+	groupPaths.push_back(groupPath);
+}
+
+const CPathManager::GroupPath* CPathManager::GetGroupPath(const MoveDef* moveDef, const float3& startPos, const float3& goalPos) const
+{
+	// the most recent group path is the most likely match
+	for (std::list<GroupPath>::const_reverse_iterator gpi = groupPaths.rbegin(); gpi != groupPaths.rend(); ++gpi) {
+		if (gpi->pathType != moveDef->pathType)
+			continue;
+		if (gpi->startPos.SqDistance2D(startPos) > Square(gpi->startRadius))
+			continue;
+		if (gpi->goalPos.SqDistance2D(goalPos) > Square(gpi->goalRadius))
+			continue;
+
+		return &(*gpi);
+	}
+
+	return NULL;
+}
+
+
 /*
 Store a new multipath into the pathmap.
 */
@@ -409,6 +493,10 @@ void CPathManager::Update()
 	maxResPF->UpdateHeatMap();
 	medResPE->Update();
 	lowResPE->Update();
+
+	while (!groupPaths.empty() && groupPaths.front().timeout < gs->frameNum) {
+		groupPaths.pop_front();
+	}
 }
 
 
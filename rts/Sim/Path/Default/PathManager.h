@@ -3,6 +3,7 @@
 #ifndef PATHMANAGER_H
 #define PATHMANAGER_H
 
+#include <list>
 #include <map>
 #include <boost/cstdint.hpp> /* Replace with <stdint.h> if appropriate */
 
@@ -49,6 +50,14 @@ public:
 		bool synced = true
 	);
 
+	void RequestGroupPath(
+		const MoveDef* moveDef,
+		const float3& startPos,
+		float startRadius,
+		const float3& goalPos,
+		float goalRadius
+	);
+
 	/**
 	 * Returns waypoints of the max-resolution path segments.
 	 * @param pathID
@@ -125,7 +134,22 @@ private:
 		CSolidObject* caller;
 	};
 
+	/// coarse path shared by a group of units, see RequestGroupPath
+	struct GroupPath {
+		IPath::Path lowResPath;
+		IPath::Path medResPath;
+
+		float3 startPos;
+		float3 goalPos;
+		float startRadius;
+		float goalRadius;
+
+		int pathType;
+		int timeout;
+	};
+
 	inline MultiPath* GetMultiPath(int pathID) const;
+	const GroupPath* GetGroupPath(const MoveDef* moveDef, const float3& startPos, const float3& goalPos) const;
 	unsigned int Store(MultiPath* path);
 	void LowRes2MedRes(MultiPath& path, const float3& startPos, const CSolidObject* owner, bool synced) const;
 	void MedRes2MaxRes(MultiPath& path, const float3& startPos, const CSolidObject* owner, bool synced) const;
@@ -136,6 +160,9 @@ private:
 
 	std::map<unsigned int, MultiPath*> pathMap;
 	unsigned int nextPathID;
+
+	/// ordered by timeout
+	std::list<GroupPath> groupPaths;
 };
 
 inline CPathManager::MultiPath* CPathManager::GetMultiPath(int pathID) const {
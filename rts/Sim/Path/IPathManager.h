@@ -134,6 +134,35 @@ public:
 		bool synced = true
 	) { return 0; }
 
+	/**
+	 * Computes one coarse path for a group of units which are given a move
+	 * order to the same area at once (eg. a formation move), so they do not
+	 * each repeat the same long-range search.
+	 * For a short while, synced paths requested by units of the group then
+	 * follow this path, and only the parts near each unit and near its own
+	 * goal are searched in detail.
+	 *
+	 * @param moveDef
+	 *     The move details shared by the units of the group.
+	 * @param startPos
+	 *     The center of the group.
+	 * @param startRadius
+	 *     Paths requested from within this distance of startPos can follow
+	 *     the group path.
+	 * @param goalPos
+	 *     The center of the area the group moves to.
+	 * @param goalRadius
+	 *     Paths requested to goals within this distance of goalPos can
+	 *     follow the group path.
+	 */
+	virtual void RequestGroupPath(
+		const MoveDef* moveDef,
+		const float3& startPos,
+		float startRadius,
+		const float3& goalPos,
+		float goalRadius
+	) {}
+
 	/**
 	 * Whenever there are any changes in the terrain
 	 * (examples: explosions, new buildings, etc.)
@@ -12,6 +12,11 @@ CR_REG_METADATA(Command, (
 	CR_RESERVED(16)
 ));
 
+CR_BIND(CommandParams, );
+CR_REG_METADATA(CommandParams, (
+	CR_SERIALIZER(Serialize)
+));
+
 CR_BIND(CommandDescription, );
 CR_REG_METADATA(CommandDescription, (
 	CR_MEMBER(id),
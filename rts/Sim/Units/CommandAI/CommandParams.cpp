@@ -0,0 +1,65 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "CommandParams.h"
+#include "System/Log/ILog.h"
+#include "System/Platform/CrashHandler.h"
+#include "System/maindefines.h"
+
+const CommandParams::size_type CommandParams::INLINE_CAPACITY;
+
+
+void CommandParams::Grow(size_type n)
+{
+	float* newParams = new float[n];
+	std::copy(begin(), end(), newParams);
+
+	if (params != inlineParams)
+		delete[] params;
+
+	params = newParams;
+	maxParams = n;
+}
+
+
+const float& CommandParams::SafeElement(size_type idx) const
+{
+	static const float def = 0.0f;
+
+	if (showError) {
+		showError = false;
+		LOG_L(L_ERROR, "[%s const] index "_STPF_" out of bounds! (size "_STPF_")", __FUNCTION__, idx, size());
+		CrashHandler::OutputStacktrace();
+	}
+
+	return def;
+}
+
+float& CommandParams::SafeElement(size_type idx)
+{
+	static float def = 0.0f;
+
+	if (showError) {
+		showError = false;
+		LOG_L(L_ERROR, "[%s] index "_STPF_" out of bounds! (size "_STPF_")", __FUNCTION__, idx, size());
+		CrashHandler::OutputStacktrace();
+	}
+
+	return def;
+}
+
+
+void CommandParams::Serialize(creg::ISerializer& s)
+{
+	unsigned int count = numParams;
+	s.SerializeInt(&count, sizeof(count));
+
+	if (!s.IsWriting()) {
+		clear();
+		reserve(count);
+		numParams = count;
+	}
+
+	if (count > 0) {
+		s.Serialize(params, count * sizeof(float));
+	}
+}
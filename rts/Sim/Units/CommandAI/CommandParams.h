@@ -0,0 +1,125 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef COMMAND_PARAMS_H
+#define COMMAND_PARAMS_H
+
+#include <algorithm>
+#include <cstddef>
+
+#include "System/creg/creg_cond.h"
+
+/**
+ * Parameter list of a Command.
+ * Nearly all commands have only a few parameters (a position, an object ID,
+ * a build-facing, an area radius), which are stored inline, so creating,
+ * copying and queueing such commands does not allocate memory; only longer
+ * lists (eg. CMD_INSERT wrapping a move, or custom commands) are moved to the
+ * heap.
+ *
+ * Out-of-range accesses behave like those of safe_vector: an error is logged
+ * (once per list) and a dummy value is returned.
+ */
+class CommandParams
+{
+	CR_DECLARE_STRUCT(CommandParams);
+
+public:
+	typedef float value_type;
+	typedef size_t size_type;
+	typedef float* iterator;
+	typedef const float* const_iterator;
+
+	/// a position and two more values, enough for all area commands
+	static const size_type INLINE_CAPACITY = 5;
+
+public:
+	CommandParams()
+		: params(inlineParams)
+		, numParams(0)
+		, maxParams(INLINE_CAPACITY)
+		, showError(true)
+	{}
+
+	CommandParams(const CommandParams& p)
+		: params(inlineParams)
+		, numParams(0)
+		, maxParams(INLINE_CAPACITY)
+		, showError(true)
+	{
+		*this = p;
+	}
+
+	~CommandParams() {
+		if (params != inlineParams)
+			delete[] params;
+	}
+
+	CommandParams& operator = (const CommandParams& p) {
+		if (this != &p) {
+			reserve(p.numParams);
+			std::copy(p.begin(), p.end(), params);
+			numParams = p.numParams;
+		}
+		return *this;
+	}
+
+	bool empty() const { return (numParams == 0); }
+	size_type size() const { return numParams; }
+	size_type capacity() const { return maxParams; }
+
+	/// keeps the allocated memory, like std::vector
+	void clear() { numParams = 0; }
+
+	void reserve(size_type n) {
+		if (n > maxParams) {
+			Grow(n);
+		}
+	}
+
+	void push_back(float p) {
+		if (numParams == maxParams) {
+			Grow(maxParams * 2);
+		}
+		params[numParams++] = p;
+	}
+
+	const float& operator[] (size_type i) const {
+		if (i >= numParams)
+			return SafeElement(i);
+		return params[i];
+	}
+	float& operator[] (size_type i) {
+		if (i >= numParams)
+			return SafeElement(i);
+		return params[i];
+	}
+
+	const float& at(size_type i) const { return (*this)[i]; }
+	float& at(size_type i) { return (*this)[i]; }
+
+	iterator       begin()       { return params; }
+	const_iterator begin() const { return params; }
+	iterator       end()         { return (params + numParams); }
+	const_iterator end()   const { return (params + numParams); }
+
+private:
+	void Grow(size_type n);
+
+	const float& SafeElement(size_type i) const;
+	float& SafeElement(size_type i);
+
+	void Serialize(creg::ISerializer& s);
+
+private:
+	/// points to inlineParams, or to heap memory
+	float* params;
+
+	unsigned int numParams;
+	unsigned int maxParams;
+
+	float inlineParams[INLINE_CAPACITY];
+
+	mutable bool showError;
+};
+
+#endif // COMMAND_PARAMS_H
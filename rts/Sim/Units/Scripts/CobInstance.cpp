@@ -76,10 +76,10 @@ CCobInstance::~CCobInstance()
 	//Destroy();
 
 	for (int animType = ATurn; animType <= AMove; animType++) {
-		for (std::list<AnimInfo *>::iterator i = anims[animType].begin(); i != anims[animType].end(); ++i) {
+		for (std::vector<AnimInfo>::iterator i = anims[animType].begin(); i != anims[animType].end(); ++i) {
 			// All threads blocking on animations can be killed safely from here since the scheduler does not
 			// know about them
-			for (std::list<IAnimListener *>::iterator j = (*i)->listeners.begin(); j != (*i)->listeners.end(); ++j) {
+			for (std::vector<IAnimListener*>::iterator j = i->listeners.begin(); j != i->listeners.end(); ++j) {
 				delete *j;
 			}
 			// the anims are deleted in ~CUnitScript
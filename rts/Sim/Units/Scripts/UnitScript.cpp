@@ -73,6 +73,7 @@ CUnitScript::CUnitScript(CUnit* unit, const std::vector<LocalModelPiece*>& piece
 	: unit(unit)
 	, yardOpen(false)
 	, busy(false)
+	, engineAnimIdx(-1)
 	, hasSetSFXOccupy(false)
 	, hasRockUnit(false)
 	, hasStartBuilding(false)
@@ -84,19 +85,9 @@ CUnitScript::CUnitScript(CUnit* unit, const std::vector<LocalModelPiece*>& piece
 
 CUnitScript::~CUnitScript()
 {
-	bool haveAnimations = false;
-
-	for (int animType = ATurn; animType <= AMove; animType++) {
-		for (std::list<AnimInfo*>::iterator i = anims[animType].begin(); i != anims[animType].end(); ++i) {
-			// anim listeners are not owned by the anim in general, so don't delete them here
-			delete *i;
-		}
-
-		haveAnimations = (haveAnimations || !anims[animType].empty());
-	}
-
+	// anim listeners are not owned by the anim in general, so they are not deleted here
 	// Remove us from possible animation ticking
-	if (haveAnimations)
+	if (HaveAnimations())
 		GUnitScriptEngine.RemoveInstance(this);
 }
 
@@ -108,12 +99,10 @@ CUnitScript::~CUnitScript()
  * @brief Unblocks all threads waiting on an animation
  * @param anim AnimInfo the corresponding animation
  */
-void CUnitScript::UnblockAll(AnimInfo* anim)
+void CUnitScript::UnblockAll(AnimInfo& anim)
 {
-	std::list<IAnimListener *>::iterator li;
-
-	for (li = anim->listeners.begin(); li != anim->listeners.end(); ++li) {
-		(*li)->AnimFinished(anim->type, anim->piece, anim->axis);
+	for (std::vector<IAnimListener*>::const_iterator li = anim.listeners.begin(); li != anim.listeners.end(); ++li) {
+		(*li)->AnimFinished(anim.type, anim.piece, anim.axis);
 	}
 }
 
@@ -215,50 +204,49 @@ bool CUnitScript::DoSpin(float& cur, float dest, float &speed, float accel, int
 
 
 
-void CUnitScript::TickAnims(int deltaTime, AnimType type, std::list< std::list<AnimInfo*>::iterator >& doneAnims) {
+void CUnitScript::TickAnims(int deltaTime, AnimType type) {
+	std::vector<AnimInfo>& animTable = anims[type];
+
 	switch (type) {
 		case AMove: {
-			for (std::list<AnimInfo*>::iterator it = anims[type].begin(); it != anims[type].end(); ++it) {
-				AnimInfo* ai = *it;
+			for (std::vector<AnimInfo>::iterator it = animTable.begin(); it != animTable.end(); ++it) {
+				AnimInfo& ai = *it;
 
 				// NOTE: we should not need to copy-and-set here, because
 				// MoveToward/TurnToward/DoSpin modify pos/rot by reference
-				float3 pos = pieces[ai->piece]->GetPosition();
+				float3 pos = pieces[ai.piece]->GetPosition();
 
-				if (MoveToward(pos[ai->axis], ai->dest, ai->speed / (1000 / deltaTime))) {
-					ai->done = true; doneAnims.push_back(it);
+				if (MoveToward(pos[ai.axis], ai.dest, ai.speed / (1000 / deltaTime))) {
+					ai.done = true;
 				}
 
-				pieces[ai->piece]->SetPosition(pos);
-				unit->localModel->PieceUpdated(ai->piece);
+				pieces[ai.piece]->SetPosition(pos);
 			}
 		} break;
 
 		case ATurn: {
-			for (std::list<AnimInfo*>::iterator it = anims[type].begin(); it != anims[type].end(); ++it) {
-				AnimInfo* ai = *it;
-				float3 rot = pieces[ai->piece]->GetRotation();
+			for (std::vector<AnimInfo>::iterator it = animTable.begin(); it != animTable.end(); ++it) {
+				AnimInfo& ai = *it;
+				float3 rot = pieces[ai.piece]->GetRotation();
 
-				if (TurnToward(rot[ai->axis], ai->dest, ai->speed / (1000 / deltaTime))) {
-					ai->done = true; doneAnims.push_back(it);
+				if (TurnToward(rot[ai.axis], ai.dest, ai.speed / (1000 / deltaTime))) {
+					ai.done = true;
 				}
 
-				pieces[ai->piece]->SetRotation(rot);
-				unit->localModel->PieceUpdated(ai->piece);
+				pieces[ai.piece]->SetRotation(rot);
 			}
 		} break;
 
 		case ASpin: {
-			for (std::list<AnimInfo*>::iterator it = anims[type].begin(); it != anims[type].end(); ++it) {
-				AnimInfo* ai = *it;
-				float3 rot = pieces[ai->piece]->GetRotation();
+			for (std::vector<AnimInfo>::iterator it = animTable.begin(); it != animTable.end(); ++it) {
+				AnimInfo& ai = *it;
+				float3 rot = pieces[ai.piece]->GetRotation();
 
-				if (DoSpin(rot[ai->axis], ai->dest, ai->speed, ai->accel, 1000 / deltaTime)) {
-					ai->done = true; doneAnims.push_back(it);
+				if (DoSpin(rot[ai.axis], ai.dest, ai.speed, ai.accel, 1000 / deltaTime)) {
+					ai.done = true;
 				}
 
-				pieces[ai->piece]->SetRotation(rot);
-				unit->localModel->PieceUpdated(ai->piece);
+				pieces[ai.piece]->SetRotation(rot);
 			}
 		} break;
 
@@ -275,29 +263,32 @@ void CUnitScript::TickAnims(int deltaTime, AnimType type, std::list< std::list<A
  */
 bool CUnitScript::Tick(int deltaTime)
 {
-	typedef std::list<AnimInfo*>::iterator AnimInfoIt;
-
-	// list of _iterators_ to finished animations,
-	// so we can get rid of them in constant time
-	std::list<AnimInfoIt> doneAnims;
+	// finished animations, moved out of the tables before notification
+	std::vector<AnimInfo> doneAnims;
 
 	for (int animType = ATurn; animType <= AMove; animType++) {
-		TickAnims(deltaTime, AnimType(animType), doneAnims);
+		TickAnims(deltaTime, AnimType(animType));
 	}
 
-	//! Tell listeners to unblock, and remove finished animations from the unit/script.
+	//! Remove finished animations from the unit/script, then tell their listeners to unblock.
 	//! NOTE:
 	//!     removing a finished animation _must_ happen before notifying its listeners,
 	//!     otherwise the callback function (AnimFinished()) can call AddAnimListener()
 	//!     and append it to the listeners-list again (causing an endless loop)!
-	//! NOTE: UnblockAll might result in new anims being added
-	for (std::list<AnimInfoIt>::const_iterator it = doneAnims.begin(); it != doneAnims.end(); ++it) {
-		AnimInfoIt animInfoIt = *it;
-		AnimInfo* animInfo = *animInfoIt;
+	//!     Iterating backwards keeps the swap-removal from skipping entries.
+	for (int animType = ATurn; animType <= AMove; animType++) {
+		for (int animIdx = int(anims[animType].size()) - 1; animIdx >= 0; animIdx--) {
+			if (!anims[animType][animIdx].done)
+				continue;
 
-		anims[animInfo->type].erase(animInfoIt);
-		UnblockAll(animInfo);
-		delete animInfo;
+			doneAnims.push_back(AnimInfo());
+			EraseAnim(AnimType(animType), animIdx, doneAnims.back());
+		}
+	}
+
+	//! NOTE: UnblockAll might result in new anims being added
+	for (std::vector<AnimInfo>::iterator it = doneAnims.begin(); it != doneAnims.end(); ++it) {
+		UnblockAll(*it);
 	}
 
 	return (HaveAnimations());
@@ -305,21 +296,45 @@ bool CUnitScript::Tick(int deltaTime)
 
 
 
-std::list<CUnitScript::AnimInfo*>::iterator CUnitScript::FindAnim(AnimType type, int piece, int axis)
+int CUnitScript::FindAnim(AnimType type, int piece, int axis) const
 {
-	for (std::list<AnimInfo*>::iterator i = anims[type].begin(); i != anims[type].end(); ++i) {
-		if (((*i)->piece == piece) && ((*i)->axis == axis))
-			return i;
+	const std::vector<int>& slots = animSlots[type];
+	const unsigned int slotIdx = piece * 3 + axis;
+
+	if (piece < 0 || axis < 0 || axis > 2 || slotIdx >= slots.size())
+		return -1;
+
+	return slots[slotIdx];
+}
+
+/**
+ * @brief Takes an animation out of its table in constant time
+ * @param erasedAnim AnimInfo receives the removed animation (including its listeners)
+ */
+void CUnitScript::EraseAnim(AnimType type, int animIdx, AnimInfo& erasedAnim)
+{
+	std::vector<AnimInfo>& animTable = anims[type];
+	std::vector<int>& slots = animSlots[type];
+
+	AnimInfo& ai = animTable[animIdx];
+	AnimInfo& lastAI = animTable.back();
+
+	slots[ai.piece * 3 + ai.axis] = -1;
+	erasedAnim.MoveFrom(ai);
+
+	if (&ai != &lastAI) {
+		ai.MoveFrom(lastAI);
+		slots[ai.piece * 3 + ai.axis] = animIdx;
 	}
 
-	return anims[type].end();
+	animTable.pop_back();
 }
 
-void CUnitScript::RemoveAnim(AnimType type, const std::list<AnimInfo*>::iterator& animInfoIt)
+void CUnitScript::RemoveAnim(AnimType type, int animIdx)
 {
-	if (animInfoIt != anims[type].end()) {
-		AnimInfo* ai = *animInfoIt;
-		anims[type].erase(animInfoIt);
+	if (animIdx != -1) {
+		AnimInfo ai;
+		EraseAnim(type, animIdx, ai);
  
 		// If this was the last animation, remove from currently animating list
 		// FIXME: this could be done in a cleaner way
@@ -330,8 +345,6 @@ void CUnitScript::RemoveAnim(AnimType type, const std::list<AnimInfo*>::iterator
 		//! We need to unblock threads waiting on this animation, otherwise they will be lost in the void
 		//! NOTE: UnblockAll might result in new anims being added
 		UnblockAll(ai);
-
-		delete ai;
 	}
 }
 
@@ -357,8 +370,7 @@ void CUnitScript::AddAnim(AnimType type, int piece, int axis, float speed, float
 		}
 	}
 
-	std::list<AnimInfo*>::iterator animInfoIt;
-	AnimInfo* ai = NULL;
+	int animIdx = -1;
 	AnimType overrideType = ANone;
 
 	// first find an animation of a type we override
@@ -368,65 +380,70 @@ void CUnitScript::AddAnim(AnimType type, int piece, int axis, float speed, float
 	switch (type) {
 		case ATurn: {
 			overrideType = ASpin;
-			animInfoIt = FindAnim(overrideType, piece, axis);
+			animIdx = FindAnim(overrideType, piece, axis);
 		} break;
 		case ASpin: {
 			overrideType = ATurn;
-			animInfoIt = FindAnim(overrideType, piece, axis);
+			animIdx = FindAnim(overrideType, piece, axis);
 		} break;
 		case AMove: {
 			// ensure we never remove an animation of this type
 			overrideType = AMove;
-			animInfoIt = anims[overrideType].end();
+			animIdx = -1;
 		} break;
 		default: {
 		} break;
 	}
 
-	if (animInfoIt != anims[overrideType].end())
-		RemoveAnim(overrideType, animInfoIt);
+	if (animIdx != -1)
+		RemoveAnim(overrideType, animIdx);
 
 	// now find an animation of our own type
-	animInfoIt = FindAnim(type, piece, axis);
+	animIdx = FindAnim(type, piece, axis);
 
-	if (animInfoIt == anims[type].end()) {
+	if (animIdx == -1) {
 		// If we were not animating before, inform the engine of this so it can schedule us
 		// FIXME: this could be done in a cleaner way
 		if (!HaveAnimations()) {
 			GUnitScriptEngine.AddInstance(this);
 		}
 
-		ai = new AnimInfo();
-		ai->type = type;
-		ai->piece = piece;
-		ai->axis = axis;
-		anims[type].push_back(ai);
-	} else {
-		ai = *animInfoIt;
+		// slot tables are only allocated once a script starts animating
+		if (animSlots[type].size() < pieces.size() * 3)
+			animSlots[type].resize(pieces.size() * 3, -1);
+
+		animIdx = anims[type].size();
+		animSlots[type][piece * 3 + axis] = animIdx;
+
+		anims[type].push_back(AnimInfo());
+		anims[type].back().type = type;
+		anims[type].back().piece = piece;
+		anims[type].back().axis = axis;
 	}
 
-	ai->dest  = destf;
-	ai->speed = speed;
-	ai->accel = accel;
-	ai->done = false;
+	AnimInfo& ai = anims[type][animIdx];
+	ai.dest  = destf;
+	ai.speed = speed;
+	ai.accel = accel;
+	ai.done = false;
 }
 
 
 void CUnitScript::Spin(int piece, int axis, float speed, float accel)
 {
-	std::list<AnimInfo*>::iterator animInfoIt = FindAnim(ASpin, piece, axis);
+	const int animIdx = FindAnim(ASpin, piece, axis);
 
 	//If we are already spinning, we may have to decelerate to the new speed
-	if (animInfoIt != anims[ASpin].end()) {
-		AnimInfo* ai = *animInfoIt;
-		ai->dest = speed;
+	if (animIdx != -1) {
+		AnimInfo& ai = anims[ASpin][animIdx];
+		ai.dest = speed;
 
 		if (accel > 0) {
-			ai->accel = accel;
+			ai.accel = accel;
 		} else {
 			//Go there instantly. Or have a defaul accel?
-			ai->speed = speed;
-			ai->accel = 0;
+			ai.speed = speed;
+			ai.accel = 0;
 		}
 	} else {
 		//No accel means we start at desired speed instantly
@@ -440,17 +457,17 @@ void CUnitScript::Spin(int piece, int axis, float speed, float accel)
 
 void CUnitScript::StopSpin(int piece, int axis, float decel)
 {
-	std::list<AnimInfo*>::iterator animInfoIt = FindAnim(ASpin, piece, axis);
+	const int animIdx = FindAnim(ASpin, piece, axis);
 
 	if (decel <= 0) {
-		RemoveAnim(ASpin, animInfoIt);
+		RemoveAnim(ASpin, animIdx);
 	} else {
-		if (animInfoIt == anims[ASpin].end())
+		if (animIdx == -1)
 			return;
 
-		AnimInfo* ai = *animInfoIt;
-		ai->dest = 0;
-		ai->accel = decel;
+		AnimInfo& ai = anims[ASpin][animIdx];
+		ai.dest = 0;
+		ai.accel = decel;
 	}
 }
 
@@ -474,14 +491,12 @@ void CUnitScript::MoveNow(int piece, int axis, float destination)
 		return;
 	}
 
-	LocalModel* m = unit->localModel;
 	LocalModelPiece* p = pieces[piece];
 
 	float3 pos = p->GetPosition();
 	pos[axis] = pieces[piece]->original->offset[axis] + destination;
 
 	p->SetPosition(pos);
-	m->PieceUpdated(piece);
 }
 
 
@@ -492,14 +507,12 @@ void CUnitScript::TurnNow(int piece, int axis, float destination)
 		return;
 	}
 
-	LocalModel* m = unit->localModel;
 	LocalModelPiece* p = pieces[piece];
 
 	float3 rot = p->GetRotation();
 	rot[axis] = destination;
 
 	p->SetRotation(rot);
-	m->PieceUpdated(piece);
 }
 
 
@@ -735,13 +748,13 @@ void CUnitScript::DropUnit(int u)
 //Returns true if there was an animation to listen to
 bool CUnitScript::AddAnimListener(AnimType type, int piece, int axis, IAnimListener *listener)
 {
-	std::list<AnimInfo*>::iterator animInfoIt = FindAnim(type, piece, axis);
+	const int animIdx = FindAnim(type, piece, axis);
 
-	if (animInfoIt != anims[type].end()) {
-		AnimInfo* ai = *animInfoIt;
+	if (animIdx != -1) {
+		AnimInfo& ai = anims[type][animIdx];
 
-		if (!ai->done) {
-			ai->listeners.push_back(listener);
+		if (!ai.done) {
+			ai.listeners.push_back(listener);
 			return true;
 		}
 
@@ -19,6 +19,8 @@ class CPlasmaRepulser;
 
 class CUnitScript : public CObject
 {
+	friend class CUnitScriptEngine;
+
 public:
 	enum AnimType {ANone = -1, ATurn = 0, ASpin = 1, AMove = 2};
 
@@ -64,6 +66,19 @@ protected:
 	bool busy;
 
 	struct AnimInfo {
+		/// transfers src into this slot, stealing (not copying) its listeners
+		void MoveFrom(AnimInfo& src) {
+			type  = src.type;
+			axis  = src.axis;
+			piece = src.piece;
+			speed = src.speed;
+			dest  = src.dest;
+			accel = src.accel;
+			done  = src.done;
+			listeners.clear();
+			listeners.swap(src.listeners);
+		}
+
 		AnimType type;
 		int axis;
 		int piece;
@@ -71,23 +86,30 @@ protected:
 		float dest;     // means final position when turning or moving, final speed when spinning
 		float accel;    // used for spinning, can be negative
 		bool done;
-		std::list<IAnimListener*> listeners;
+		std::vector<IAnimListener*> listeners;
 	};
 
-	std::list<AnimInfo*> anims[AMove + 1];
+	// flat per-type animation tables (unordered, entries are swap-removed)
+	std::vector<AnimInfo> anims[AMove + 1];
+	// per-type lookup from (piece * 3 + axis) to an index into anims[type], -1 if not animating
+	std::vector<int> animSlots[AMove + 1];
+
+	// index into CUnitScriptEngine::animating, -1 if not registered there
+	int engineAnimIdx;
 
 	bool hasSetSFXOccupy;
 	bool hasRockUnit;
 	bool hasStartBuilding;
 
-	void UnblockAll(AnimInfo* anim);
+	void UnblockAll(AnimInfo& anim);
 
 	bool MoveToward(float &cur, float dest, float speed);
 	bool TurnToward(float &cur, float dest, float speed);
 	bool DoSpin(float &cur, float dest, float &speed, float accel, int divisor);
 
-	std::list<AnimInfo*>::iterator FindAnim(AnimType anim, int piece, int axis);
-	void RemoveAnim(AnimType type, const std::list<AnimInfo*>::iterator& animInfoIt);
+	int FindAnim(AnimType type, int piece, int axis) const;
+	void EraseAnim(AnimType type, int animIdx, AnimInfo& erasedAnim);
+	void RemoveAnim(AnimType type, int animIdx);
 	void AddAnim(AnimType type, int piece, int axis, float speed, float dest, float accel);
 
 	virtual void ShowScriptError(const std::string& msg) = 0;
@@ -140,7 +162,7 @@ public:
 	const CUnit* GetUnit() const { return unit; }
 
 	bool Tick(int deltaTime);
-	void TickAnims(int deltaTime, AnimType type, std::list< std::list<AnimInfo*>::iterator >& doneAnims);
+	void TickAnims(int deltaTime, AnimType type);
 
 	// animation, used by CCobThread
 	void Spin(int piece, int axis, float speed, float accel);
@@ -164,7 +186,7 @@ public:
 	void SetUnitVal(int val, int param);
 
 	bool IsInAnimation(AnimType type, int piece, int axis) {
-		return (FindAnim(type, piece, axis) != anims[type].end());
+		return (FindAnim(type, piece, axis) != -1);
 	}
 	bool HaveAnimations() const {
 		return (!anims[ATurn].empty() || !anims[ASpin].empty() || !anims[AMove].empty());
@@ -35,42 +35,35 @@ CUnitScriptEngine::~CUnitScriptEngine()
 }
 
 
-void CUnitScriptEngine::CheckForDuplicates(const char* name, CUnitScript* instance)
+void CUnitScriptEngine::AddInstance(CUnitScript *instance)
 {
-	int found = 0;
+	if (instance == currentScript)
+		return;
 
-	for (std::list<CUnitScript*>::iterator i = animating.begin(); i != animating.end(); ++i) {
-		if (*i == instance)
-			found++;
+	// Error checking
+	if (instance->engineAnimIdx != -1) {
+		LOG_L(L_WARNING, "%s found duplicate at index %d", __FUNCTION__, instance->engineAnimIdx);
+		return;
 	}
 
-	if (found > 1)
-		LOG_L(L_WARNING, "%s found duplicates %d", name, found);
+	instance->engineAnimIdx = animating.size();
+	animating.push_back(instance);
 }
 
 
-void CUnitScriptEngine::AddInstance(CUnitScript *instance)
+void CUnitScriptEngine::RemoveInstance(CUnitScript *instance)
 {
-	if (instance != currentScript)
-		animating.push_front(instance);
+	if (instance == currentScript)
+		return;
 
-	// Error checking
-#ifdef _DEBUG
-	CheckForDuplicates(__FUNCTION__, instance);
-#endif
-}
+	const int animIdx = instance->engineAnimIdx;
 
+	if (animIdx == -1)
+		return;
 
-void CUnitScriptEngine::RemoveInstance(CUnitScript *instance)
-{
-	// Error checking
-#ifdef _DEBUG
-	CheckForDuplicates(__FUNCTION__, instance);
-#endif
-
-	//This is slow. would be better if instance was a hashlist perhaps
-	if (instance != currentScript)
-		animating.remove(instance);
+	// constant time; the hole is compacted by the next Tick
+	animating[animIdx] = NULL;
+	instance->engineAnimIdx = -1;
 }
 
 
@@ -78,18 +71,35 @@ void CUnitScriptEngine::Tick(int deltaTime)
 {
 	SCOPED_TIMER("UnitScriptEngine::Tick");
 
+	// instances added while ticking get their first tick next frame
+	const size_t numAnimating = animating.size();
+
 	// Tick all instances that have registered themselves as animating
-	for (std::list<CUnitScript*>::iterator it = animating.begin(); it != animating.end(); ) {
-		currentScript = *it;
+	for (size_t i = 0; i < numAnimating; i++) {
+		if ((currentScript = animating[i]) == NULL)
+			continue;
 
-		if (currentScript->Tick(deltaTime)) {
-			++it;
-		} else {
-			it = animating.erase(it);
+		if (!currentScript->Tick(deltaTime)) {
+			currentScript->engineAnimIdx = -1;
+			animating[i] = NULL;
 		}
 	}
 
 	currentScript = NULL;
+
+	// squeeze out removed instances, keeping the tick order stable
+	size_t numKept = 0;
+
+	for (size_t i = 0; i < animating.size(); i++) {
+		if (animating[i] == NULL)
+			continue;
+
+		animating[numKept] = animating[i];
+		animating[numKept]->engineAnimIdx = numKept;
+		numKept++;
+	}
+
+	animating.resize(numKept);
 }
 
 
@@ -107,6 +107,9 @@ CUnit::CUnit() : CSolidObject(),
 	realLosRadius(0),
 	realAirLosRadius(0),
 	losStatus(teamHandler->ActiveAllyTeams(), 0),
+	losStatusFrame(-1),
+	losStatusSquare(-1),
+	losStatusInputs(0),
 	inBuildStance(false),
 	useHighTrajectory(false),
 	dontUseWeapons(false),
@@ -831,6 +834,45 @@ inline void CUnit::UpdateLosStatus(int at)
 }
 
 
+void CUnit::UpdateLosStatus()
+{
+	// the LOS status of a unit for an ally-team only changes if the unit
+	// moved to another square, if its sensor related state changed, or if
+	// a LOS, radar, sonar or jammer map became or stopped being zero near it;
+	// so units are only checked against ally-teams for which one of these
+	// happened since the last update, instead of all of them
+	const int square = loshandler->GetVisibilitySquare(pos);
+	const int cell = loshandler->GetVisibilityCell(pos);
+	const unsigned int inputs =
+		(alwaysVisible      << 0) |
+		(isCloaked          << 1) |
+		(useAirLos          << 2) |
+		(isUnderWater       << 3) |
+		((pos.y < 0.0f)     << 4) |
+		(stealth            << 5) |
+		(sonarStealth       << 6) |
+		(beingBuilt         << 7);
+
+	const int lastFrame = losStatusFrame;
+	const bool unitChanged =
+		(lastFrame < 0) ||
+		(square != losStatusSquare) ||
+		(inputs != losStatusInputs) ||
+		loshandler->CommonVisibilityChanged(cell, lastFrame);
+
+	// stored before any events are sent, those might force another update
+	losStatusFrame = gs->frameNum;
+	losStatusSquare = square;
+	losStatusInputs = inputs;
+
+	for (int at = 0; at < teamHandler->ActiveAllyTeams(); ++at) {
+		if (unitChanged || loshandler->VisibilityChanged(at, cell, lastFrame)) {
+			UpdateLosStatus(at);
+		}
+	}
+}
+
+
 void CUnit::SetStunned(bool stun) {
 	stunned = stun;
 
@@ -857,9 +899,7 @@ void CUnit::SlowUpdate()
 		nextPosErrorUpdate = 16;
 	}
 
-	for (int at = 0; at < teamHandler->ActiveAllyTeams(); ++at) {
-		UpdateLosStatus(at);
-	}
+	UpdateLosStatus();
 
 	DoWaterDamage();
 
@@ -1460,6 +1500,7 @@ bool CUnit::ChangeTeam(int newteam, ChangeType type)
 	loshandler->MoveUnit(this, false);
 	losStatus[allyteam] = LOS_ALL_MASK_BITS |
 		LOS_INLOS | LOS_INRADAR | LOS_PREVLOS | LOS_CONTRADAR;
+	ForceLosStatusUpdate();
 
 	qf->MovedUnit(this);
 	radarhandler->MoveUnit(this);
@@ -157,6 +157,8 @@ public:
 
 	void SetLosStatus(int allyTeam, unsigned short newStatus);
 	unsigned short CalcLosStatus(int allyTeam);
+	/// has to be called if losStatus was changed without SlowUpdate
+	void ForceLosStatusUpdate() { losStatusFrame = -1; }
 
 	void SlowUpdateCloak(bool);
 	void ScriptDecloak(bool);
@@ -187,6 +189,7 @@ public:
 protected:
 	void ChangeTeamReset();
 	void UpdateResources();
+	void UpdateLosStatus();
 	void UpdateLosStatus(int allyTeam);
 	float GetFlankingDamageBonus(const float3& attackDir);
 
@@ -275,6 +278,11 @@ public:
 	/// indicate the los/radar status the allyteam has on this unit
 	std::vector<unsigned short> losStatus;
 
+	/// frame, visibility square and sensor state of the last LOS status update
+	int losStatusFrame;
+	int losStatusSquare;
+	unsigned int losStatusInputs;
+
 	/// used by constructing units
 	bool inBuildStance;
 	/// tells weapons that support it to try to use a high trajectory
@@ -85,11 +85,14 @@ PacketType CBaseNetProtocol::SendPathCheckSum(uchar myPlayerNum, boost::uint32_t
 }
 
 
-PacketType CBaseNetProtocol::SendCommand(uchar myPlayerNum, int id, uchar options, const std::vector<float>& params)
+PacketType CBaseNetProtocol::SendCommand(uchar myPlayerNum, int id, uchar options, const float* params, unsigned int numParams)
 {
-	unsigned size = 9 + params.size() * sizeof(float);
+	unsigned size = 9 + numParams * sizeof(float);
 	PackPacket* packet = new PackPacket(size, NETMSG_COMMAND);
-	*packet << static_cast<unsigned short>(size) << myPlayerNum << id << options << params;
+	*packet << static_cast<unsigned short>(size) << myPlayerNum << id << options;
+	for (unsigned int i = 0; i < numParams; ++i) {
+		*packet << params[i];
+	}
 	return PacketType(packet);
 }
 
@@ -111,10 +114,10 @@ PacketType CBaseNetProtocol::SendPause(uchar myPlayerNum, uchar bPaused)
 
 
 
-PacketType CBaseNetProtocol::SendAICommand(uchar myPlayerNum, unsigned char aiID, short unitID, int id, int aiCommandId, uchar options, const std::vector<float>& params)
+PacketType CBaseNetProtocol::SendAICommand(uchar myPlayerNum, unsigned char aiID, short unitID, int id, int aiCommandId, uchar options, const float* params, unsigned int numParams)
 {
 	int cmdTypeId = NETMSG_AICOMMAND;
-	unsigned size = 12 + (params.size() * sizeof(float));
+	unsigned size = 12 + (numParams * sizeof(float));
 	if (aiCommandId != -1) {
 		cmdTypeId = NETMSG_AICOMMAND_TRACKED;
 		size += 4;
@@ -124,7 +127,9 @@ PacketType CBaseNetProtocol::SendAICommand(uchar myPlayerNum, unsigned char aiID
 	if (cmdTypeId == NETMSG_AICOMMAND_TRACKED) {
 		*packet << aiCommandId;
 	}
-	*packet << params;
+	for (unsigned int i = 0; i < numParams; ++i) {
+		*packet << params[i];
+	}
 	return PacketType(packet);
 }
 
@@ -49,7 +49,7 @@ bool CArchiveLoader::IsArchiveFile(const std::string& fileName) const
 }
 
 
-IArchive* CArchiveLoader::OpenArchive(const std::string& fileName, const std::string& type) const
+IArchive* CArchiveLoader::OpenArchive(const std::string& fileName, const std::string& type, std::vector<std::string>* errors) const
 {
 	IArchive* ret = NULL;
 
@@ -63,6 +63,14 @@ IArchive* CArchiveLoader::OpenArchive(const std::string& fileName, const std::st
 		ret = afi->second->CreateArchive(filePath);
 	}
 
+	if (ret) {
+		if (errors) {
+			ret->TakeErrors(*errors);
+		} else {
+			ret->StopCollectingErrors();
+		}
+	}
+
 	if (ret && ret->IsOpen()) {
 		return ret;
 	}
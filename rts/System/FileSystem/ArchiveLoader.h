@@ -5,6 +5,7 @@
 
 #include <map>
 #include <string>
+#include <vector>
 
 class IArchive;
 class IArchiveFactory;
@@ -25,9 +26,16 @@ public:
 	/// Returns true if the indicated file is in fact an archive
 	bool IsArchiveFile(const std::string& fileName) const;
 
-	/// Returns a pointer to a new'ed suitable subclass of IArchive
+	/**
+	 * Returns a pointer to a new'ed suitable subclass of IArchive
+	 * @param errors if given, the errors of opening are appended to it
+	 *   instead of being logged, and the archive keeps collecting the
+	 *   errors of reading (see IArchive::TakeErrors); for threads which
+	 *   must not log
+	 */
 	IArchive* OpenArchive(const std::string& fileName,
-			const std::string& type = "") const;
+			const std::string& type = "",
+			std::vector<std::string>* errors = NULL) const;
 
 	/**
 	 * Registers an archive factory, which handles a single type of archive.
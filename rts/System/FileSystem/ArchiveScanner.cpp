@@ -3,6 +3,7 @@
 
 #include <list>
 #include <algorithm>
+#include <cstring>
 #include <stdio.h>
 #include <sys/types.h>
 #include <sys/stat.h>
@@ -22,6 +23,7 @@
 #include "System/Util.h"
 #include "System/Exceptions.h"
 #include "System/OpenMP_cond.h"
+#include "System/Misc/SpringTime.h"
 #if       !defined(DEDICATED) && !defined(UNITSYNC)
 #include "System/Platform/Watchdog.h"
 #endif // !defined(DEDICATED) && !defined(UNITSYNC)
@@ -44,7 +46,7 @@ LOG_REGISTER_SECTION_GLOBAL(LOG_SECTION_ARCHIVESCANNER)
  * but mapping them all, every time to make the list is)
  */
 
-const int INTERNAL_VER = 9;
+const int INTERNAL_VER = 10;
 CArchiveScanner* archiveScanner = NULL;
 
 
@@ -129,10 +131,10 @@ CArchiveScanner::ArchiveData::ArchiveData(const LuaTable& archiveTable, bool fro
 	//! so they can uniquely identify different versions of the same mod.
 	//! (at time of this writing they use name only)
 
-	//! NOTE when changing this, this function is used both by the code that
-	//! reads ArchiveCache.lua and the code that reads modinfo.lua from the mod.
-	//! so make sure it doesn't keep adding stuff to the name everytime
-	//! Spring/unitsync is loaded.
+	//! NOTE when changing this, the resulting name is stored in the archive
+	//! cache, and this function may also be used on tables that contain
+	//! such a cached name, so make sure it doesn't keep adding stuff to the
+	//! name everytime Spring/unitsync is loaded.
 
 	const std::string& name = GetName();
 	const std::string& version = GetVersion();
@@ -340,7 +342,7 @@ CArchiveScanner::CArchiveScanner()
 {
 	std::ostringstream file;
 	// the "cache" dir is created in DataDirLocater
-	file << "cache" << (char)FileSystem::GetNativePathSeparator() << "ArchiveCache.lua";
+	file << "cache" << (char)FileSystem::GetNativePathSeparator() << "ArchiveCache.bin";
 	cachefile = file.str();
 	ReadCacheData(dataDirLocater.GetWriteDirPath() + GetFilename());
 
@@ -374,24 +376,161 @@ const std::string& CArchiveScanner::GetFilename() const
 
 void CArchiveScanner::ScanDirs(const std::vector<std::string>& scanDirs, bool doChecksum)
 {
+	const spring_time startTime = spring_gettime();
+
+	unsigned int numFound = 0;
+	unsigned int numScanned = 0;
+	unsigned int numChecksums = 0;
+
 	// add the archives
 	std::vector<std::string>::const_iterator dir;
 	for (dir = scanDirs.begin(); dir != scanDirs.end(); ++dir) {
 		if (FileSystem::DirExists(*dir)) {
 			LOG("Scanning: %s", dir->c_str());
-			Scan(*dir, doChecksum);
+			Scan(*dir, numFound, numScanned);
 		}
 	}
+
+	//! Optionally calculate checksums for the archives
+	//! To prevent reading all files in all directory (.sdd) archives
+	//! every time, the checksums are stored in the cache.
+	if (doChecksum) {
+		numChecksums = CalcMissingChecksums();
+	}
+
+	LOG("Scanned %u archives in %ims (%u cached, %u (re)scanned, %u checksums calculated)",
+			numFound, (int) spring_tomsecs(spring_gettime() - startTime),
+			numFound - numScanned, numScanned, numChecksums);
 }
 
 
-void CArchiveScanner::Scan(const std::string& curPath, bool doChecksum)
+static void AddDependency(std::vector<std::string>& deps, const std::string& dependency)
+{
+	for (std::vector<std::string>::iterator it = deps.begin(); it != deps.end(); ++it) {
+		if (*it == dependency) {
+			return;
+		}
+	}
+
+	deps.push_back(dependency);
+}
+
+
+/// an archive which is not (validly) cached, and thus has to be opened
+struct CArchiveScanner::ArchiveScanJob {
+	ArchiveScanJob()
+		: modified(0)
+		, size(0)
+		, opened(false)
+		, isMap(false)
+		, luaRead(false)
+		{}
+
+	std::string fullName;
+	std::string fileName;
+	std::string lcFileName;
+	std::string path;
+	unsigned int modified;
+	boost::uint64_t size;
+
+	//! filled in by ReadArchiveMetaData()
+	bool opened;
+	bool isMap;
+	bool luaRead;
+	std::string error;
+	std::string mapFile;
+	std::string luaFile;                      ///< mapinfo.lua or modinfo.lua
+	std::vector<boost::uint8_t> luaBuf;
+	std::vector<std::string> costlyMetaFiles; ///< 2nd class meta-files that are not cheap to read
+	std::vector<std::string> archiveErrors;   ///< errors of opening and reading the archive
+};
+
+/**
+ * Reads everything required to classify the archive.
+ * Called concurrently for different jobs, so it must neither log
+ * nor touch the scanner state.
+ */
+void CArchiveScanner::ReadArchiveMetaData(ArchiveScanJob& job)
+{
+	IArchive* ar = archiveLoader.OpenArchive(job.fullName, "", &job.archiveErrors);
+	if (!ar || !ar->IsOpen()) {
+		delete ar;
+		return;
+	}
+	job.opened = true;
+
+	const bool hasModinfo = ar->FileExists("modinfo.lua");
+	const bool hasMapinfo = ar->FileExists("mapinfo.lua");
+
+	//! check for smf/sm3 and if the uncompression of important files is too costy
+	for (unsigned fid = 0; fid != ar->NumFiles(); ++fid)
+	{
+		std::string name;
+		int size;
+		ar->FileInfo(fid, name, size);
+		const std::string lowerName = StringToLower(name);
+		const std::string ext = FileSystem::GetExtension(lowerName);
+
+		if ((ext == "smf") || (ext == "sm3")) {
+			job.mapFile = name;
+		}
+
+		const unsigned char metaFileClass = GetMetaFileClass(lowerName);
+		if ((metaFileClass != 0) && !(ar->HasLowReadingCost(fid))) {
+			//! is a meta-file and not cheap to read
+			if (metaFileClass == 1) {
+				//! 1st class
+				job.error = "Unpacking/reading cost for meta file " + name
+						+ " is too high, please repack the archive (make sure to use a non-solid algorithm, if applicable)";
+				break;
+			} else if (metaFileClass == 2) {
+				//! 2nd class
+				job.costlyMetaFiles.push_back(name);
+			}
+		}
+	}
+
+	if (!job.error.empty()) {
+		//! we already have an error, no further evaluation required
+	} else if (hasMapinfo || !job.mapFile.empty()) {
+		//! it is a map
+		job.isMap = true;
+		if (hasMapinfo) {
+			job.luaFile = "mapinfo.lua";
+		} else if (hasModinfo) {
+			//! backwards-compat for modinfo.lua in maps
+			job.luaFile = "modinfo.lua";
+		}
+	} else if (hasModinfo) {
+		//! it is a mod
+		job.luaFile = "modinfo.lua";
+	} else {
+		//! neither a map nor a mod: error
+		job.error = "missing modinfo.lua/mapinfo.lua";
+	}
+
+	if (!job.luaFile.empty()) {
+		job.luaRead = ar->GetFile(job.luaFile, job.luaBuf);
+	}
+
+	ar->TakeErrors(job.archiveErrors);
+	delete ar;
+
+#if       !defined(DEDICATED) && !defined(UNITSYNC)
+	Watchdog::ClearTimer(WDT_MAIN);
+#endif // !defined(DEDICATED) && !defined(UNITSYNC)
+}
+
+
+void CArchiveScanner::Scan(const std::string& curPath, unsigned int& numFound, unsigned int& numScanned)
 {
 	isDirty = true;
 
 	const int flags = (FileQueryFlags::INCLUDE_DIRS | FileQueryFlags::RECURSE);
 	const std::vector<std::string> &found = dataDirsAccess.FindFiles(curPath, "*", flags);
 
+	std::vector<ArchiveScanJob> jobs;
+
 	for (std::vector<std::string>::const_iterator it = found.begin(); it != found.end(); ++it) {
 		std::string fullName = *it;
 
@@ -415,13 +554,45 @@ void CArchiveScanner::Scan(const std::string& curPath, bool doChecksum)
 			continue;
 		}
 
+		// Is this an archive we should look into?
+		if (!archiveLoader.IsArchiveFile(fullName)) {
+			continue;
+		}
+
+		numFound++;
+
+		struct stat info;
+		stat(fullName.c_str(), &info);
+
+		ArchiveScanJob job;
+		job.fullName   = fullName;
+		job.fileName   = FileSystem::GetFilename(fullName);
+		job.lcFileName = StringToLower(job.fileName);
+		job.path       = fpath;
+		job.modified   = info.st_mtime;
+		job.size       = info.st_size;
+
+		if (!CheckCachedArchive(job.lcFileName, job.path, job.modified, job.size)) {
+			jobs.push_back(job);
+		}
+	}
+
+	//! Open all new or changed archives concurrently, the lua part
+	//! of the evaluation (LuaParser is not reentrant) is done below.
+	const int numJobs = jobs.size();
+	int i;
+	#pragma omp parallel for private(i) schedule(dynamic)
+	for (i = 0; i < numJobs; ++i) {
+		ReadArchiveMetaData(jobs[i]);
+	}
+	numScanned += numJobs;
+
+	//! Evaluate the results in the order the archives were found
+	for (std::vector<ArchiveScanJob>::iterator job = jobs.begin(); job != jobs.end(); ++job) {
 #if       !defined(DEDICATED) && !defined(UNITSYNC)
 		Watchdog::ClearTimer(WDT_MAIN);
 #endif // !defined(DEDICATED) && !defined(UNITSYNC)
-		// Is this an archive we should look into?
-		if (archiveLoader.IsArchiveFile(fullName)) {
-			ScanArchive(fullName, doChecksum);
-		}
+		AddScannedArchive(*job);
 	}
 
 	// Now we'll have to parse the replaces-stuff found in the mods
@@ -450,188 +621,116 @@ void CArchiveScanner::Scan(const std::string& curPath, bool doChecksum)
 	}
 }
 
-static void AddDependency(std::vector<std::string>& deps, const std::string& dependency)
+bool CArchiveScanner::CheckCachedArchive(const std::string& lcfn, const std::string& fpath, unsigned int modified, boost::uint64_t size)
 {
-	for (std::vector<std::string>::iterator it = deps.begin(); it != deps.end(); ++it) {
-		if (*it == dependency) {
-			return;
-		}
-	}
-
-	deps.push_back(dependency);
-}
-
-void CArchiveScanner::ScanArchive(const std::string& fullName, bool doChecksum)
-{
-	struct stat info;
-	stat(fullName.c_str(), &info);
-
-	const std::string fn    = FileSystem::GetFilename(fullName);
-	const std::string fpath = FileSystem::GetDirectory(fullName);
-	const std::string lcfn  = StringToLower(fn);
-
 	//! Determine whether this archive has earlier be found to be broken
 	std::map<std::string, BrokenArchive>::iterator bai = brokenArchives.find(lcfn);
 	if (bai != brokenArchives.end()) {
-		if ((unsigned)info.st_mtime == bai->second.modified && fpath == bai->second.path) {
+		if (modified == bai->second.modified && size == bai->second.size && fpath == bai->second.path) {
 			bai->second.updated = true;
-			return;
+			return true;
 		}
 	}
 
-	//! Determine whether to rely on the cached info or not
-	bool cached = false;
-
 	std::map<std::string, ArchiveInfo>::iterator aii = archiveInfos.find(lcfn);
-	if (aii != archiveInfos.end()) {
-
-		//! This archive may have been obsoleted, do not process it if so
-		if (aii->second.replaced.length() > 0) {
-			return;
-		}
+	if (aii == archiveInfos.end()) {
+		return false;
+	}
 
-		if ((unsigned)info.st_mtime == aii->second.modified && fpath == aii->second.path) {
-			cached = true;
-			aii->second.updated = true;
-		}
+	//! This archive may have been obsoleted, do not process it if so
+	if (aii->second.replaced.length() > 0) {
+		return true;
+	}
 
-		//! If we are here, we could have invalid info in the cache
-		//! Force a reread if it's a directory archive, as st_mtime only
-		//! reflects changes to the directory itself, not the contents.
-		if (!cached) {
-			archiveInfos.erase(aii);
-		}
+	if (modified == aii->second.modified && size == aii->second.size && fpath == aii->second.path) {
+		aii->second.updated = true;
+		return true;
 	}
 
-	//! Time to parse the info we are interested in
-	if (cached) {
-		//! If cached is true, aii will point to the archive
-		if (doChecksum && (aii->second.checksum == 0))
-			aii->second.checksum = GetCRC(fullName);
-	} else {
-		IArchive* ar = archiveLoader.OpenArchive(fullName);
-		if (!ar || !ar->IsOpen()) {
-			LOG("Unable to open archive: %s", fullName.c_str());
-			return;
-		}
+	//! If we are here, we have invalid info in the cache
+	archiveInfos.erase(aii);
+	return false;
+}
 
-		ArchiveInfo ai;
-		std::string error = "";
-
-		std::string mapfile;
-		bool hasModinfo = ar->FileExists("modinfo.lua");
-		bool hasMapinfo = ar->FileExists("mapinfo.lua");
-		
-		//! check for smf/sm3 and if the uncompression of important files is too costy
-		for (unsigned fid = 0; fid != ar->NumFiles(); ++fid)
-		{
-			std::string name;
-			int size;
-			ar->FileInfo(fid, name, size);
-			const std::string lowerName = StringToLower(name);
-			const std::string ext = FileSystem::GetExtension(lowerName);
-
-			if ((ext == "smf") || (ext == "sm3")) {
-				mapfile = name;
-			}
+void CArchiveScanner::AddScannedArchive(const ArchiveScanJob& job)
+{
+	for (std::vector<std::string>::const_iterator it = job.archiveErrors.begin(); it != job.archiveErrors.end(); ++it) {
+		LOG_L(L_ERROR, "%s", it->c_str());
+	}
 
-			const unsigned char metaFileClass = GetMetaFileClass(lowerName);
-			if ((metaFileClass != 0) && !(ar->HasLowReadingCost(fid))) {
-				//! is a meta-file and not cheap to read
-				if (metaFileClass == 1) {
-					//! 1st class
-					error = "Unpacking/reading cost for meta file " + name
-							+ " is too high, please repack the archive (make sure to use a non-solid algorithm, if applicable)";
-					break;
-				} else if (metaFileClass == 2) {
-					//! 2nd class
-					LOG_SL(LOG_SECTION_ARCHIVESCANNER, L_WARNING,
-							"Archive %s: The cost for reading a 2nd class meta-file is too high: %s",
-							fullName.c_str(), name.c_str());
-				}
-			}
-		}
+	if (!job.opened) {
+		LOG("Unable to open archive: %s", job.fullName.c_str());
+		return;
+	}
 
-		if (!error.empty()) {
-			//! we already have an error, no further evaluation required
-		} if (hasMapinfo || !mapfile.empty()) {
-			//! it is a map
-			if (hasMapinfo) {
-				ScanArchiveLua(ar, "mapinfo.lua", ai, error);
-			} else if (hasModinfo) {
-				//! backwards-compat for modinfo.lua in maps
-				ScanArchiveLua(ar, "modinfo.lua", ai, error);
-			}
-			if (ai.archiveData.GetName().empty()) {
-				//! FIXME The name will never be empty, if version is set (see HACK in ArchiveData)
-				ai.archiveData.SetInfoItemValueString("name", FileSystem::GetBasename(mapfile));
-			}
-			if (ai.archiveData.GetMapFile().empty()) {
-				ai.archiveData.SetInfoItemValueString("mapfile", mapfile);
-			}
-			AddDependency(ai.archiveData.GetDependencies(), "Map Helper v1");
-			ai.archiveData.SetInfoItemValueInteger("modType", modtype::map);
+	for (std::vector<std::string>::const_iterator it = job.costlyMetaFiles.begin(); it != job.costlyMetaFiles.end(); ++it) {
+		LOG_SL(LOG_SECTION_ARCHIVESCANNER, L_WARNING,
+				"Archive %s: The cost for reading a 2nd class meta-file is too high: %s",
+				job.fullName.c_str(), it->c_str());
+	}
 
-			LOG_S(LOG_SECTION_ARCHIVESCANNER, "Found new map: %s",
-					ai.archiveData.GetName().c_str());
-		} else if (hasModinfo) {
-			//! it is a mod
-			ScanArchiveLua(ar, "modinfo.lua", ai, error);
-			if (ai.archiveData.GetModType() == modtype::primary) {
-				AddDependency(ai.archiveData.GetDependencies(), "Spring content v1");
-			}
+	ArchiveInfo ai;
+	std::string error = job.error;
 
-			LOG_S(LOG_SECTION_ARCHIVESCANNER, "Found new game: %s",
-					ai.archiveData.GetName().c_str());
-		} else {
-			//! neither a map nor a mod: error
-			error = "missing modinfo.lua/mapinfo.lua";
+	if (!error.empty()) {
+		//! we already have an error, no further evaluation required
+	} else if (job.isMap) {
+		if (job.luaRead) {
+			ScanArchiveLua(job.luaBuf, job.luaFile, ai, error);
 		}
-
-		delete ar;
-
-		if (!error.empty()) {
-			//! for some reason, the archive is marked as broken
-			LOG_L(L_WARNING, "Failed to scan %s (%s)",
-					fullName.c_str(), error.c_str());
-
-			//! record it as broken, so we don't need to look inside everytime
-			BrokenArchive ba;
-			ba.path = fpath;
-			ba.modified = info.st_mtime;
-			ba.updated = true;
-			ba.problem = error;
-			brokenArchives[lcfn] = ba;
-			return;
+		if (ai.archiveData.GetName().empty()) {
+			//! FIXME The name will never be empty, if version is set (see HACK in ArchiveData)
+			ai.archiveData.SetInfoItemValueString("name", FileSystem::GetBasename(job.mapFile));
+		}
+		if (ai.archiveData.GetMapFile().empty()) {
+			ai.archiveData.SetInfoItemValueString("mapfile", job.mapFile);
 		}
+		AddDependency(ai.archiveData.GetDependencies(), "Map Helper v1");
+		ai.archiveData.SetInfoItemValueInteger("modType", modtype::map);
 
-		ai.path = fpath;
-		ai.modified = info.st_mtime;
-		ai.origName = fn;
-		ai.updated = true;
-
-		//! Optionally calculate a checksum for the file
-		//! To prevent reading all files in all directory (.sdd) archives
-		//! every time this function is called, directory archive checksums
-		//! are calculated on the fly.
-		if (doChecksum) {
-			ai.checksum = GetCRC(fullName);
-		} else {
-			ai.checksum = 0;
+		LOG_S(LOG_SECTION_ARCHIVESCANNER, "Found new map: %s",
+				ai.archiveData.GetName().c_str());
+	} else {
+		if (job.luaRead) {
+			ScanArchiveLua(job.luaBuf, job.luaFile, ai, error);
+		}
+		if (ai.archiveData.GetModType() == modtype::primary) {
+			AddDependency(ai.archiveData.GetDependencies(), "Spring content v1");
 		}
 
-		archiveInfos[lcfn] = ai;
+		LOG_S(LOG_SECTION_ARCHIVESCANNER, "Found new game: %s",
+				ai.archiveData.GetName().c_str());
 	}
-}
 
-bool CArchiveScanner::ScanArchiveLua(IArchive* ar, const std::string& fileName, ArchiveInfo& ai,  std::string& err)
-{
-	std::vector<boost::uint8_t> buf;
-	if (!ar->GetFile(fileName, buf)) {
-		return false;
+	if (!error.empty()) {
+		//! for some reason, the archive is marked as broken
+		LOG_L(L_WARNING, "Failed to scan %s (%s)",
+				job.fullName.c_str(), error.c_str());
+
+		//! record it as broken, so we don't need to look inside everytime
+		BrokenArchive ba;
+		ba.path = job.path;
+		ba.modified = job.modified;
+		ba.size = job.size;
+		ba.updated = true;
+		ba.problem = error;
+		brokenArchives[job.lcFileName] = ba;
+		return;
 	}
 
-	const std::string cleanbuf((char*)(&buf[0]), buf.size());
+	ai.path = job.path;
+	ai.modified = job.modified;
+	ai.size = job.size;
+	ai.origName = job.fileName;
+	ai.updated = true;
+	ai.checksum = 0;
+
+	archiveInfos[job.lcFileName] = ai;
+}
+
+bool CArchiveScanner::ScanArchiveLua(const std::vector<boost::uint8_t>& buf, const std::string& fileName, ArchiveInfo& ai, std::string& err)
+{
+	const std::string cleanbuf(buf.empty() ? "" : (const char*)(&buf[0]), buf.size());
 	LuaParser p(cleanbuf, SPRING_VFS_MOD);
 	if (!p.Execute()) {
 		err = "Error in " + fileName + ": " + p.GetErrorLog();
@@ -652,6 +751,39 @@ bool CArchiveScanner::ScanArchiveLua(IArchive* ar, const std::string& fileName,
 	return true;
 }
 
+unsigned int CArchiveScanner::CalcMissingChecksums()
+{
+	//! archives not found by the last scan are skipped,
+	//! replaced ones have no file (path) associated
+	std::vector<ArchiveInfo*> archives;
+	for (std::map<std::string, ArchiveInfo>::iterator aii = archiveInfos.begin(); aii != archiveInfos.end(); ++aii) {
+		ArchiveInfo& ai = aii->second;
+		if (ai.updated && (ai.checksum == 0) && ai.replaced.empty()) {
+			archives.push_back(&ai);
+		}
+	}
+
+	//! Hint: nested parallel regions are serialized, so the loop over the
+	//!       files in GetCRC only runs in parallel if there is just a single
+	//!       archive to checksum
+	const int numArchives = archives.size();
+	std::vector< std::vector<std::string> > archiveErrors(numArchives);
+	int i;
+	#pragma omp parallel for private(i) schedule(dynamic) if(numArchives > 1)
+	for (i = 0; i < numArchives; ++i) {
+		archives[i]->checksum = GetCRC(archives[i]->path + archives[i]->origName, archiveErrors[i]);
+	}
+
+	for (i = 0; i < numArchives; ++i) {
+		for (std::vector<std::string>::const_iterator it = archiveErrors[i].begin(); it != archiveErrors[i].end(); ++it) {
+			LOG_L(L_ERROR, "%s", it->c_str());
+		}
+	}
+
+	return numArchives;
+}
+
+
 IFileFilter* CArchiveScanner::CreateIgnoreFilter(IArchive* ar)
 {
 	IFileFilter* ignore = IFileFilter::Create();
@@ -678,14 +810,14 @@ struct CRCPair {
  * Get CRC of the data in the specified archive.
  * Returns 0 if file could not be opened.
  */
-unsigned int CArchiveScanner::GetCRC(const std::string& arcName)
+unsigned int CArchiveScanner::GetCRC(const std::string& arcName, std::vector<std::string>& errors)
 {
 	CRC crc;
 	IArchive* ar;
 	std::list<std::string> files;
 
 	//! Try to open an archive
-	ar = archiveLoader.OpenArchive(arcName);
+	ar = archiveLoader.OpenArchive(arcName, "", &errors);
 	if (!ar) {
 		return 0; // It wasn't an archive
 	}
@@ -743,11 +875,12 @@ unsigned int CArchiveScanner::GetCRC(const std::string& arcName)
 		crc.Update(it->nameCRC);
 		crc.Update(it->dataCRC);
 	#if !defined(DEDICATED) && !defined(UNITSYNC)
-		Watchdog::ClearTimer();
+		Watchdog::ClearTimer(WDT_MAIN);
 	#endif
 	}
 
 	delete ignore;
+	ar->TakeErrors(errors);
 	delete ar;
 
 	unsigned int digest = crc.GetDigest();
@@ -761,100 +894,190 @@ unsigned int CArchiveScanner::GetCRC(const std::string& arcName)
 	}
 }
 
-void CArchiveScanner::ReadCacheData(const std::string& filename)
+/*
+ * The cache is a flat binary file of native-endian 32bit integers and
+ * length-prefixed strings. Reading it is much faster than parsing the
+ * equivalent lua-table, which matters with thousands of archives.
+ * A cache from a different platform (or version) fails the header check
+ * and just causes a rescan.
+ */
+static const char CACHE_MAGIC[8] = {'S', 'p', 'r', 'A', 'r', 'c', 'h', 'C'};
+/// sanity limit for strings and element counts, guards against corrupt files
+static const boost::uint32_t CACHE_MAX_COUNT = 1 << 24;
+
+class CacheWriter
 {
-	if (!FileSystem::FileExists(filename)) {
-		LOG_L(L_INFO, "Archive cache doesn't exist: %s", filename.c_str());
-		return;
+public:
+	CacheWriter(FILE* out): out(out), good(true) {}
+
+	void WriteU32(boost::uint32_t v) {
+		good = good && (fwrite(&v, sizeof(v), 1, out) == 1);
+	}
+	void WriteU64(boost::uint64_t v) {
+		WriteU32(v & 0xFFFFFFFF);
+		WriteU32(v >> 32);
+	}
+	void WriteFloat(float v) {
+		boost::uint32_t u;
+		memcpy(&u, &v, sizeof(u));
+		WriteU32(u);
+	}
+	void WriteString(const std::string& s) {
+		WriteU32(s.size());
+		if (!s.empty()) {
+			good = good && (fwrite(s.data(), s.size(), 1, out) == 1);
+		}
+	}
+	void WriteStrings(const std::vector<std::string>& v) {
+		WriteU32(v.size());
+		for (std::vector<std::string>::const_iterator it = v.begin(); it != v.end(); ++it) {
+			WriteString(*it);
+		}
 	}
 
-	LuaParser p(filename, SPRING_VFS_RAW, SPRING_VFS_BASE);
+	bool IsGood() const { return good; }
 
-	if (!p.Execute()) {
-		LOG_L(L_ERROR, "Failed to parse archive cache: %s",
-				p.GetErrorLog().c_str());
-		return;
-	}
-	const LuaTable archiveCache = p.GetRoot();
-	const LuaTable archives = archiveCache.SubTable("archives");
+private:
+	FILE* out;
+	bool good;
+};
 
-	// Do not load old version caches
-	const int ver = archiveCache.GetInt("internalVer", (INTERNAL_VER + 1));
-	if (ver != INTERNAL_VER) {
-		return;
+class CacheReader
+{
+public:
+	CacheReader(FILE* in): in(in), good(true) {}
+
+	boost::uint32_t ReadU32() {
+		boost::uint32_t v = 0;
+		good = good && (fread(&v, sizeof(v), 1, in) == 1);
+		return v;
+	}
+	boost::uint64_t ReadU64() {
+		const boost::uint64_t lo = ReadU32();
+		const boost::uint64_t hi = ReadU32();
+		return (lo | (hi << 32));
+	}
+	float ReadFloat() {
+		const boost::uint32_t u = ReadU32();
+		float v;
+		memcpy(&v, &u, sizeof(v));
+		return v;
+	}
+	/// element counts and string lengths
+	boost::uint32_t ReadCount() {
+		const boost::uint32_t n = ReadU32();
+		good = good && (n <= CACHE_MAX_COUNT);
+		return (good? n: 0);
+	}
+	std::string ReadString() {
+		std::string s(ReadCount(), '\0');
+		if (!s.empty()) {
+			good = good && (fread(&s[0], s.size(), 1, in) == 1);
+		}
+		return s;
+	}
+	void ReadStrings(std::vector<std::string>& v) {
+		const boost::uint32_t n = ReadCount();
+		for (boost::uint32_t i = 0; (i < n) && good; ++i) {
+			v.push_back(ReadString());
+		}
 	}
 
-	for (int i = 1; archives.KeyExists(i); ++i) {
-		const LuaTable curArchive = archives.SubTable(i);
-		const LuaTable archived = curArchive.SubTable("archivedata");
-		ArchiveInfo ai;
+	bool IsGood() const { return good; }
 
-		ai.origName = curArchive.GetString("name", "");
-		ai.path     = curArchive.GetString("path", "");
+private:
+	FILE* in;
+	bool good;
+};
 
-		// do not use LuaTable.GetInt() for 32-bit integers, the Spring lua
-		// library uses 32-bit floats to represent numbers, which can only
-		// represent 2^24 consecutive integers
-		ai.modified = strtoul(curArchive.GetString("modified", "0").c_str(), 0, 10);
-		ai.checksum = strtoul(curArchive.GetString("checksum", "0").c_str(), 0, 10);
-		ai.updated = false;
 
-		ai.archiveData = CArchiveScanner::ArchiveData(archived, true);
-		if (ai.archiveData.GetModType() == modtype::map) {
-			AddDependency(ai.archiveData.GetDependencies(), "Map Helper v1");
-		} else if (ai.archiveData.GetModType() == modtype::primary) {
-			AddDependency(ai.archiveData.GetDependencies(), "Spring content v1");
-		}
+void CArchiveScanner::ReadCacheData(const std::string& filename)
+{
+	FILE* in = fopen(filename.c_str(), "rb");
+	if (!in) {
+		LOG_L(L_INFO, "Archive cache doesn't exist: %s", filename.c_str());
+		return;
+	}
+
+	CacheReader reader(in);
 
-		std::string lcname = StringToLower(ai.origName);
-		archiveInfos[lcname] = ai;
+	//! Do not load old version caches
+	char magic[sizeof(CACHE_MAGIC)];
+	if ((fread(magic, sizeof(magic), 1, in) != 1) || (memcmp(magic, CACHE_MAGIC, sizeof(magic)) != 0) || (reader.ReadU32() != INTERNAL_VER)) {
+		LOG_L(L_INFO, "Archive cache has an outdated format, rescanning: %s", filename.c_str());
+		fclose(in);
+		return;
 	}
 
-	const LuaTable brokenArchives = archiveCache.SubTable("brokenArchives");
+	//! read into temporaries, so a truncated file does not leave half of its entries behind
+	std::map<std::string, ArchiveInfo> cachedInfos;
+	std::map<std::string, BrokenArchive> cachedBroken;
 
-	for (int i = 1; brokenArchives.KeyExists(i); ++i) {
-		const LuaTable curArchive = brokenArchives.SubTable(i);
-		BrokenArchive ba;
-		std::string name = curArchive.GetString("name", "");
+	try {
+		const boost::uint32_t numArchives = reader.ReadCount();
+		for (boost::uint32_t a = 0; (a < numArchives) && reader.IsGood(); ++a) {
+			ArchiveInfo ai;
+			ai.origName = reader.ReadString();
+			ai.path     = reader.ReadString();
+			ai.modified = reader.ReadU32();
+			ai.size     = reader.ReadU64();
+			ai.checksum = reader.ReadU32();
+			ai.replaced = reader.ReadString();
+			ai.updated  = false;
+
+			ArchiveData& ad = ai.archiveData;
+			const boost::uint32_t numInfos = reader.ReadCount();
+			for (boost::uint32_t i = 0; (i < numInfos) && reader.IsGood(); ++i) {
+				const std::string key = reader.ReadString();
+				const boost::uint32_t valueType = reader.ReadU32();
+
+				switch (valueType) {
+					case INFO_VALUE_TYPE_STRING:  { ad.SetInfoItemValueString(key, reader.ReadString()); } break;
+					case INFO_VALUE_TYPE_INTEGER: { ad.SetInfoItemValueInteger(key, (int) reader.ReadU32()); } break;
+					case INFO_VALUE_TYPE_FLOAT:   { ad.SetInfoItemValueFloat(key, reader.ReadFloat()); } break;
+					case INFO_VALUE_TYPE_BOOL:    { ad.SetInfoItemValueBool(key, reader.ReadU32() != 0); } break;
+					default: {
+						throw content_error("invalid info-item type");
+					} break;
+				}
+			}
+			reader.ReadStrings(ad.GetDependencies());
+			reader.ReadStrings(ad.GetReplaces());
 
-		ba.path = curArchive.GetString("path", "");
-		ba.modified = strtoul(curArchive.GetString("modified", "0").c_str(), 0, 10);
-		ba.updated = false;
-		ba.problem = curArchive.GetString("problem", "unknown");
+			cachedInfos[StringToLower(ai.origName)] = ai;
+		}
 
-		StringToLowerInPlace(name);
-		this->brokenArchives[name] = ba;
-	}
+		const boost::uint32_t numBroken = reader.ReadCount();
+		for (boost::uint32_t b = 0; (b < numBroken) && reader.IsGood(); ++b) {
+			BrokenArchive ba;
+			const std::string name = reader.ReadString();
 
-	isDirty = false;
-}
+			ba.path     = reader.ReadString();
+			ba.modified = reader.ReadU32();
+			ba.size     = reader.ReadU64();
+			ba.problem  = reader.ReadString();
+			ba.updated  = false;
 
-static inline void SafeStr(FILE* out, const char* prefix, const std::string& str)
-{
-	if (str.empty()) {
+			cachedBroken[StringToLower(name)] = ba;
+		}
+	} catch (const content_error& ex) {
+		LOG_L(L_ERROR, "Failed to read archive cache %s: %s", filename.c_str(), ex.what());
+		fclose(in);
 		return;
 	}
-	if (str.find_first_of("\\\"") == std::string::npos) {
-		fprintf(out, "%s\"%s\",\n", prefix, str.c_str());
-	} else {
-		fprintf(out, "%s[[%s]],\n", prefix, str.c_str());
+
+	fclose(in);
+
+	if (!reader.IsGood()) {
+		LOG_L(L_ERROR, "Failed to read archive cache (truncated?): %s", filename.c_str());
+		return;
 	}
-}
 
-void FilterDep(std::vector<std::string>& deps, const std::string& exclude)
-{
-	bool clean = true;
-	do {
-		clean = true;
-		for (std::vector<std::string>::iterator it = deps.begin(); it != deps.end(); ++it) {
-			if (*it == exclude) {
-				deps.erase(it);
-				clean = false;
-				break;
-			}
-		}
-	} while (!clean);
-};
+	archiveInfos.swap(cachedInfos);
+	brokenArchives.swap(cachedBroken);
+
+	isDirty = false;
+}
 
 void CArchiveScanner::WriteCacheData(const std::string& filename)
 {
@@ -862,9 +1085,14 @@ void CArchiveScanner::WriteCacheData(const std::string& filename)
 		return;
 	}
 
-	FILE* out = fopen(filename.c_str(), "wt");
+	//! write to a temporary file first, so an interrupted write
+	//! (crash, full disk, concurrent unitsync/spring) never leaves
+	//! a corrupt cache behind
+	const std::string tmpFilename = filename + ".tmp";
+
+	FILE* out = fopen(tmpFilename.c_str(), "wb");
 	if (!out) {
-		LOG_L(L_ERROR, "Failed to write to \"%s\"!", filename.c_str());
+		LOG_L(L_ERROR, "Failed to write to \"%s\"!", tmpFilename.c_str());
 		return;
 	}
 
@@ -885,88 +1113,74 @@ void CArchiveScanner::WriteCacheData(const std::string& filename)
 		}
 	}
 
-	fprintf(out, "local archiveCache = {\n\n");
-	fprintf(out, "\tinternalver = %i,\n\n", INTERNAL_VER);
-	fprintf(out, "\tarchives = {  -- count = "_STPF_"\n", archiveInfos.size());
+	CacheWriter writer(out);
+
+	fwrite(CACHE_MAGIC, sizeof(CACHE_MAGIC), 1, out);
+	writer.WriteU32(INTERNAL_VER);
+	writer.WriteU32(archiveInfos.size());
 
 	std::map<std::string, ArchiveInfo>::const_iterator arcIt;
 	for (arcIt = archiveInfos.begin(); arcIt != archiveInfos.end(); ++arcIt) {
 		const ArchiveInfo& arcInfo = arcIt->second;
 
-		fprintf(out, "\t\t{\n");
-		SafeStr(out, "\t\t\tname = ",              arcInfo.origName);
-		SafeStr(out, "\t\t\tpath = ",              arcInfo.path);
-		fprintf(out, "\t\t\tmodified = \"%u\",\n", arcInfo.modified);
-		fprintf(out, "\t\t\tchecksum = \"%u\",\n", arcInfo.checksum);
-		SafeStr(out, "\t\t\treplaced = ",          arcInfo.replaced);
+		writer.WriteString(arcInfo.origName);
+		writer.WriteString(arcInfo.path);
+		writer.WriteU32(arcInfo.modified);
+		writer.WriteU64(arcInfo.size);
+		writer.WriteU32(arcInfo.checksum);
+		writer.WriteString(arcInfo.replaced);
 
-		// mod info?
+		// mod info
 		const ArchiveData& archData = arcInfo.archiveData;
-		if (!archData.GetName().empty()) {
-			fprintf(out, "\t\t\tarchivedata = {\n");
-
-			const std::map<std::string, InfoItem>& info = archData.GetInfo();
-			std::map<std::string, InfoItem>::const_iterator ii;
-			for (ii = info.begin(); ii != info.end(); ++ii) {
-				switch (ii->second.valueType) {
-					case INFO_VALUE_TYPE_STRING: {
-						SafeStr(out, std::string("\t\t\t\t" + ii->first + " = ").c_str(), ii->second.valueTypeString);
-					} break;
-					case INFO_VALUE_TYPE_INTEGER: {
-						fprintf(out, "\t\t\t\t%s = %d,\n", ii->first.c_str(), ii->second.value.typeInteger);
-					} break;
-					case INFO_VALUE_TYPE_FLOAT: {
-						fprintf(out, "\t\t\t\t%s = %f,\n", ii->first.c_str(), ii->second.value.typeFloat);
-					} break;
-					case INFO_VALUE_TYPE_BOOL: {
-						fprintf(out, "\t\t\t\t%s = %d,\n", ii->first.c_str(), (int)ii->second.value.typeBool);
-					} break;
-				}
-			}
-
-			std::vector<std::string> deps = archData.GetDependencies();
-			if (archData.GetModType() == modtype::map) {
-				FilterDep(deps, "Map Helper v1");
-			} else if (archData.GetModType() == modtype::primary) {
-				FilterDep(deps, "Spring content v1");
-			}
-			
-			if (!deps.empty()) {
-				fprintf(out, "\t\t\t\tdepend = {\n");
-				for (unsigned d = 0; d < deps.size(); d++) {
-					SafeStr(out, "\t\t\t\t\t", deps[d]);
-				}
-				fprintf(out, "\t\t\t\t},\n");
+		const std::map<std::string, InfoItem>& info = archData.GetInfo();
+		writer.WriteU32(info.size());
+
+		std::map<std::string, InfoItem>::const_iterator ii;
+		for (ii = info.begin(); ii != info.end(); ++ii) {
+			writer.WriteString(ii->second.key);
+			writer.WriteU32(ii->second.valueType);
+
+			switch (ii->second.valueType) {
+				case INFO_VALUE_TYPE_STRING:  { writer.WriteString(ii->second.valueTypeString); } break;
+				case INFO_VALUE_TYPE_INTEGER: { writer.WriteU32(ii->second.value.typeInteger); } break;
+				case INFO_VALUE_TYPE_FLOAT:   { writer.WriteFloat(ii->second.value.typeFloat); } break;
+				case INFO_VALUE_TYPE_BOOL:    { writer.WriteU32(ii->second.value.typeBool); } break;
 			}
-			fprintf(out, "\t\t\t},\n");
 		}
 
-		fprintf(out, "\t\t},\n");
+		writer.WriteStrings(archData.GetDependencies());
+		writer.WriteStrings(archData.GetReplaces());
 	}
 
-	fprintf(out, "\t},\n\n"); // close 'archives'
-
-	fprintf(out, "\tbrokenArchives = {  -- count = "_STPF_"\n", brokenArchives.size());
+	writer.WriteU32(brokenArchives.size());
 
 	std::map<std::string, BrokenArchive>::const_iterator bai;
 	for (bai = brokenArchives.begin(); bai != brokenArchives.end(); ++bai) {
 		const BrokenArchive& ba = bai->second;
 
-		fprintf(out, "\t\t{\n");
-		SafeStr(out, "\t\t\tname = ", bai->first);
-		SafeStr(out, "\t\t\tpath = ", ba.path);
-		fprintf(out, "\t\t\tmodified = \"%u\",\n", ba.modified);
-		SafeStr(out, "\t\t\tproblem = ", ba.problem);
-		fprintf(out, "\t\t},\n");
+		writer.WriteString(bai->first);
+		writer.WriteString(ba.path);
+		writer.WriteU32(ba.modified);
+		writer.WriteU64(ba.size);
+		writer.WriteString(ba.problem);
 	}
 
-	fprintf(out, "\t},\n"); // close 'brokenArchives'
-
-	fprintf(out, "}\n\n"); // close 'archiveCache'
-	fprintf(out, "return archiveCache\n");
+	if ((fclose(out) == EOF) || !writer.IsGood()) {
+		LOG_L(L_ERROR, "Failed to write to \"%s\"!", tmpFilename.c_str());
+		remove(tmpFilename.c_str());
+		return;
+	}
 
-	if (fclose(out) == EOF)
-		LOG_L(L_ERROR, "Failed to write to \"%s\"!", filename.c_str());
+#ifdef _WIN32
+	//! rename() does not replace existing files on windows; if we die
+	//! in between, the cache is just missing and gets rebuilt next time
+	remove(filename.c_str());
+#endif
+	if (rename(tmpFilename.c_str(), filename.c_str()) != 0) {
+		LOG_L(L_ERROR, "Failed to replace \"%s\"!", filename.c_str());
+		remove(tmpFilename.c_str());
+		return;
+	}
 
 	isDirty = false;
 }
@@ -1062,7 +1276,7 @@ std::vector<std::string> CArchiveScanner::GetArchives(const std::string& root, i
 		for (std::vector<std::string>::const_iterator j = dep.begin(); j != dep.end(); ++j) {
 			if (std::find(ret.begin(), ret.end(), *j) == ret.end()) {
 				//! add only if this dependency is not already somewhere
-				//! in the chain (which can happen if ArchiveCache.lua has
+				//! in the chain (which can happen if ArchiveCache.bin has
 				//! not been written yet) so its checksum is not XOR'ed
 				//! with the running one multiple times (Get*Checksum())
 				ret.push_back(*j);
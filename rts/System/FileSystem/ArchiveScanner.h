@@ -6,6 +6,7 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <boost/cstdint.hpp>
 #include "System/Info.h"
 
 class IArchive;
@@ -22,6 +23,10 @@ class LuaTable;
  *
  * The archive namespace is global, so it is not allowed to have an archive with
  * the same name in more than one folder.
+ *
+ * Archives that are not cached yet are opened concurrently (OpenMP), only the
+ * evaluation of their modinfo.lua/mapinfo.lua is done serially. Checksums of
+ * all archives found are calculated concurrently as well.
  */
 
 namespace modtype
@@ -151,12 +156,14 @@ private:
 	{
 		ArchiveInfo()
 			: modified(0)
+			, size(0)
 			, checksum(0)
 			, updated(false)
 			{}
 		std::string path;
 		std::string origName;     ///< Could be useful to have the non-lowercased name around
 		unsigned int modified;
+		boost::uint64_t size;     ///< together with path and modified, used to detect changed archives
 		ArchiveData archiveData;
 		unsigned int checksum;
 		bool updated;
@@ -166,21 +173,47 @@ private:
 	{
 		BrokenArchive()
 			: modified(0)
+			, size(0)
 			, updated(false)
 			{}
 		std::string path;
 		unsigned int modified;
+		boost::uint64_t size;
 		bool updated;
 		std::string problem;
 	};
 
+	/// an archive which has to be opened during a scan
+	struct ArchiveScanJob;
+
 private:
 	void ScanDirs(const std::vector<std::string>& dirs, bool checksum = false);
-	void Scan(const std::string& curPath, bool doChecksum);
+	/**
+	 * Scans all archives in the given directory that are not cached yet.
+	 * @param numFound increased by the number of archives found
+	 * @param numScanned increased by the number of archives that had to be opened
+	 */
+	void Scan(const std::string& curPath, unsigned int& numFound, unsigned int& numScanned);
 
-	void ScanArchive(const std::string& fullName, bool checksum = false);
+	/**
+	 * Checks the cache (and the list of broken archives) for an up to date
+	 * entry of the archive, and marks it as found.
+	 * @return false if the archive has to be (re)scanned
+	 */
+	bool CheckCachedArchive(const std::string& lcfn, const std::string& fpath, unsigned int modified, boost::uint64_t size);
+	/// reads modinfo/mapinfo etc. of the job's archive, thread-safe
+	static void ReadArchiveMetaData(ArchiveScanJob& job);
+	/// evaluates the data read by ReadArchiveMetaData, not thread-safe
+	void AddScannedArchive(const ArchiveScanJob& job);
 	/// scan mapinfo / modinfo lua files
-	bool ScanArchiveLua(IArchive* ar, const std::string& fileName, ArchiveInfo& ai, std::string& err);
+	bool ScanArchiveLua(const std::vector<boost::uint8_t>& buf, const std::string& fileName, ArchiveInfo& ai, std::string& err);
+
+	/**
+	 * Calculates the checksums of all archives found during the last scan
+	 * which do not have one yet.
+	 * @return the number of checksums calculated
+	 */
+	unsigned int CalcMissingChecksums();
 
 	void ReadCacheData(const std::string& filename);
 	void WriteCacheData(const std::string& filename);
@@ -190,8 +223,10 @@ private:
 	/**
 	 * Get CRC of the data in the specified archive.
 	 * Returns 0 if file could not be opened.
+	 * @param errors errors of the archive are appended to it, instead of
+	 *   being logged (see CArchiveLoader::OpenArchive)
 	 */
-	unsigned int GetCRC(const std::string& filename);
+	unsigned int GetCRC(const std::string& filename, std::vector<std::string>& errors);
 
 private:
 	std::map<std::string, ArchiveInfo> archiveInfos;
@@ -15,18 +15,49 @@ CBufferedArchive::~CBufferedArchive()
 
 bool CBufferedArchive::GetFile(unsigned int fid, std::vector<boost::uint8_t>& buffer)
 {
-	boost::mutex::scoped_lock lck(archiveLock);
+	CFileView view;
+	const bool ret = GetFileView(fid, view);
+
+	view.CopyTo(buffer);
+	return ret;
+}
+
+bool CBufferedArchive::GetFileView(unsigned int fid, CFileView& view)
+{
 	assert(IsFileId(fid));
 
-	if (fid >= cache.size()) {
-		cache.resize(fid + 1);
+	{
+		boost::mutex::scoped_lock lck(archiveLock);
+
+		if (GetFileViewImpl(fid, view)) {
+			return true;
+		}
+
+		if (fid >= cache.size()) {
+			cache.resize(fid + 1);
+		}
+
+		if (cache[fid].populated) {
+			view = cache[fid].data;
+			return cache[fid].exists;
+		}
 	}
-	
-	if (!cache[fid].populated) {
-		cache[fid].exists = GetFileImpl(fid, cache[fid].data);
-		cache[fid].populated = true;
+
+	// read without holding the lock, so different files can be
+	// uncompressed concurrently; if two threads happen to read the same
+	// file at once, the first one to finish fills the cache
+	std::vector<boost::uint8_t> buffer;
+	const bool exists = GetFileImpl(fid, buffer);
+
+	boost::mutex::scoped_lock lck(archiveLock);
+
+	FileBuffer& fb = cache[fid];
+	if (!fb.populated) {
+		fb.exists = exists;
+		fb.data = CFileView(buffer);
+		fb.populated = true;
 	}
 
-	buffer = cache[fid].data;
-	return cache[fid].exists;
+	view = fb.data;
+	return fb.exists;
 }
@@ -10,7 +10,9 @@
 
 /**
  * Provides a helper implementation for archive types that can only uncompress
- * one file to memory at a time.
+ * whole files to memory.
+ * Files read once are kept in memory, and shared with all views handed out
+ * for them.
  */
 class CBufferedArchive : public IArchive
 {
@@ -19,17 +21,29 @@ public:
 	virtual ~CBufferedArchive();
 
 	virtual bool GetFile(unsigned int fid, std::vector<boost::uint8_t>& buffer);
+	virtual bool GetFileView(unsigned int fid, CFileView& view);
 
 protected:
+	/**
+	 * Reads a file that is not cached yet.
+	 * Called without archiveLock held, possibly by multiple threads at once,
+	 * so implementations have to be threadsafe.
+	 */
 	virtual bool GetFileImpl(unsigned int fid, std::vector<boost::uint8_t>& buffer) = 0;
-
-	boost::mutex archiveLock; // neither 7zip nor zlib are threadsafe
+	/**
+	 * Allows subclasses to hand out a file without decompressing it,
+	 * for example by memory-mapping it. Called with archiveLock held.
+	 * @return false if the file has to be read (and cached) by GetFileImpl
+	 */
+	virtual bool GetFileViewImpl(unsigned int fid, CFileView& view) { return false; }
+
+	boost::mutex archiveLock; // guards the cache
 	struct FileBuffer
 	{
 		FileBuffer() : populated(false), exists(false) {};
 		bool populated; // cause a file may be 0 bytes big
 		bool exists;
-		std::vector<boost::uint8_t> data;
+		CFileView data;
 	};
 	std::vector<FileBuffer> cache; // cache[fileId]
 };
@@ -6,12 +6,16 @@
 #include <assert.h>
 #include <fstream>
 
+#include "MemoryMappedFile.h"
 #include "System/FileSystem/DataDirsAccess.h"
 #include "System/FileSystem/FileSystem.h"
 #include "System/FileSystem/FileQueryFlags.h"
 #include "System/Util.h"
 
 
+const size_t CDirArchive::MIN_MAPPED_FILE_SIZE = 64 * 1024;
+
+
 CDirArchiveFactory::CDirArchiveFactory()
 	: IArchiveFactory("sdd")
 {
@@ -77,6 +81,27 @@ bool CDirArchive::GetFile(unsigned int fid, std::vector<boost::uint8_t>& buffer)
 	}
 }
 
+bool CDirArchive::GetFileView(unsigned int fid, CFileView& view)
+{
+	assert(IsFileId(fid));
+
+	const std::string rawpath = dataDirsAccess.LocateFile(dirName + searchFiles[fid]);
+
+	if (FileSystem::GetFileSize(rawpath) < MIN_MAPPED_FILE_SIZE) {
+		return IArchive::GetFileView(fid, view);
+	}
+
+	const boost::shared_ptr<CMemoryMappedFile> mappedFile(new CMemoryMappedFile(rawpath));
+
+	if (mappedFile->IsOpen()) {
+		view = CFileView(mappedFile, mappedFile->GetData(), mappedFile->GetSize());
+		return true;
+	}
+
+	// fall back to reading, if mapping failed
+	return IArchive::GetFileView(fid, view);
+}
+
 void CDirArchive::FileInfo(unsigned int fid, std::string& name, int& size) const
 {
 	assert(IsFileId(fid));
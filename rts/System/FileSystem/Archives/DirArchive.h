@@ -36,9 +36,18 @@ public:
 	
 	virtual unsigned int NumFiles() const;
 	virtual bool GetFile(unsigned int fid, std::vector<boost::uint8_t>& buffer);
+	/// memory-maps the file, if it is at least MIN_MAPPED_FILE_SIZE big
+	virtual bool GetFileView(unsigned int fid, CFileView& view);
 	virtual void FileInfo(unsigned int fid, std::string& name, int& size) const;
 	
 private:
+	/**
+	 * Smaller files are read into a buffer: mapping them costs more than
+	 * copying, and each mapped file risks a SIGBUS on access if it gets
+	 * truncated on disk while the view exists.
+	 */
+	static const size_t MIN_MAPPED_FILE_SIZE;
+
 	/// "ExampleArchive.sdd/"
 	std::string dirName;
 
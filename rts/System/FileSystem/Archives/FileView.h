@@ -0,0 +1,62 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef _FILE_VIEW_H
+#define _FILE_VIEW_H
+
+#include <vector>
+#include <boost/cstdint.hpp>
+#include <boost/shared_ptr.hpp>
+
+/**
+ * Read-only view of the contents of a file in an archive.
+ *
+ * Depending on the archive type, the data is either memory-mapped directly
+ * from disk or shared with a buffer held by the archive, so copying a view
+ * never copies the data. The data stays valid as long as any copy of the view
+ * exists, even if the archive it came from has been closed in the meantime.
+ */
+class CFileView
+{
+public:
+	CFileView()
+		: data(NULL)
+		, size(0)
+		{}
+	/**
+	 * @param owner keeps the memory pointed to by data alive
+	 */
+	CFileView(const boost::shared_ptr<const void>& owner, const boost::uint8_t* data, size_t size)
+		: owner(owner)
+		, data(data)
+		, size(size)
+		{}
+	/**
+	 * Takes over the contents of buffer, which is left empty.
+	 */
+	explicit CFileView(std::vector<boost::uint8_t>& buffer)
+		: data(NULL)
+		, size(buffer.size())
+	{
+		if (!buffer.empty()) {
+			boost::shared_ptr<std::vector<boost::uint8_t> > ownedBuffer(new std::vector<boost::uint8_t>());
+			ownedBuffer->swap(buffer);
+			data = &(*ownedBuffer)[0];
+			owner = ownedBuffer;
+		}
+	}
+
+	const boost::uint8_t* GetData() const { return data; }
+	size_t GetSize() const { return size; }
+	bool IsEmpty() const { return (size == 0); }
+
+	void CopyTo(std::vector<boost::uint8_t>& buffer) const {
+		buffer.assign(data, data + size);
+	}
+
+private:
+	boost::shared_ptr<const void> owner;
+	const boost::uint8_t* data;
+	size_t size;
+};
+
+#endif // _FILE_VIEW_H
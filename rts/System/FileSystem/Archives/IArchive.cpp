@@ -4,9 +4,11 @@
 
 #include "System/CRC.h"
 #include "System/Util.h"
+#include "System/Log/ILog.h"
 
 IArchive::IArchive(const std::string& archiveName)
 	: archiveFile(archiveName)
+	, collectErrors(true)
 {
 }
 
@@ -35,6 +37,31 @@ unsigned int IArchive::FindFile(const std::string& filePath) const
 	}
 }
 
+void IArchive::StopCollectingErrors()
+{
+	collectErrors = false;
+
+	for (std::vector<std::string>::const_iterator it = collectedErrors.begin(); it != collectedErrors.end(); ++it) {
+		LOG_L(L_ERROR, "%s", it->c_str());
+	}
+	collectedErrors.clear();
+}
+
+void IArchive::TakeErrors(std::vector<std::string>& errors)
+{
+	errors.insert(errors.end(), collectedErrors.begin(), collectedErrors.end());
+	collectedErrors.clear();
+}
+
+void IArchive::LogError(const std::string& error)
+{
+	if (collectErrors) {
+		collectedErrors.push_back(error);
+	} else {
+		LOG_L(L_ERROR, "%s", error.c_str());
+	}
+}
+
 bool IArchive::HasLowReadingCost(unsigned int fid) const
 {
 	return true;
@@ -63,3 +90,23 @@ bool IArchive::GetFile(const std::string& name, std::vector<boost::uint8_t>& buf
 
 	return found;
 }
+
+bool IArchive::GetFileView(unsigned int fid, CFileView& view)
+{
+	std::vector<boost::uint8_t> buffer;
+	const bool ret = GetFile(fid, buffer);
+
+	view = CFileView(buffer);
+	return ret;
+}
+
+bool IArchive::GetFileView(const std::string& name, CFileView& view)
+{
+	const unsigned int fid = FindFile(name);
+
+	if (fid < NumFiles()) {
+		return GetFileView(fid, view);
+	}
+
+	return false;
+}
@@ -8,6 +8,8 @@
 #include <map>
 #include <boost/cstdint.hpp>
 
+#include "FileView.h"
+
 /**
  * @brief Abstraction of different archive types
  *
@@ -72,6 +74,21 @@ public:
 	 * @see GetFile(unsigned int fid, std::vector<boost::uint8_t>& buffer)
 	 */
 	bool GetFile(const std::string& name, std::vector<boost::uint8_t>& buffer);
+	/**
+	 * Fetches the content of a file by its ID, avoiding copies where the
+	 * archive type allows it (uncompressed files are memory-mapped).
+	 * The default implementation wraps the buffer filled by GetFile.
+	 * @param fid file ID in [0, NumFiles())
+	 * @param view on success, this will refer to the contents of the file
+	 * @return true if the file was found, and its contents have been
+	 *   successfully read
+	 */
+	virtual bool GetFileView(unsigned int fid, CFileView& view);
+	/**
+	 * Fetches the content of a file by its name.
+	 * @see GetFileView(unsigned int fid, CFileView& view)
+	 */
+	bool GetFileView(const std::string& name, CFileView& view);
 	/**
 	 * Fetches the name and size in bytes of a file by its ID.
 	 */
@@ -93,14 +110,32 @@ public:
 	 */
 	virtual unsigned int GetCrc32(unsigned int fid);
 
+	/**
+	 * Errors are collected from construction on, until the first call of
+	 * this, which logs the ones collected so far and all later ones.
+	 * Archives read on worker threads keep collecting, as those threads
+	 * must not log (see CArchiveLoader::OpenArchive).
+	 */
+	void StopCollectingErrors();
+	/**
+	 * Moves the errors collected so far to the end of errors.
+	 */
+	void TakeErrors(std::vector<std::string>& errors);
+
 
 protected:
+	/// Logs an error of this archive, or collects it (see StopCollectingErrors)
+	void LogError(const std::string& error);
+
 	/// must be populated by the subclass
 	std::map<std::string, unsigned int> lcNameIndex;
 
 private:
 	/// "ExampleArchive.sdd"
 	const std::string archiveFile;
+
+	bool collectErrors;
+	std::vector<std::string> collectedErrors;
 };
 
 #endif // _ARCHIVE_BASE_H
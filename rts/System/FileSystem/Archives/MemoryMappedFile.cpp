@@ -0,0 +1,91 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+
+#include "MemoryMappedFile.h"
+
+#ifndef _WIN32
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#else
+	#include <windows.h>
+#endif
+
+
+#ifndef _WIN32
+
+CMemoryMappedFile::CMemoryMappedFile(const std::string& filePath)
+	: data(NULL)
+	, size(0)
+{
+	const int fd = open(filePath.c_str(), O_RDONLY);
+	if (fd < 0) {
+		return;
+	}
+
+	struct stat info;
+	if ((fstat(fd, &info) == 0) && S_ISREG(info.st_mode) && (info.st_size > 0)) {
+		void* mapped = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (mapped != MAP_FAILED) {
+			data = static_cast<const boost::uint8_t*>(mapped);
+			size = info.st_size;
+		}
+	}
+
+	// the mapping keeps its own reference to the file
+	close(fd);
+}
+
+CMemoryMappedFile::~CMemoryMappedFile()
+{
+	if (data != NULL) {
+		munmap(const_cast<boost::uint8_t*>(data), size);
+	}
+}
+
+#else
+
+CMemoryMappedFile::CMemoryMappedFile(const std::string& filePath)
+	: data(NULL)
+	, size(0)
+	, fileHandle(NULL)
+	, mappingHandle(NULL)
+{
+	HANDLE file = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE) {
+		return;
+	}
+	fileHandle = file;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize) || (fileSize.QuadPart <= 0) || (fileSize.QuadPart > (LONGLONG)((size_t)-1))) {
+		return;
+	}
+
+	mappingHandle = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mappingHandle == NULL) {
+		return;
+	}
+
+	void* mapped = MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+	if (mapped != NULL) {
+		data = static_cast<const boost::uint8_t*>(mapped);
+		size = fileSize.QuadPart;
+	}
+}
+
+CMemoryMappedFile::~CMemoryMappedFile()
+{
+	if (data != NULL) {
+		UnmapViewOfFile(data);
+	}
+	if (mappingHandle != NULL) {
+		CloseHandle(mappingHandle);
+	}
+	if (fileHandle != NULL) {
+		CloseHandle(fileHandle);
+	}
+}
+
+#endif
@@ -0,0 +1,38 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef _MEMORY_MAPPED_FILE_H
+#define _MEMORY_MAPPED_FILE_H
+
+#include <string>
+#include <boost/cstdint.hpp>
+#include <boost/noncopyable.hpp>
+
+/**
+ * Read-only mapping of a whole file into memory.
+ * Pages are loaded on demand and shared with the OS file cache, so unlike
+ * a buffer filled by read(), they do not add to the private memory of the
+ * process.
+ * Empty files can not be mapped, IsOpen() returns false for them.
+ */
+class CMemoryMappedFile : public boost::noncopyable
+{
+public:
+	CMemoryMappedFile(const std::string& filePath);
+	~CMemoryMappedFile();
+
+	bool IsOpen() const { return (data != NULL); }
+
+	const boost::uint8_t* GetData() const { return data; }
+	size_t GetSize() const { return size; }
+
+private:
+	const boost::uint8_t* data;
+	size_t size;
+
+#ifdef _WIN32
+	void* fileHandle;
+	void* mappingHandle;
+#endif
+};
+
+#endif // _MEMORY_MAPPED_FILE_H
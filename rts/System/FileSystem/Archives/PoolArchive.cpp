@@ -13,7 +13,6 @@
 #include "System/FileSystem/DataDirsAccess.h"
 #include "System/FileSystem/FileSystem.h"
 #include "System/Util.h"
-#include "System/Log/ILog.h"
 
 
 CPoolArchiveFactory::CPoolArchiveFactory()
@@ -54,7 +53,7 @@ CPoolArchive::CPoolArchive(const std::string& name)
 
 	gzFile in = gzopen(name.c_str(), "rb");
 	if (in == NULL) {
-		LOG_L(L_ERROR, "couldn't open %s", name.c_str());
+		LogError("couldn't open " + name);
 		return;
 	}
 
@@ -114,6 +113,17 @@ unsigned int CPoolArchive::GetCrc32(unsigned int fid)
 	return files[fid]->crc32;
 }
 
+bool CPoolArchive::GetFile(unsigned int fid, std::vector<boost::uint8_t>& buffer)
+{
+	return GetFileImpl(fid, buffer);
+}
+
+bool CPoolArchive::GetFileView(unsigned int fid, CFileView& view)
+{
+	// skip the cache of CBufferedArchive
+	return IArchive::GetFileView(fid, view);
+}
+
 
 bool CPoolArchive::GetFileImpl(unsigned int fid, std::vector<boost::uint8_t>& buffer)
 {
@@ -138,7 +148,7 @@ bool CPoolArchive::GetFileImpl(unsigned int fid, std::vector<boost::uint8_t>& bu
 	std::string path = dataDirsAccess.LocateFile(rpath);
 	gzFile in = gzopen(path.c_str(), "rb");
 	if (in == NULL){
-		LOG_L(L_ERROR, "couldn't open %s", path.c_str());
+		LogError("couldn't open " + path);
 		return false;
 	}
 
@@ -149,7 +159,7 @@ bool CPoolArchive::GetFileImpl(unsigned int fid, std::vector<boost::uint8_t>& bu
 	gzclose(in);
 
 	if (bytesread != len) {
-		LOG_L(L_ERROR, "couldn't read %s", path.c_str());
+		LogError("couldn't read " + path);
 		buffer.clear();
 		return false;
 	}
@@ -83,6 +83,14 @@ public:
 	virtual void FileInfo(unsigned int fid, std::string& name, int& size) const;
 	virtual unsigned GetCrc32(unsigned int fid);
 
+	/**
+	 * Pool files are independent files on disk, so they are read without
+	 * locking, and are not kept in the cache of CBufferedArchive.
+	 * They are gzip compressed, and thus can not be memory-mapped.
+	 */
+	virtual bool GetFile(unsigned int fid, std::vector<boost::uint8_t>& buffer);
+	virtual bool GetFileView(unsigned int fid, CFileView& view);
+
 protected:
 	virtual bool GetFileImpl(unsigned int fid, std::vector<boost::uint8_t>& buffer);
 
@@ -10,17 +10,19 @@
 extern "C" {
 #include "lib/7z/Types.h"
 #include "lib/7z/Archive/7z/7zAlloc.h"
-#include "lib/7z/Archive/7z/7zExtract.h"
+#include "lib/7z/Archive/7z/7zDecode.h"
 #include "lib/7z/7zCrc.h"
 }
 
 #include "System/Util.h"
-#include "System/Log/ILog.h"
 
 
 CSevenZipArchiveFactory::CSevenZipArchiveFactory()
 	: IArchiveFactory("sd7")
 {
+	// done once here, as archives may be opened concurrently
+	// (see CArchiveScanner::Scan), and this writes g_CrcTable
+	CrcGenerateTable();
 }
 
 IArchive* CSevenZipArchiveFactory::DoCreateArchive(const std::string& filePath) const
@@ -33,10 +35,6 @@ CSevenZipArchive::CSevenZipArchive(const std::string& name) :
 	IArchive(name),
 	isOpen(false)
 {
-	blockIndex = 0xFFFFFFFF;
-	outBuffer = NULL;
-	outBufferSize = 0;
-
 	allocImp.Alloc = SzAlloc;
 	allocImp.Free = SzFree;
 
@@ -45,23 +43,17 @@ CSevenZipArchive::CSevenZipArchive(const std::string& name) :
 
 	SzArEx_Init(&db);
 
-	WRes wres = InFile_Open(&archiveStream.file, name.c_str());
-	if (wres) {
+	WRes wres = 0;
+	Stream* stream = OpenStream(wres);
+	if (stream == NULL) {
 		boost::system::error_code e(wres, boost::system::get_system_category());
-		LOG_L(L_ERROR, "Error opening %s: %s (%i)",
-				name.c_str(), e.message().c_str(), e.value());
+		LogError("Error opening " + name + ": " + e.message()
+				+ " (" + IntToString(e.value()) + ")");
 		return;
 	}
 
-	FileInStream_CreateVTable(&archiveStream);
-	LookToRead_CreateVTable(&lookStream, False);
-
-	lookStream.realStream = &archiveStream.s;
-	LookToRead_Init(&lookStream);
-
-	CrcGenerateTable();
-
-	SRes res = SzArEx_Open(&db, &lookStream.s, &allocImp, &allocTempImp);
+	SRes res = SzArEx_Open(&db, &stream->lookStream.s, &allocImp, &allocTempImp);
+	freeStreams.push_back(stream);
 	if (res == SZ_OK) {
 		isOpen = true;
 	} else {
@@ -90,7 +82,7 @@ CSevenZipArchive::CSevenZipArchive(const std::string& name) :
 				error = "Unknown error";
 				break;
 		}
-		LOG_L(L_ERROR, "Error opening %s: %s", name.c_str(), error.c_str());
+		LogError("Error opening " + name + ": " + error);
 		return;
 	}
 
@@ -100,6 +92,7 @@ CSevenZipArchive::CSevenZipArchive(const std::string& name) :
 	for (int fi = 0; fi < db.db.NumFolders; fi++) {
 		folderUnpackSizes[fi] = SzFolder_GetUnpackSize(db.db.Folders + fi);
 	}
+	std::vector<size_t> folderFileOffsets(db.db.NumFolders, 0);
 
 	// Get contents of archive and store name->int mapping
 	for (unsigned int i = 0; i < db.db.NumFiles; ++i) {
@@ -112,6 +105,7 @@ CSevenZipArchive::CSevenZipArchive(const std::string& name) :
 			fd.fp = i;
 			fd.size = f->Size;
 			fd.crc = (f->Size > 0) ? f->FileCRC : 0;
+			fd.blockOffset = 0;
 			const UInt32 folderIndex = db.FileIndexToFolderIndexMap[i];
 			if (folderIndex == ((UInt32)-1)) {
 				// file has no folder assigned
@@ -120,6 +114,9 @@ CSevenZipArchive::CSevenZipArchive(const std::string& name) :
 			} else {
 				fd.unpackedSize = folderUnpackSizes[folderIndex];
 				fd.packedSize   = db.db.PackSizes[folderIndex];
+				// files are stored consecutively in their block
+				fd.blockOffset = folderFileOffsets[folderIndex];
+				folderFileOffsets[folderIndex] += f->Size;
 			}
 
 			StringToLowerInPlace(fileName);
@@ -133,11 +130,11 @@ CSevenZipArchive::CSevenZipArchive(const std::string& name) :
 
 CSevenZipArchive::~CSevenZipArchive()
 {
-	if (outBuffer) {
-		IAlloc_Free(&allocImp, outBuffer);
-	}
-	if (isOpen) {
-		File_Close(&archiveStream.file);
+	// views may still reference decoded blocks, those free themselves
+	lastBlock.reset();
+
+	for (std::vector<Stream*>::iterator si = freeStreams.begin(); si != freeStreams.end(); ++si) {
+		CloseStream(*si);
 	}
 	SzArEx_Free(&db, &allocImp);
 }
@@ -152,24 +149,206 @@ unsigned int CSevenZipArchive::NumFiles() const
 	return fileData.size();
 }
 
-bool CSevenZipArchive::GetFile(unsigned int fid, std::vector<boost::uint8_t>& buffer)
+
+CSevenZipArchive::Stream* CSevenZipArchive::OpenStream(WRes& wres) const
+{
+	Stream* stream = new Stream();
+
+	wres = InFile_Open(&stream->archiveStream.file, GetArchiveName().c_str());
+	if (wres) {
+		delete stream;
+		return NULL;
+	}
+
+	FileInStream_CreateVTable(&stream->archiveStream);
+	LookToRead_CreateVTable(&stream->lookStream, False);
+
+	stream->lookStream.realStream = &stream->archiveStream.s;
+	LookToRead_Init(&stream->lookStream);
+
+	return stream;
+}
+
+void CSevenZipArchive::CloseStream(Stream* stream)
+{
+	File_Close(&stream->archiveStream.file);
+	delete stream;
+}
+
+CSevenZipArchive::Stream* CSevenZipArchive::AcquireStream()
+{
+	{
+		boost::mutex::scoped_lock lck(streamLock);
+
+		if (!freeStreams.empty()) {
+			Stream* stream = freeStreams.back();
+			freeStreams.pop_back();
+			return stream;
+		}
+	}
+
+	// all streams are busy, open another one for this thread
+	WRes wres = 0;
+	Stream* stream = OpenStream(wres);
+	if (stream == NULL) {
+		LogError("Error opening another stream on " + GetArchiveName()
+				+ " (" + IntToString(wres) + ")");
+	}
+	return stream;
+}
+
+void CSevenZipArchive::ReleaseStream(Stream* stream)
+{
+	boost::mutex::scoped_lock lck(streamLock);
+	freeStreams.push_back(stream);
+}
+
+
+boost::shared_ptr<CSevenZipArchive::SolidBlock> CSevenZipArchive::GetSolidBlock(UInt32 folderIndex)
+{
+	boost::shared_ptr<SolidBlock> block;
+	{
+		boost::mutex::scoped_lock lck(blockLock);
+
+		block = blocks[folderIndex].lock();
+		if (!block) {
+			block.reset(new SolidBlock(allocImp));
+			blocks[folderIndex] = block;
+		}
+		lastBlock = block;
+	}
+
+	// different blocks are decoded concurrently,
+	// readers of the same block wait for the first one
+	boost::mutex::scoped_lock lck(block->decodeLock);
+
+	if (!block->decoded) {
+		DecodeSolidBlock(folderIndex, *block);
+		block->decoded = true;
+	}
+
+	if (block->result != SZ_OK) {
+		return boost::shared_ptr<SolidBlock>();
+	}
+
+	return block;
+}
+
+void CSevenZipArchive::DecodeSolidBlock(UInt32 folderIndex, SolidBlock& block)
+{
+	// same as SzAr_Extract, but with a stream of our own
+	CSzFolder* folder = db.db.Folders + folderIndex;
+	const UInt64 unpackSizeSpec = SzFolder_GetUnpackSize(folder);
+	const size_t unpackSize = (size_t)unpackSizeSpec;
+	const UInt64 startOffset = SzArEx_GetFolderStreamPos(&db, folderIndex, 0);
+
+	if (unpackSize != unpackSizeSpec) {
+		block.result = SZ_ERROR_MEM;
+		return;
+	}
+
+	if (unpackSize != 0) {
+		block.data = (Byte*)IAlloc_Alloc(&allocImp, unpackSize);
+		if (block.data == NULL) {
+			block.result = SZ_ERROR_MEM;
+			return;
+		}
+	}
+	block.size = unpackSize;
+
+	Stream* stream = AcquireStream();
+	if (stream == NULL) {
+		block.result = SZ_ERROR_FAIL;
+		return;
+	}
+
+	block.result = LookInStream_SeekTo(&stream->lookStream.s, startOffset);
+	if (block.result == SZ_OK) {
+		block.result = SzDecode(db.db.PackSizes + db.FolderStartPackStreamIndex[folderIndex], folder,
+				&stream->lookStream.s, startOffset,
+				block.data, unpackSize, &allocTempImp);
+	}
+
+	ReleaseStream(stream);
+
+	if ((block.result == SZ_OK) && folder->UnpackCRCDefined) {
+		if (CrcCalc(block.data, unpackSize) != folder->UnpackCRC) {
+			block.result = SZ_ERROR_CRC;
+		}
+	}
+}
+
+
+bool CSevenZipArchive::GetFileBlock(unsigned int fid, boost::shared_ptr<SolidBlock>& block)
 {
-	boost::mutex::scoped_lock lck(archiveLock);
 	assert(IsFileId(fid));
-	
-	// Get 7zip to decompress it
-	size_t offset;
-	size_t outSizeProcessed;
-	SRes res;
 
-	res = SzAr_Extract(&db, &lookStream.s, fileData[fid].fp, &blockIndex, &outBuffer, &outBufferSize, &offset, &outSizeProcessed, &allocImp, &allocTempImp);
-	if (res == SZ_OK) {
-		buffer.resize(outSizeProcessed);
-		memcpy(&buffer[0], (char*)outBuffer+offset, outSizeProcessed);
+	const FileData& fd = fileData[fid];
+	const UInt32 folderIndex = db.FileIndexToFolderIndexMap[fd.fp];
+
+	if (folderIndex == ((UInt32)-1)) {
+		// empty file
+		block.reset();
 		return true;
-	} else {
+	}
+
+	block = GetSolidBlock(folderIndex);
+	if (!block) {
 		return false;
 	}
+
+	if ((fd.blockOffset + fd.size) > block->size) {
+		return false;
+	}
+
+	const CSzFileItem* fileItem = db.db.Files + fd.fp;
+	if (fileItem->FileCRCDefined && (CrcCalc(block->data + fd.blockOffset, fd.size) != fileItem->FileCRC)) {
+		return false;
+	}
+
+	return true;
+}
+
+bool CSevenZipArchive::GetFile(unsigned int fid, std::vector<boost::uint8_t>& buffer)
+{
+	boost::shared_ptr<SolidBlock> block;
+	if (!GetFileBlock(fid, block)) {
+		return false;
+	}
+
+	if (!block) {
+		buffer.clear();
+		return true;
+	}
+
+	const FileData& fd = fileData[fid];
+	buffer.assign(block->data + fd.blockOffset, block->data + fd.blockOffset + fd.size);
+	return true;
+}
+
+bool CSevenZipArchive::GetFileView(unsigned int fid, CFileView& view)
+{
+	boost::shared_ptr<SolidBlock> block;
+	if (!GetFileBlock(fid, block)) {
+		return false;
+	}
+
+	if (!block) {
+		view = CFileView();
+		return true;
+	}
+
+	const FileData& fd = fileData[fid];
+
+	if ((block->size - fd.size) > MAX_VIEW_PINNED_OVERSIZE) {
+		// do not keep a large block alive for a small file
+		std::vector<boost::uint8_t> buffer(block->data + fd.blockOffset, block->data + fd.blockOffset + fd.size);
+		view = CFileView(buffer);
+		return true;
+	}
+
+	view = CFileView(block, block->data + fd.blockOffset, fd.size);
+	return true;
 }
 
 void CSevenZipArchive::FileInfo(unsigned int fid, std::string& name, int& size) const
@@ -182,6 +361,7 @@ void CSevenZipArchive::FileInfo(unsigned int fid, std::string& name, int& size)
 
 const size_t CSevenZipArchive::COST_LIMIT_UNPACK_OVERSIZE = 32 * 1024;
 const size_t CSevenZipArchive::COST_LIMIT_DISC_READ       = 32 * 1024;
+const size_t CSevenZipArchive::MAX_VIEW_PINNED_OVERSIZE   = 64 * 1024;
 
 bool CSevenZipArchive::HasLowReadingCost(unsigned int fid) const
 {
@@ -3,6 +3,9 @@
 #ifndef _7ZIP_ARCHIVE_H
 #define _7ZIP_ARCHIVE_H
 
+#include <map>
+#include <boost/shared_ptr.hpp>
+#include <boost/weak_ptr.hpp>
 #include <boost/thread/mutex.hpp>
 extern "C" {
 #include "lib/7z/7zFile.h"
@@ -27,6 +30,13 @@ private:
 
 /**
  * An LZMA/7zip compressed, single-file archive.
+ *
+ * Files may be read by multiple threads at once: each decoding thread uses
+ * its own stream on the archive file (see AcquireStream), and solid blocks
+ * are decoded only once while in use, then shared by all files they contain
+ * (see GetSolidBlock). Views of files that fill most of their block point
+ * directly into it and keep it alive, all others get a copy of their data
+ * (see MAX_VIEW_PINNED_OVERSIZE).
  */
 class CSevenZipArchive : public IArchive
 {
@@ -38,15 +48,68 @@ public:
 	
 	virtual unsigned int NumFiles() const;
 	virtual bool GetFile(unsigned int fid, std::vector<boost::uint8_t>& buffer);
+	virtual bool GetFileView(unsigned int fid, CFileView& view);
 	virtual void FileInfo(unsigned int fid, std::string& name, int& size) const;
 	virtual bool HasLowReadingCost(unsigned int fid) const;
 	virtual unsigned GetCrc32(unsigned int fid);
 
 private:
-	boost::mutex archiveLock;
-	UInt32 blockIndex;
-	Byte* outBuffer;
-	size_t outBufferSize;
+	/// an opened stream on the archive file, used by one thread at a time
+	struct Stream
+	{
+		CFileInStream archiveStream;
+		CLookToRead lookStream;
+	};
+
+	/// a decoded solid block ("folder" in 7zip terms)
+	struct SolidBlock
+	{
+		SolidBlock(const ISzAlloc& alloc)
+			: data(NULL)
+			, size(0)
+			, decoded(false)
+			, result(SZ_OK)
+			, alloc(alloc)
+			{}
+		~SolidBlock() { IAlloc_Free(&alloc, data); }
+
+		boost::mutex decodeLock; ///< held while decoding
+		Byte* data;
+		size_t size;
+		bool decoded;
+		SRes result;
+		ISzAlloc alloc;
+	};
+
+	/// @return NULL on error, the error code is stored in wres
+	Stream* OpenStream(WRes& wres) const;
+	static void CloseStream(Stream* stream);
+	/// returns a stream not in use by any other thread, or NULL on error
+	Stream* AcquireStream();
+	void ReleaseStream(Stream* stream);
+
+	/**
+	 * Returns the decoded solid block, decoding it if no other thread holds
+	 * on to it already.
+	 * @return NULL if decoding failed
+	 */
+	boost::shared_ptr<SolidBlock> GetSolidBlock(UInt32 folderIndex);
+	void DecodeSolidBlock(UInt32 folderIndex, SolidBlock& block);
+	/**
+	 * Gets the decoded block of a file, and checks the file's CRC.
+	 * @param block set to NULL for empty files
+	 * @return false if decoding failed or the CRC does not match
+	 */
+	bool GetFileBlock(unsigned int fid, boost::shared_ptr<SolidBlock>& block);
+
+	boost::mutex streamLock;
+	std::vector<Stream*> freeStreams;
+
+	boost::mutex blockLock;
+	/// all blocks currently in use
+	std::map<UInt32, boost::weak_ptr<SolidBlock> > blocks;
+	/// kept alive, so sequential reads from one block decode it only once
+	boost::shared_ptr<SolidBlock> lastBlock;
 
 	/**
 	 * How much more unpacked data may be allowed in a solid block,
@@ -55,6 +118,12 @@ private:
 	 * @see FileData#unpackedSize
 	 */
 	static const size_t COST_LIMIT_UNPACK_OVERSIZE;
+	/**
+	 * How much more data of its solid block a file view may keep alive,
+	 * besides the file itself; views of smaller files in larger blocks
+	 * copy the file instead.
+	 */
+	static const size_t MAX_VIEW_PINNED_OVERSIZE;
 	/**
 	 * Maximum allowed packed data allowed in a solid block
 	 * that contains a meta-file.
@@ -67,6 +136,8 @@ private:
 	struct FileData
 	{
 		int fp;
+		/// offset of the file inside its decoded solid block
+		size_t blockOffset;
 		/**
 		 * Real/unpacked size of the file in bytes.
 		 * @see #unpackedSize
@@ -95,9 +166,7 @@ private:
 	};
 	std::vector<FileData> fileData;
 
-	CFileInStream archiveStream;
-	CSzArEx db;
-	CLookToRead lookStream;
+	CSzArEx db; ///< read-only once opened
 	ISzAlloc allocImp;
 	ISzAlloc allocTempImp;
 
@@ -6,8 +6,8 @@
 #include <algorithm>
 #include <stdexcept>
 
+#include "MemoryMappedFile.h"
 #include "System/Util.h"
-#include "System/Log/ILog.h"
 
 
 CZipArchiveFactory::CZipArchiveFactory()
@@ -23,16 +23,11 @@ IArchive* CZipArchiveFactory::DoCreateArchive(const std::string& filePath) const
 
 CZipArchive::CZipArchive(const std::string& archiveName)
 	: CBufferedArchive(archiveName)
+	, mapFailed(false)
 {
-#ifdef USEWIN32IOAPI
-	zlib_filefunc_def ffunc;
-	fill_win32_filefunc(&ffunc);
-	zip = unzOpen2(archiveName.c_str(),&ffunc);
-#else
-	zip = unzOpen(archiveName.c_str());
-#endif
+	zip = OpenZip(archiveName);
 	if (!zip) {
-		LOG_L(L_ERROR, "Error opening %s", archiveName.c_str());
+		LogError("Error opening " + archiveName);
 		return;
 	}
 
@@ -58,18 +53,61 @@ CZipArchive::CZipArchive(const std::string& archiveName)
 		fd.size = info.uncompressed_size;
 		fd.origName = fName;
 		fd.crc = info.crc;
+		fd.stored = (info.compression_method == 0) && ((info.flag & 1) == 0) && (info.compressed_size == info.uncompressed_size);
+		fd.dataOffset = 0;
 		fileData.push_back(fd);
 		lcNameIndex[fLowerName] = fileData.size() - 1;
 	}
+
+	freeZips.push_back(zip);
 }
 
 CZipArchive::~CZipArchive()
 {
-	if (zip) {
-		unzClose(zip);
+	for (std::vector<unzFile>::iterator zi = freeZips.begin(); zi != freeZips.end(); ++zi) {
+		unzClose(*zi);
 	}
 }
 
+unzFile CZipArchive::OpenZip(const std::string& archiveName)
+{
+#ifdef USEWIN32IOAPI
+	zlib_filefunc_def ffunc;
+	fill_win32_filefunc(&ffunc);
+	return unzOpen2(archiveName.c_str(),&ffunc);
+#else
+	return unzOpen(archiveName.c_str());
+#endif
+}
+
+unzFile CZipArchive::AcquireZip()
+{
+	{
+		boost::mutex::scoped_lock lck(zipLock);
+
+		if (!freeZips.empty()) {
+			unzFile handle = freeZips.back();
+			freeZips.pop_back();
+			return handle;
+		}
+	}
+
+	// all handles are busy, open another one for this thread
+	// (this parses the central directory again, but only happens
+	// once per concurrently reading thread)
+	unzFile handle = OpenZip(GetArchiveName());
+	if (!handle) {
+		LogError("Error opening another handle on " + GetArchiveName());
+	}
+	return handle;
+}
+
+void CZipArchive::ReleaseZip(unzFile handle)
+{
+	boost::mutex::scoped_lock lck(zipLock);
+	freeZips.push_back(handle);
+}
+
 bool CZipArchive::IsOpen()
 {
 	return (zip != NULL);
@@ -97,7 +135,7 @@ unsigned int CZipArchive::GetCrc32(unsigned int fid)
 
 // To simplify things, files are always read completely into memory from
 // the zip-file, since zlib does not provide any way of reading more
-// than one file at a time
+// than one file at a time per handle
 bool CZipArchive::GetFileImpl(unsigned int fid, std::vector<boost::uint8_t>& buffer)
 {
 	// Prevent opening files on missing/invalid archives
@@ -106,23 +144,36 @@ bool CZipArchive::GetFileImpl(unsigned int fid, std::vector<boost::uint8_t>& buf
 	}
 	assert(IsFileId(fid));
 
-	unzGoToFilePos(zip, &fileData[fid].fp);
+	unzFile handle = AcquireZip();
+	if (!handle) {
+		return false;
+	}
+
+	const bool ret = ReadFile(handle, fid, buffer);
+
+	ReleaseZip(handle);
+	return ret;
+}
+
+bool CZipArchive::ReadFile(unzFile handle, unsigned int fid, std::vector<boost::uint8_t>& buffer)
+{
+	unzGoToFilePos(handle, &fileData[fid].fp);
 
 	unz_file_info fi;
-	unzGetCurrentFileInfo(zip, &fi, NULL, 0, NULL, 0, NULL, 0);
+	unzGetCurrentFileInfo(handle, &fi, NULL, 0, NULL, 0, NULL, 0);
 
-	if (unzOpenCurrentFile(zip) != UNZ_OK) {
+	if (unzOpenCurrentFile(handle) != UNZ_OK) {
 		return false;
 	}
 
 	buffer.resize(fi.uncompressed_size);
 
 	bool ret = true;
-	if (!buffer.empty() && unzReadCurrentFile(zip, &buffer[0], fi.uncompressed_size) != fi.uncompressed_size) {
+	if (!buffer.empty() && unzReadCurrentFile(handle, &buffer[0], fi.uncompressed_size) != fi.uncompressed_size) {
 		ret = false;
 	}
 
-	if (unzCloseCurrentFile(zip) == UNZ_CRCERROR) {
+	if (unzCloseCurrentFile(handle) == UNZ_CRCERROR) {
 		ret = false;
 	}
 
@@ -132,3 +183,69 @@ bool CZipArchive::GetFileImpl(unsigned int fid, std::vector<boost::uint8_t>& buf
 
 	return ret;
 }
+
+
+/// reads a little-endian integer from a zip header
+static size_t ReadZipInt(const boost::uint8_t* p, int bytes)
+{
+	size_t ret = 0;
+	for (int i = bytes - 1; i >= 0; --i) {
+		ret = (ret << 8) | p[i];
+	}
+	return ret;
+}
+
+bool CZipArchive::LocateStoredData(FileData& fd) const
+{
+	// minizip does not expose where the data of a file starts,
+	// so follow the central directory entry to the local header.
+	// Archives with data prepended (self-extracting) fail the signature
+	// checks and are read the regular way.
+	const boost::uint8_t* zipData = mappedZip->GetData();
+	const size_t zipSize = mappedZip->GetSize();
+
+	const size_t dirPos = fd.fp.pos_in_zip_directory;
+	if (((dirPos + 46) > zipSize) || (ReadZipInt(zipData + dirPos, 4) != 0x02014b50)) {
+		return false;
+	}
+
+	const size_t headerPos = ReadZipInt(zipData + dirPos + 42, 4);
+	if (((headerPos + 30) > zipSize) || (ReadZipInt(zipData + headerPos, 4) != 0x04034b50)) {
+		return false;
+	}
+
+	const size_t dataPos = headerPos + 30 + ReadZipInt(zipData + headerPos + 26, 2) + ReadZipInt(zipData + headerPos + 28, 2);
+	if ((dataPos + fd.size) > zipSize) {
+		return false;
+	}
+
+	fd.dataOffset = dataPos;
+	return true;
+}
+
+bool CZipArchive::GetFileViewImpl(unsigned int fid, CFileView& view)
+{
+	if (!zip || !fileData[fid].stored || mapFailed) {
+		return false;
+	}
+
+	if (!mappedZip) {
+		mappedZip.reset(new CMemoryMappedFile(GetArchiveName()));
+
+		if (!mappedZip->IsOpen()) {
+			mappedZip.reset();
+			mapFailed = true;
+			return false;
+		}
+	}
+
+	FileData& fd = fileData[fid];
+	if ((fd.dataOffset == 0) && !LocateStoredData(fd)) {
+		fd.stored = false;
+		return false;
+	}
+
+	// NOTE: unlike GetFileImpl, this does not verify the CRC
+	view = CFileView(mappedZip, mappedZip->GetData() + fd.dataOffset, fd.size);
+	return true;
+}
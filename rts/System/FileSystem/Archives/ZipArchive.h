@@ -17,6 +17,10 @@
 
 #include <string>
 #include <vector>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+
+class CMemoryMappedFile;
 
 
 /**
@@ -33,6 +37,10 @@ private:
 
 /**
  * A zip compressed, single-file archive.
+ * Files stored without compression are memory-mapped instead of being read
+ * (and cached) by GetFileView.
+ * Compressed files are inflated concurrently, using one zip handle per
+ * reading thread (see AcquireZip).
  */
 class CZipArchive : public CBufferedArchive
 {
@@ -47,17 +55,36 @@ public:
 	virtual unsigned int GetCrc32(unsigned int fid);
 
 protected:
-	unzFile zip;
+	unzFile zip; ///< used to list the contents, part of the handle pool afterwards
+
+	/// returns a handle not in use by any other thread, or NULL on error
+	unzFile AcquireZip();
+	void ReleaseZip(unzFile handle);
+
+	boost::mutex zipLock;
+	std::vector<unzFile> freeZips;
 
 	struct FileData {
 		unz_file_pos fp;
 		int size;
 		std::string origName;
 		unsigned int crc;
+		bool stored;       ///< not compressed nor encrypted
+		size_t dataOffset; ///< of a stored file in the zip, 0 if not located yet
 	};
 	std::vector<FileData> fileData;
-	
+
+	/// mapping of the whole zip, created on the first read of a stored file
+	boost::shared_ptr<CMemoryMappedFile> mappedZip;
+	bool mapFailed;
+
 	virtual bool GetFileImpl(unsigned int fid, std::vector<boost::uint8_t>& buffer);
+	virtual bool GetFileViewImpl(unsigned int fid, CFileView& view);
+
+private:
+	static unzFile OpenZip(const std::string& archiveName);
+	bool ReadFile(unzFile handle, unsigned int fid, std::vector<boost::uint8_t>& buffer);
+	bool LocateStoredData(FileData& fd) const;
 };
 
 #endif // _ZIP_ARCHIVE_H
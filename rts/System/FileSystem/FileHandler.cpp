@@ -77,12 +77,8 @@ bool CFileHandler::TryReadFromModFS(const string& fileName)
 	}
 
 	const string file = StringToLower(fileName);
-	if (vfsHandler->LoadFile(file, fileBuffer)) {
-		//! did we allocated more mem than needed
-		//! (e.g. because of incorrect usage of std::vector)?
-		assert(fileBuffer.size() == fileBuffer.capacity()); 
-
-		fileSize = fileBuffer.size();
+	if (vfsHandler->LoadFile(file, fileView)) {
+		fileSize = fileView.GetSize();
 		return true;
 	}
 	else
@@ -151,13 +147,13 @@ int CFileHandler::Read(void* buf, int length)
 		ifs->read((char*)buf, length);
 		return ifs->gcount ();
 	}
-	else if (!fileBuffer.empty()) {
+	else if (!fileView.IsEmpty()) {
 		if ((length + filePos) > fileSize) {
 			length = fileSize - filePos;
 		}
 		if (length > 0) {
-			assert(fileBuffer.size() >= (filePos + length));
-			memcpy(buf, &fileBuffer[filePos], length);
+			assert(fileView.GetSize() >= (filePos + length));
+			memcpy(buf, fileView.GetData() + filePos, length);
 			filePos += length;
 		}
 		return length;
@@ -178,7 +174,7 @@ void CFileHandler::Seek(int length, std::ios_base::seekdir where)
 		ifs->clear();
 		ifs->seekg(length, where);
 	}
-	else if (!fileBuffer.empty())
+	else if (!fileView.IsEmpty())
 	{
 		if (where == std::ios_base::beg)
 		{
@@ -202,7 +198,7 @@ bool CFileHandler::Eof() const
 	if (ifs) {
 		return ifs->eof();
 	}
-	if (!fileBuffer.empty()) {
+	if (!fileView.IsEmpty()) {
 		return (filePos >= fileSize);
 	}
 	return true;
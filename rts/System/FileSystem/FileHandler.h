@@ -10,6 +10,7 @@
 #include <boost/cstdint.hpp>
 
 #include "VFSModes.h"
+#include "Archives/FileView.h"
 
 /**
  * This is for direct VFS file content access.
@@ -70,7 +71,8 @@ private:
 
 	std::string fileName;
 	std::ifstream* ifs;
-	std::vector<boost::uint8_t> fileBuffer;
+	/// contents of a VFS file, possibly memory-mapped
+	CFileView fileView;
 	int filePos;
 	int fileSize;
 };
@@ -4,7 +4,6 @@
 #include "VFSHandler.h"
 
 #include <algorithm>
-#include <set>
 #include <cstring>
 
 #include "ArchiveLoader.h"
@@ -57,10 +56,12 @@ bool CVFSHandler::AddArchive(const std::string& archiveName, bool override, cons
 		std::string name;
 		int size;
 		ar->FileInfo(fid, name, size);
-		StringToLowerInPlace(name);
+		name = GetNormalizedPath(name);
+
+		const bool exists = (files.find(name) != files.end());
 
 		if (!override) {
-			if (files.find(name) != files.end()) {
+			if (exists) {
 				LOG_L(L_DEBUG, "%s (skipping, exists)", name.c_str());
 				continue;
 			} else {
@@ -72,8 +73,13 @@ bool CVFSHandler::AddArchive(const std::string& archiveName, bool override, cons
 
 		FileData d;
 		d.ar = ar;
+		d.fid = fid;
 		d.size = size;
 		files[name] = d;
+
+		if (!exists) {
+			AddToDirIndex(name);
+		}
 	}
 	return true;
 }
@@ -96,23 +102,33 @@ bool CVFSHandler::RemoveArchive(const std::string& archiveName)
 {
 	LOG_L(L_DEBUG, "RemoveArchive(archiveName = \"%s\")", archiveName.c_str());
 
-	IArchive* ar = archives[archiveName];
-	if (ar == NULL) {
+	const std::map<std::string, IArchive*>::iterator ai = archives.find(archiveName);
+	if (ai == archives.end() || ai->second == NULL) {
 		// archive is not loaded
 		return true;
 	}
-	
+	IArchive* ar = ai->second;
+
 	// remove the files loaded from the archive-to-remove
-	for (std::map<std::string, FileData>::iterator f = files.begin(); f != files.end();) {
-		if (f->second.ar == ar) {
-			LOG_L(L_DEBUG, "%s (removing)", f->first.c_str());
-			f = set_erase(files, f);
-		} else {
-			 ++f;
+	// (only its own entries need to be looked at, not the whole VFS)
+	for (unsigned fid = 0; fid != ar->NumFiles(); ++fid) {
+		std::string name;
+		int size;
+		ar->FileInfo(fid, name, size);
+		name = GetNormalizedPath(name);
+
+		const FileTable::iterator f = files.find(name);
+		if ((f == files.end()) || (f->second.ar != ar)) {
+			// never added, or overridden by a different archive
+			continue;
 		}
+
+		LOG_L(L_DEBUG, "%s (removing)", name.c_str());
+		files.erase(f);
+		RemoveFromDirIndex(name);
 	}
 	delete ar;
-	archives.erase(archiveName);
+	archives.erase(ai);
 
 	return true;
 }
@@ -133,11 +149,23 @@ std::string CVFSHandler::GetNormalizedPath(const std::string& rawPath)
 	return path;
 }
 
+std::string CVFSHandler::GetNormalizedDirPath(const std::string& rawDir)
+{
+	std::string dir = GetNormalizedPath(rawDir);
+
+	// Non-empty directories should have a trailing slash
+	if (!dir.empty() && (dir[dir.length() - 1] != '/')) {
+		dir += '/';
+	}
+
+	return dir;
+}
+
 const CVFSHandler::FileData* CVFSHandler::GetFileData(const std::string& normalizedFilePath)
 {
 	const FileData* fileData = NULL;
 
-	const std::map<std::string, FileData>::const_iterator fi = files.find(normalizedFilePath);
+	const FileTable::const_iterator fi = files.find(normalizedFilePath);
 	if (fi != files.end()) {
 		fileData = &(fi->second);
 	}
@@ -145,6 +173,72 @@ const CVFSHandler::FileData* CVFSHandler::GetFileData(const std::string& normali
 	return fileData;
 }
 
+
+/// returns the parent of dir ("a/b/" -> "a/", "a/" -> "")
+static std::string GetParentDir(const std::string& dir)
+{
+	if (dir.length() < 2) {
+		return "";
+	}
+
+	const std::string::size_type slash = dir.rfind('/', dir.length() - 2);
+	if (slash == std::string::npos) {
+		return "";
+	}
+
+	return dir.substr(0, slash + 1);
+}
+
+void CVFSHandler::AddToDirIndex(const std::string& normalizedFilePath)
+{
+	const std::string::size_type slash = normalizedFilePath.rfind('/');
+	std::string dir = (slash == std::string::npos)? "": normalizedFilePath.substr(0, slash + 1);
+
+	dirs[dir].files.insert(normalizedFilePath.substr(dir.length()));
+
+	// register the directory with its parents; once one of them already
+	// knows its sub-directory, all further ones are registered too
+	while (!dir.empty()) {
+		const std::string parent = GetParentDir(dir);
+
+		if (!dirs[parent].dirs.insert(dir.substr(parent.length())).second) {
+			break;
+		}
+		dir = parent;
+	}
+}
+
+void CVFSHandler::RemoveFromDirIndex(const std::string& normalizedFilePath)
+{
+	const std::string::size_type slash = normalizedFilePath.rfind('/');
+	std::string dir = (slash == std::string::npos)? "": normalizedFilePath.substr(0, slash + 1);
+
+	DirTable::iterator di = dirs.find(dir);
+	if (di == dirs.end()) {
+		return;
+	}
+	di->second.files.erase(normalizedFilePath.substr(dir.length()));
+
+	// drop directories that became empty, so they are not listed anymore
+	while (!dir.empty()) {
+		di = dirs.find(dir);
+
+		if ((di == dirs.end()) || !di->second.files.empty() || !di->second.dirs.empty()) {
+			break;
+		}
+		dirs.erase(di);
+
+		const std::string parent = GetParentDir(dir);
+		const DirTable::iterator pi = dirs.find(parent);
+
+		if (pi != dirs.end()) {
+			pi->second.dirs.erase(dir.substr(parent.length()));
+		}
+		dir = parent;
+	}
+}
+
+
 bool CVFSHandler::LoadFile(const std::string& filePath, std::vector<boost::uint8_t>& buffer)
 {
 	LOG_L(L_DEBUG, "LoadFile(filePath = \"%s\", )", filePath.c_str());
@@ -157,7 +251,7 @@ bool CVFSHandler::LoadFile(const std::string& filePath, std::vector<boost::uint8
 		return false;
 	}
 
-	if (!fileData->ar->GetFile(normalizedPath, buffer))
+	if (!fileData->ar->GetFile(fileData->fid, buffer))
 	{
 		LOG_L(L_DEBUG, "LoadFile: File '%s' does not exist in archive.", filePath.c_str());
 		return false;
@@ -165,68 +259,44 @@ bool CVFSHandler::LoadFile(const std::string& filePath, std::vector<boost::uint8
 	return true;
 }
 
-bool CVFSHandler::FileExists(const std::string& filePath)
+bool CVFSHandler::LoadFile(const std::string& filePath, CFileView& view)
 {
-	LOG_L(L_DEBUG, "FileExists(filePath = \"%s\", )", filePath.c_str());
+	LOG_L(L_DEBUG, "LoadFile(filePath = \"%s\", )", filePath.c_str());
 
 	const std::string normalizedPath = GetNormalizedPath(filePath);
 
 	const FileData* fileData = GetFileData(normalizedPath);
 	if (fileData == NULL) {
-		// the file does not exist in the VFS
+		LOG_L(L_DEBUG, "LoadFile: File '%s' does not exist in VFS.", filePath.c_str());
 		return false;
 	}
 
-	if (!fileData->ar->FileExists(normalizedPath)) {
-		// the file does not exist in the archive
+	if (!fileData->ar->GetFileView(fileData->fid, view))
+	{
+		LOG_L(L_DEBUG, "LoadFile: File '%s' does not exist in archive.", filePath.c_str());
 		return false;
 	}
-
 	return true;
 }
 
+bool CVFSHandler::FileExists(const std::string& filePath)
+{
+	LOG_L(L_DEBUG, "FileExists(filePath = \"%s\", )", filePath.c_str());
+
+	// every file in the table was listed by its archive, so there is
+	// no need to ask the archive again
+	return (GetFileData(GetNormalizedPath(filePath)) != NULL);
+}
+
 std::vector<std::string> CVFSHandler::GetFilesInDir(const std::string& rawDir)
 {
 	LOG_L(L_DEBUG, "GetFilesInDir(rawDir = \"%s\")", rawDir.c_str());
 
 	std::vector<std::string> ret;
-	std::string dir = GetNormalizedPath(rawDir);
-
-	std::map<std::string, FileData>::const_iterator filesStart = files.begin();
-	std::map<std::string, FileData>::const_iterator filesEnd   = files.end();
-
-	// Non-empty directories to look in should have a trailing backslash
-	if (!dir.empty()) {
-		std::string::size_type dirLast = (dir.length() - 1);
-		if (dir[dirLast] != '/') {
-			dir += "/";
-			dirLast++;
-		}
-		// limit the iterator range
-		std::string dirEnd = dir;
-		dirEnd[dirLast] = dirEnd[dirLast] + 1;
-		filesStart = files.lower_bound(dir);
-		filesEnd   = files.upper_bound(dirEnd);
-	}
 
-	while (filesStart != filesEnd) {
-		const std::string path = FileSystem::GetDirectory(filesStart->first);
-
-		// Check if this file starts with the dir path
-		if (path.compare(0, dir.length(), dir) == 0) {
-
-			// Strip pathname
-			const std::string name = filesStart->first.substr(dir.length());
-
-			// Do not return files in subfolders
-			if ((name.find('/') == std::string::npos)
-					&& (name.find('\\') == std::string::npos))
-			{
-				ret.push_back(name);
-				LOG_L(L_DEBUG, "%s", name.c_str());
-			}
-		}
-		++filesStart;
+	const DirTable::const_iterator di = dirs.find(GetNormalizedDirPath(rawDir));
+	if (di != dirs.end()) {
+		ret.assign(di->second.files.begin(), di->second.files.end());
 	}
 
 	return ret;
@@ -238,44 +308,10 @@ std::vector<std::string> CVFSHandler::GetDirsInDir(const std::string& rawDir)
 	LOG_L(L_DEBUG, "GetDirsInDir(rawDir = \"%s\")", rawDir.c_str());
 
 	std::vector<std::string> ret;
-	std::string dir = GetNormalizedPath(rawDir);
-
-	std::map<std::string, FileData>::const_iterator filesStart = files.begin();
-	std::map<std::string, FileData>::const_iterator filesEnd   = files.end();
-
-	// Non-empty directories to look in should have a trailing backslash
-	if (!dir.empty()) {
-		std::string::size_type dirLast = (dir.length() - 1);
-		if (dir[dirLast] != '/') {
-			dir += "/";
-			++dirLast;
-		}
-		// limit the iterator range
-		std::string dirEnd = dir;
-		dirEnd[dirLast] = dirEnd[dirLast] + 1;
-		filesStart = files.lower_bound(dir);
-		filesEnd   = files.upper_bound(dirEnd);
-	}
-
-	std::set<std::string> dirs;
-
-	while (filesStart != filesEnd) {
-		const std::string path = FileSystem::GetDirectory(filesStart->first);
-		// Test to see if this file start with the dir path
-		if (path.compare(0, dir.length(), dir) == 0) {
-			// Strip pathname
-			const std::string name = filesStart->first.substr(dir.length());
-			const std::string::size_type slash = name.find_first_of("/\\");
-			if (slash != std::string::npos) {
-				dirs.insert(name.substr(0, slash + 1));
-			}
-		}
-		++filesStart;
-	}
 
-	for (std::set<std::string>::const_iterator it = dirs.begin(); it != dirs.end(); ++it) {
-		ret.push_back(*it);
-		LOG_L(L_DEBUG, "%s", it->c_str());
+	const DirTable::const_iterator di = dirs.find(GetNormalizedDirPath(rawDir));
+	if (di != dirs.end()) {
+		ret.assign(di->second.dirs.begin(), di->second.dirs.end());
 	}
 
 	return ret;
@@ -4,11 +4,14 @@
 #define _VFS_HANDLER_H
 
 #include <map>
+#include <set>
 #include <string>
 #include <vector>
 #include <boost/cstdint.hpp>
+#include <boost/unordered_map.hpp>
 
 class IArchive;
+class CFileView;
 
 /**
  * Main API for accessing the Virtual File System (VFS).
@@ -37,6 +40,12 @@ public:
 	 * @return true if the file exists in the VFS and was successfully read
 	 */
 	bool LoadFile(const std::string& filePath, std::vector<boost::uint8_t>& buffer);
+	/**
+	 * Reads the contents of a file from within the VFS, without copying it
+	 * where the archive allows it.
+	 * @see IArchive::GetFileView
+	 */
+	bool LoadFile(const std::string& filePath, CFileView& view);
 
 	/**
 	 * Returns all the files in the given (virtual) directory without the
@@ -76,14 +85,35 @@ public:
 protected:
 	struct FileData {
 		IArchive* ar;
+		unsigned int fid; ///< ID of the file in ar
 		int size;
 	};
-	std::map<std::string, FileData> files; 
+	typedef boost::unordered_map<std::string, FileData> FileTable;
+	/// all files in the VFS, by normalized path
+	FileTable files;
+
+	/// contents of a (virtual) directory, names are relative to it
+	struct DirData {
+		std::set<std::string> files;
+		std::set<std::string> dirs; ///< with trailing slash
+	};
+	typedef boost::unordered_map<std::string, DirData> DirTable;
+	/**
+	 * All directories that contain files, by normalized path with trailing
+	 * slash ("" for the root), so listings do not have to search the files.
+	 */
+	DirTable dirs;
+
 	std::map<std::string, IArchive*> archives;
 
 private:
 	std::string GetNormalizedPath(const std::string& rawPath);
+	/// like GetNormalizedPath, but appends a slash to non-empty paths
+	std::string GetNormalizedDirPath(const std::string& rawDir);
 	const FileData* GetFileData(const std::string& normalizedFilePath);
+
+	void AddToDirIndex(const std::string& normalizedFilePath);
+	void RemoveFromDirIndex(const std::string& normalizedFilePath);
 };
 
 extern CVFSHandler* vfsHandler;
@@ -0,0 +1,468 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "AsyncBackend.h"
+
+#include "Backend.h"
+#include "FramePrefixer.h"
+#include "Level.h" // for LOG_LEVEL_*
+#include "Section.h"
+#include "System/maindefines.h"
+
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/locks.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+
+#ifdef _MSC_VER
+	#include <windows.h>
+	#define va_copy(dst, src) ((dst) = (src))
+#endif
+
+
+extern "C" char* log_formatter_format(const char* section, int level, const char* fmt, va_list arguments);
+
+namespace {
+
+#ifdef _MSC_VER
+	inline unsigned int AtomicCompareAndSwap(volatile unsigned int* value, unsigned int expected, unsigned int desired) {
+		return InterlockedCompareExchange((volatile LONG*) value, (LONG) desired, (LONG) expected);
+	}
+	inline unsigned int AtomicFetchAndAdd(volatile unsigned int* value, unsigned int add) {
+		return InterlockedExchangeAdd((volatile LONG*) value, (LONG) add);
+	}
+	inline void MemoryFence() {
+		MemoryBarrier();
+	}
+#else // assuming GCC (the __sync_* functions are builtins)
+	inline unsigned int AtomicCompareAndSwap(volatile unsigned int* value, unsigned int expected, unsigned int desired) {
+		return __sync_val_compare_and_swap(value, expected, desired);
+	}
+	inline unsigned int AtomicFetchAndAdd(volatile unsigned int* value, unsigned int add) {
+		return __sync_fetch_and_add(value, add);
+	}
+	inline void MemoryFence() {
+		__sync_synchronize();
+	}
+#endif
+
+	static const size_t MIN_QUEUE_SIZE = 16;
+	static const size_t SECTION_SIZE = 64;
+	/// messages up to this length are copied into the slot itself
+	static const size_t TEXT_SIZE = 256;
+	/// number of counters the rate limit hashes the sections to
+	static const unsigned int RATE_BUCKETS = 64;
+	/// how long records of level ERROR and above wait for a free slot
+	static const int FULL_QUEUE_WAIT_MS = 100;
+	/// how long flushing waits for a busy queue (eg. when crashing)
+	static const int FLUSH_TIMEOUT_MS = 250;
+	/// maximal time the writer sleeps, even if not woken up
+	static const int WRITER_IDLE_MS = 10;
+
+	/**
+	 * One queued record.
+	 * The sequence number tells whether the slot is free to be written
+	 * (== position) or ready to be read (== position + 1), see
+	 * http://www.1024cores.net/home/lock-free-algorithms/queues/bounded-mpmc-queue
+	 */
+	struct Slot {
+		Slot(): sequence(0), level(0), frameNum(-1), longText(NULL) {
+			section[0] = '\0';
+			text[0] = '\0';
+		}
+
+		volatile unsigned int sequence;
+		int level;
+		int frameNum;
+		char* longText; ///< heap copy of messages that do not fit into text
+		char section[SECTION_SIZE];
+		char text[TEXT_SIZE];
+	};
+
+	struct RateBucket {
+		RateBucket(): second(0), count(0) {}
+
+		volatile unsigned int second;
+		volatile unsigned int count;
+	};
+
+	struct AsyncQueue {
+		AsyncQueue()
+			: mask(0)
+			, enqueuePos(0)
+			, dequeuePos(0)
+			, writerThread(NULL)
+			, running(false)
+			, writerSleeping(false)
+			, rateLimit(0)
+			, clockSecond(1)
+			, numDropped(0)
+			, numSuppressed(0)
+			, numDroppedReported(0)
+			, numSuppressedReported(0)
+		{}
+
+		std::vector<Slot> slots;
+		unsigned int mask;
+
+		/// next position to write to, shared by all producers
+		volatile unsigned int enqueuePos;
+		/// next position to read from, only touched with consumerMutex held
+		unsigned int dequeuePos;
+		boost::timed_mutex consumerMutex;
+
+		boost::thread* writerThread;
+		boost::mutex wakeMutex;
+		boost::condition_variable wakeCond;
+		volatile bool running;
+		volatile bool writerSleeping;
+
+		volatile int rateLimit;
+		/// coarse clock for the rate limit, advanced by the writer thread
+		volatile unsigned int clockSecond;
+		RateBucket rateBuckets[RATE_BUCKETS];
+
+		volatile unsigned int numDropped;
+		volatile unsigned int numSuppressed;
+		unsigned int numDroppedReported;
+		unsigned int numSuppressedReported;
+	};
+
+	inline AsyncQueue& log_async_getQueue() {
+		// never destroyed, log_async_stop has to be called before exiting
+		static AsyncQueue* queue = new AsyncQueue();
+		return *queue;
+	}
+
+
+	inline unsigned int log_async_hashSection(const char* section) {
+
+		// FNV-1a
+		unsigned int hash = 2166136261u;
+		for (; *section != '\0'; ++section) {
+			hash = (hash ^ (unsigned char) *section) * 16777619u;
+		}
+		return hash;
+	}
+
+	/**
+	 * @return false if the section exceeded its records for the current
+	 *   second (sections sharing a bucket share the limit)
+	 */
+	bool log_async_checkRateLimit(AsyncQueue& queue, const char* section, int level) {
+
+		const int rateLimit = queue.rateLimit;
+		if ((rateLimit <= 0) || (level >= LOG_LEVEL_WARNING)) {
+			return true;
+		}
+
+		RateBucket& bucket = queue.rateBuckets[log_async_hashSection(section) % RATE_BUCKETS];
+		const unsigned int now = queue.clockSecond;
+
+		if (bucket.second != now) {
+			// racy, but at worst a few records more get through
+			bucket.second = now;
+			bucket.count = 0;
+		}
+		if (AtomicFetchAndAdd(&bucket.count, 1) < (unsigned int) rateLimit) {
+			return true;
+		}
+
+		AtomicFetchAndAdd(&queue.numSuppressed, 1);
+		return false;
+	}
+
+	/// @return NULL if the queue is full
+	Slot* log_async_acquireSlot(AsyncQueue& queue, unsigned int* position) {
+
+		unsigned int pos = queue.enqueuePos;
+
+		while (true) {
+			Slot& slot = queue.slots[pos & queue.mask];
+			const unsigned int sequence = slot.sequence;
+			MemoryFence();
+			const int diff = (int) (sequence - pos);
+
+			if (diff == 0) {
+				// the slot is free, try to claim it
+				const unsigned int prevPos = AtomicCompareAndSwap(&queue.enqueuePos, pos, pos + 1);
+				if (prevPos == pos) {
+					*position = pos;
+					return &slot;
+				}
+				pos = prevPos;
+			} else if (diff < 0) {
+				// the reader did not free this slot yet
+				return NULL;
+			} else {
+				// another producer was faster
+				pos = queue.enqueuePos;
+			}
+		}
+	}
+
+	/// Passes the record on to the sinks, with the frame it was recorded in
+	void log_async_sinkRecord(const char* section, int level, int frameNum,
+			const char* fmt, ...)
+	{
+		va_list arguments;
+		va_start(arguments, fmt);
+		char* record = log_formatter_format(section, level, fmt, arguments);
+		va_end(arguments);
+
+		log_backend_sinkRecord(section, level, frameNum, record);
+
+		delete[] record;
+	}
+
+	/**
+	 * Sinks all ready records, in the order they were queued.
+	 * Must only be called with the consumerMutex held.
+	 */
+	void log_async_drainQueue(AsyncQueue& queue) {
+
+		if (queue.slots.empty()) {
+			return;
+		}
+
+		while (true) {
+			Slot& slot = queue.slots[queue.dequeuePos & queue.mask];
+			const unsigned int sequence = slot.sequence;
+			MemoryFence();
+
+			if (sequence != (queue.dequeuePos + 1)) {
+				// empty, or the next record is still being written
+				break;
+			}
+
+			const char* text = (slot.longText != NULL) ? slot.longText : slot.text;
+			log_async_sinkRecord(slot.section, slot.level, slot.frameNum, "%s", text);
+
+			delete[] slot.longText;
+			slot.longText = NULL;
+
+			// hand the slot back to the producers, one lap later
+			MemoryFence();
+			slot.sequence = queue.dequeuePos + queue.mask + 1;
+			queue.dequeuePos++;
+		}
+
+		const int frameNum = log_framePrefixer_getFrameNum();
+		const unsigned int numDropped = queue.numDropped;
+		const unsigned int numSuppressed = queue.numSuppressed;
+
+		if (numDropped != queue.numDroppedReported) {
+			log_async_sinkRecord(LOG_SECTION_DEFAULT, LOG_LEVEL_WARNING, frameNum,
+					"%u log records were dropped, the log queue was full",
+					numDropped - queue.numDroppedReported);
+			queue.numDroppedReported = numDropped;
+		}
+		if (numSuppressed != queue.numSuppressedReported) {
+			log_async_sinkRecord(LOG_SECTION_DEFAULT, LOG_LEVEL_WARNING, frameNum,
+					"%u log records were suppressed, sections exceeded %d records per second",
+					numSuppressed - queue.numSuppressedReported, (int) queue.rateLimit);
+			queue.numSuppressedReported = numSuppressed;
+		}
+	}
+
+	inline bool log_async_hasQueuedRecords(AsyncQueue& queue) {
+		MemoryFence();
+		return (queue.enqueuePos != queue.dequeuePos);
+	}
+
+	void log_async_writerMain() {
+
+		AsyncQueue& queue = log_async_getQueue();
+		const boost::system_time startTime = boost::get_system_time();
+
+		while (queue.running) {
+			queue.clockSecond = 1 + (boost::get_system_time() - startTime).total_seconds();
+
+			{
+				boost::timed_mutex::scoped_lock lock(queue.consumerMutex);
+				log_async_drainQueue(queue);
+			}
+
+			boost::mutex::scoped_lock lock(queue.wakeMutex);
+			queue.writerSleeping = true;
+			if (queue.running && !log_async_hasQueuedRecords(queue)) {
+				queue.wakeCond.timed_wait(lock, boost::posix_time::milliseconds(WRITER_IDLE_MS));
+			}
+			queue.writerSleeping = false;
+		}
+
+		boost::timed_mutex::scoped_lock lock(queue.consumerMutex);
+		log_async_drainQueue(queue);
+	}
+
+	/// Copies the record into the queue (ILog.h backend hook)
+	bool log_async_record(const char* section, int level, const char* fmt,
+			va_list arguments)
+	{
+		AsyncQueue& queue = log_async_getQueue();
+
+		if (section == NULL) {
+			section = LOG_SECTION_DEFAULT;
+		}
+		if (!log_async_checkRateLimit(queue, section, level)) {
+			return true;
+		}
+
+		unsigned int pos = 0;
+		Slot* slot = log_async_acquireSlot(queue, &pos);
+
+		if ((slot == NULL) && (level >= LOG_LEVEL_ERROR)
+				&& (queue.writerThread != NULL)
+				&& (boost::this_thread::get_id() != queue.writerThread->get_id()))
+		{
+			// errors are worth waiting a little for
+			for (int ms = 0; (slot == NULL) && (ms < FULL_QUEUE_WAIT_MS); ++ms) {
+				queue.wakeCond.notify_one();
+				boost::this_thread::sleep(boost::posix_time::milliseconds(1));
+				slot = log_async_acquireSlot(queue, &pos);
+			}
+		}
+		if (slot == NULL) {
+			AtomicFetchAndAdd(&queue.numDropped, 1);
+			return true;
+		}
+
+		slot->level = level;
+		slot->frameNum = log_framePrefixer_getFrameNum();
+
+		strncpy(slot->section, section, SECTION_SIZE - 1);
+		slot->section[SECTION_SIZE - 1] = '\0';
+
+		// the arguments can not outlive this call, so the message has to
+		// be formatted here; prefixing and sinking is left to the writer
+		va_list argumentsCopy;
+		va_copy(argumentsCopy, arguments);
+		const int textLength = VSNPRINTF(slot->text, TEXT_SIZE, fmt, argumentsCopy);
+		va_end(argumentsCopy);
+
+		if (textLength >= (int) TEXT_SIZE) {
+			slot->longText = new char[textLength + 1];
+			VSNPRINTF(slot->longText, textLength + 1, fmt, arguments);
+		}
+		slot->text[TEXT_SIZE - 1] = '\0';
+
+		// publish the record
+		MemoryFence();
+		slot->sequence = pos + 1;
+		MemoryFence();
+
+		if (queue.writerSleeping) {
+			queue.wakeCond.notify_one();
+		}
+
+		return true;
+	}
+
+	/// Keeps the writer from sinking records (ILog.h backend hook)
+	void log_async_lockSinks() {
+		log_async_getQueue().consumerMutex.lock();
+	}
+
+	void log_async_unlockSinks() {
+		log_async_getQueue().consumerMutex.unlock();
+	}
+}
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void log_async_start(size_t queueSize) {
+
+	AsyncQueue& queue = log_async_getQueue();
+
+	if (queue.writerThread != NULL) {
+		return;
+	}
+
+	size_t numSlots = MIN_QUEUE_SIZE;
+	while (numSlots < queueSize) {
+		numSlots <<= 1;
+	}
+
+	if (numSlots != queue.slots.size()) {
+		// nothing is queued while the writer is stopped
+		boost::timed_mutex::scoped_lock lock(queue.consumerMutex);
+
+		queue.slots.clear();
+		queue.slots.resize(numSlots);
+		queue.mask = numSlots - 1;
+		queue.enqueuePos = 0;
+		queue.dequeuePos = 0;
+
+		for (size_t s = 0; s < numSlots; ++s) {
+			queue.slots[s].sequence = s;
+		}
+	}
+
+	queue.running = true;
+	queue.writerThread = new boost::thread(&log_async_writerMain);
+
+	log_backend_setRecordHandler(&log_async_record, &log_async_flush,
+			&log_async_lockSinks, &log_async_unlockSinks);
+}
+
+void log_async_stop() {
+
+	AsyncQueue& queue = log_async_getQueue();
+
+	if (queue.writerThread == NULL) {
+		return;
+	}
+
+	{
+		boost::mutex::scoped_lock lock(queue.wakeMutex);
+		queue.running = false;
+		queue.wakeCond.notify_one();
+	}
+	queue.writerThread->join();
+	delete queue.writerThread;
+	queue.writerThread = NULL;
+
+	log_backend_setRecordHandler(NULL, NULL, NULL, NULL);
+
+	// records queued since the writer finished
+	boost::timed_mutex::scoped_lock lock(queue.consumerMutex);
+	log_async_drainQueue(queue);
+}
+
+bool log_async_isRunning() {
+	return (log_async_getQueue().writerThread != NULL);
+}
+
+void log_async_flush() {
+
+	AsyncQueue& queue = log_async_getQueue();
+
+	boost::unique_lock<boost::timed_mutex> lock(queue.consumerMutex, boost::defer_lock);
+	if (lock.timed_lock(boost::posix_time::milliseconds(FLUSH_TIMEOUT_MS))) {
+		log_async_drainQueue(queue);
+	}
+}
+
+void log_async_setRateLimit(int maxRecordsPerSecond) {
+	log_async_getQueue().rateLimit = maxRecordsPerSecond;
+}
+
+unsigned int log_async_getNumDropped() {
+	return log_async_getQueue().numDropped;
+}
+
+unsigned int log_async_getNumSuppressed() {
+	return log_async_getQueue().numSuppressed;
+}
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
@@ -0,0 +1,73 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef LOG_ASYNC_BACKEND_H
+#define LOG_ASYNC_BACKEND_H
+
+/**
+ * Asynchronous mode for the ILog.h logging backend.
+ * While running, the thread creating a log record only copies the message
+ * into a lock-free, bounded queue; formatting and sinking (and with that,
+ * writing and flushing log files) happen on a background writer thread.
+ *
+ * If the queue is full, records below LOG_LEVEL_ERROR are dropped
+ * immediately, more severe ones wait a short time for a free slot.
+ * Optionally, the number of records per second and section below
+ * LOG_LEVEL_WARNING can be limited.
+ * Dropped and suppressed records are counted, and reported in the log.
+ */
+
+#include <stdlib.h> // for size_t
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @name logging_backend_async
+ * ILog.h asynchronous backend control interface.
+ */
+///@{
+
+/**
+ * Starts the writer thread, and routes all further log records through it.
+ * @param queueSize maximum number of queued records, rounded up to a power
+ *   of two (at least 16)
+ */
+void log_async_start(size_t queueSize);
+
+/**
+ * Writes all queued records, stops the writer thread and switches back to
+ * synchronous logging.
+ * Has to be called before exiting, while the sinks are still alive; the
+ * writer thread is not stopped by static destructors.
+ */
+void log_async_stop();
+
+bool log_async_isRunning();
+
+/**
+ * Writes all currently queued records on the calling thread.
+ * Gives up if the queue is blocked by another thread for too long,
+ * as this is also used when crashing.
+ */
+void log_async_flush();
+
+/**
+ * Limits the records per second of a single section, below LOG_LEVEL_WARNING.
+ * @param maxRecordsPerSecond 0 (the default) disables the limit
+ */
+void log_async_setRateLimit(int maxRecordsPerSecond);
+
+/// Number of records dropped so far because the queue was full
+unsigned int log_async_getNumDropped();
+
+/// Number of records suppressed so far by the rate limit
+unsigned int log_async_getNumSuppressed();
+
+///@}
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // LOG_ASYNC_BACKEND_H
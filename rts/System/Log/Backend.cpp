@@ -12,6 +12,7 @@ extern "C" {
 #endif
 
 extern char* log_formatter_format(const char* section, int level, const char* fmt, va_list arguments);
+extern int log_framePrefixer_getFrameNum();
 
 namespace {
 	std::vector<log_sink_ptr>& log_formatter_getSinks() {
@@ -23,15 +24,25 @@ namespace {
 		static std::vector<log_cleanup_ptr> cleanupFuncs;
 		return cleanupFuncs;
 	}
+
+	log_record_ptr recordHandler = NULL;
+	log_cleanup_ptr recordHandlerFlush = NULL;
+	log_cleanup_ptr recordHandlerLock = NULL;
+	log_cleanup_ptr recordHandlerUnlock = NULL;
 }
 
 
 void log_backend_registerSink(log_sink_ptr sink) {
+
+	log_backend_lockSinks();
 	log_formatter_getSinks().push_back(sink);
+	log_backend_unlockSinks();
 }
 
 void log_backend_unregisterSink(log_sink_ptr sink) {
 
+	log_backend_lockSinks();
+
 	std::vector<log_sink_ptr>& sinks = log_formatter_getSinks();
 	std::vector<log_sink_ptr>::iterator si;
 	for (si = sinks.begin(); si != sinks.end(); ++si) {
@@ -40,6 +51,8 @@ void log_backend_unregisterSink(log_sink_ptr sink) {
 			break;
 		}
 	}
+
+	log_backend_unlockSinks();
 }
 
 
@@ -59,6 +72,39 @@ void log_backend_unregisterCleanup(log_cleanup_ptr cleanupFunc) {
 	}
 }
 
+void log_backend_setRecordHandler(log_record_ptr handler, log_cleanup_ptr flushFunc,
+		log_cleanup_ptr lockFunc, log_cleanup_ptr unlockFunc)
+{
+	recordHandler = handler;
+	recordHandlerFlush = (handler != NULL) ? flushFunc : NULL;
+	recordHandlerLock = (handler != NULL) ? lockFunc : NULL;
+	recordHandlerUnlock = (handler != NULL) ? unlockFunc : NULL;
+}
+
+void log_backend_sinkRecord(const char* section, int level, int frameNum, const char* record) {
+
+	const std::vector<log_sink_ptr>& sinks = log_formatter_getSinks();
+	std::vector<log_sink_ptr>::const_iterator si;
+	for (si = sinks.begin(); si != sinks.end(); ++si) {
+		(*si)(section, level, frameNum, record);
+	}
+}
+
+void log_backend_lockSinks() {
+
+	// without a handler, records are sunk by the thread creating them
+	if (recordHandlerLock != NULL) {
+		recordHandlerLock();
+	}
+}
+
+void log_backend_unlockSinks() {
+
+	if (recordHandlerUnlock != NULL) {
+		recordHandlerUnlock();
+	}
+}
+
 /**
  * @name logging_backend
  * ILog.h backend implementation.
@@ -69,6 +115,11 @@ void log_backend_unregisterCleanup(log_cleanup_ptr cleanupFunc) {
 void log_backend_record(const char* section, int level, const char* fmt,
 		va_list arguments)
 {
+	if ((recordHandler != NULL) && recordHandler(section, level, fmt, arguments)) {
+		// the handler passes the record on to the sinks itself
+		return;
+	}
+
 	const std::vector<log_sink_ptr>& sinks = log_formatter_getSinks();
 	if (sinks.empty()) {
 		// no sinks are registered
@@ -84,10 +135,7 @@ void log_backend_record(const char* section, int level, const char* fmt,
 		char* record = log_formatter_format(section, level, fmt, arguments);
 
 		// sink the record
-		std::vector<log_sink_ptr>::const_iterator si;
-		for (si = sinks.begin(); si != sinks.end(); ++si) {
-			(*si)(section, level, record);
-		}
+		log_backend_sinkRecord(section, level, log_framePrefixer_getFrameNum(), record);
 
 		delete[] record;
 	}
@@ -96,6 +144,11 @@ void log_backend_record(const char* section, int level, const char* fmt,
 /// Passes on a cleanup request to all sinks
 void log_backend_cleanup() {
 
+	// records held back by the handler have to reach the sinks first
+	if (recordHandlerFlush != NULL) {
+		recordHandlerFlush();
+	}
+
 	const std::vector<log_cleanup_ptr>& cleanupFuncs = log_formatter_getCleanupFuncs();
 	std::vector<log_cleanup_ptr>::const_iterator si;
 	for (si = cleanupFuncs.begin(); si != cleanupFuncs.end(); ++si) {
@@ -8,6 +8,8 @@
  * It may format log records, and routes them to all the registered sinks.
  */
 
+#include <stdarg.h> // for va_list
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -18,7 +20,11 @@ extern "C" {
  */
 ///@{
 
-typedef void (*log_sink_ptr)(const char* section, int level,
+/**
+ * @param frameNum the frame the record was created in, which is not
+ *   necessarily the current one, or -1 (see log_framePrefixer_createPrefix)
+ */
+typedef void (*log_sink_ptr)(const char* section, int level, int frameNum,
 		const char* record);
 
 /// Start routing log records to the supplied sink
@@ -41,6 +47,44 @@ void log_backend_registerCleanup(log_cleanup_ptr cleanupFunc);
  */
 void log_backend_unregisterCleanup(log_cleanup_ptr cleanupFunc);
 
+
+/**
+ * Alternative handler for incoming records, for example to hand them to a
+ * different thread (see AsyncBackend.h).
+ * @return false if the record should be sunk synchronously after all
+ */
+typedef bool (*log_record_ptr)(const char* section, int level,
+		const char* fmt, va_list arguments);
+
+/**
+ * Installs (or with NULL, removes) an alternative record handler.
+ * The flush function is called before the cleanup functions, and has to
+ * pass all records still held by the handler on to log_backend_sinkRecord.
+ * The lock functions have to keep the handler from sinking records (on
+ * another thread) in between them, see log_backend_lockSinks.
+ */
+void log_backend_setRecordHandler(log_record_ptr recordHandler,
+		log_cleanup_ptr flushFunc, log_cleanup_ptr lockFunc,
+		log_cleanup_ptr unlockFunc);
+
+/**
+ * Passes an already formatted record on to all the registered sinks.
+ * Used by alternative record handlers only.
+ */
+void log_backend_sinkRecord(const char* section, int level, int frameNum,
+		const char* record);
+
+/**
+ * Keeps records from being sunk on other threads until
+ * log_backend_unlockSinks is called, so the sinks (and what they write to)
+ * can be changed safely while an alternative record handler is installed.
+ * Used by (un)registering sinks, and by sinks that keep a list of their
+ * own (eg. LogSinkHandler). Must not be called from within a sink, and not
+ * recursively.
+ */
+void log_backend_lockSinks();
+void log_backend_unlockSinks();
+
 ///@}
 
 #ifdef __cplusplus
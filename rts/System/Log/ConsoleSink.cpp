@@ -39,10 +39,10 @@ static inline FILE* log_chooseStream(int level) {
 
 /// Records a log entry
 static void log_sink_record_console(const char* section, int level,
-		const char* record)
+		int frameNum, const char* record)
 {
 	char framePrefix[128] = {'\0'};
-	log_framePrefixer_createPrefix(framePrefix, sizeof(framePrefix));
+	log_framePrefixer_createPrefix(frameNum, framePrefix, sizeof(framePrefix));
 
 	FILE* outStream = log_chooseStream(level);
 	FPRINTF(outStream, "%s%s\n", framePrefix, record);
@@ -83,20 +83,23 @@ namespace {
 	 * and while the container is still valid (not deleted yet).
 	 */
 	struct LogRecord {
-		LogRecord(const std::string& section, int level,
+		LogRecord(const std::string& section, int level, int frameNum,
 				const std::string& record)
 			: section(section)
 			, level(level)
+			, frameNum(frameNum)
 			, record(record)
 		{}
 
 		const std::string& GetSection() const { return section; }
 		int GetLevel() const { return level; }
+		int GetFrameNum() const { return frameNum; }
 		const std::string& GetRecord() const { return record; }
 
 	private:
 		std::string section;
 		int level;
+		int frameNum;
 		std::string record;
 	};
 	typedef std::list<LogRecord> logRecords_t;
@@ -110,10 +113,10 @@ namespace {
 		return (!log_file_getLogFiles().empty());
 	}
 
-	void log_file_writeToFile(FILE* outStream, const char* record, bool flush) {
+	void log_file_writeToFile(FILE* outStream, int frameNum, const char* record, bool flush) {
 
 		char framePrefix[128] = {'\0'};
-		log_framePrefixer_createPrefix(framePrefix, sizeof(framePrefix));
+		log_framePrefixer_createPrefix(frameNum, framePrefix, sizeof(framePrefix));
 
 		FPRINTF(outStream, "%s%s\n", framePrefix, record);
 
@@ -124,7 +127,7 @@ namespace {
 	/**
 	 * Writes to the individual log files, if they do want to log the section.
 	 */
-	void log_file_writeToFiles(const char* section, int level,
+	void log_file_writeToFiles(const char* section, int level, int frameNum,
 			const char* record)
 	{
 		const logFiles_t& logFiles = log_file_getLogFiles();
@@ -133,7 +136,7 @@ namespace {
 			if (lfi->second.IsLogging(section, level)
 					&& (lfi->second.GetOutStream() != NULL))
 			{
-				log_file_writeToFile(lfi->second.GetOutStream(), record, lfi->second.FlushOnWrite());
+				log_file_writeToFile(lfi->second.GetOutStream(), frameNum, record, lfi->second.FlushOnWrite());
 			}
 		}
 	}
@@ -168,15 +171,15 @@ namespace {
 			logRecords_t& logRecords = log_file_getRecordBuffer();
 			const logRecords_t::iterator lri = logRecords.begin();
 			log_file_writeToFiles(lri->GetSection().c_str(), lri->GetLevel(),
-					lri->GetRecord().c_str());
+					lri->GetFrameNum(), lri->GetRecord().c_str());
 			logRecords.erase(lri);
 		}
 	}
 
 	inline void log_file_writeToBuffer(const std::string& section, int level,
-			const std::string& record)
+			int frameNum, const std::string& record)
 	{
-		log_file_getRecordBuffer().push_back(LogRecord(section, level, record));
+		log_file_getRecordBuffer().push_back(LogRecord(section, level, frameNum, record));
 	}
 }
 
@@ -212,7 +215,11 @@ void log_file_addLogFile(const char* filePath, const char* sections, int minLeve
 	setvbuf(tmpStream, NULL, _IOFBF, (BUFSIZ < 8192) ? BUFSIZ : 8192); // limit buffer to 8kB
 
 	const std::string sectionsStr = (sections == NULL) ? "" : sections;
+
+	// records may be written on the log writer thread (see AsyncBackend.h)
+	log_backend_lockSinks();
 	logFiles[filePathStr] = LogFileDetails(tmpStream, sectionsStr, minLevel, flush);
+	log_backend_unlockSinks();
 }
 
 void log_file_removeLogFile(const char* filePath) {
@@ -221,15 +228,20 @@ void log_file_removeLogFile(const char* filePath) {
 
 	logFiles_t& logFiles = log_file_getLogFiles();
 	const std::string filePathStr = filePath;
+
+	log_backend_lockSinks();
 	const logFiles_t::iterator lfi = logFiles.find(filePathStr);
 	if (lfi == logFiles.end()) {
 		// we are not logging to this file
+		log_backend_unlockSinks();
 		return;
 	}
 
 	// turn off logging to this file
 	FILE* tmpStream = lfi->second.GetOutStream();
 	logFiles.erase(lfi);
+	log_backend_unlockSinks();
+
 	fclose(tmpStream);
 	tmpStream = NULL;
 }
@@ -250,17 +262,17 @@ void log_file_removeAllLogFiles() {
 
 /// Records a log entry
 static void log_sink_record_file(const char* section, int level,
-		const char* record)
+		int frameNum, const char* record)
 {
 	if (log_file_isActivelyLogging()) {
 		// write buffer to log file
 		log_file_writeBufferToFiles();
 
 		// write current record to log file
-		log_file_writeToFiles(section, level, record);
+		log_file_writeToFiles(section, level, frameNum, record);
 	} else {
 		// buffer until a log file is ready for output
-		log_file_writeToBuffer(section, level, record);
+		log_file_writeToBuffer(section, level, frameNum, record);
 	}
 }
 
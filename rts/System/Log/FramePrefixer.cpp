@@ -21,16 +21,21 @@ void log_framePrefixer_setFrameNumReference(int* frameNumReference)
 	frameNum = frameNumReference;
 }
 
-size_t log_framePrefixer_createPrefix(char* result, size_t resultSize)
+int log_framePrefixer_getFrameNum()
 {
-	if (frameNum == NULL) {
+	return (frameNum != NULL) ? *frameNum : -1;
+}
+
+size_t log_framePrefixer_createPrefix(int recordFrameNum, char* result, size_t resultSize)
+{
+	if (recordFrameNum < 0) {
 		if (resultSize > 0) {
 			result[0] = '\0';
 			return 1;
 		}
 		return 0;
 	} else {
-		return SNPRINTF(result, resultSize, "[f=%07d] ", *frameNum);
+		return SNPRINTF(result, resultSize, "[f=%07d] ", recordFrameNum);
 	}
 }
 
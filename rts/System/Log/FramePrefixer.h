@@ -16,11 +16,17 @@ extern "C" {
 void log_framePrefixer_setFrameNumReference(int* frameNumReference);
 
 /**
- * Fills a string containing the frame number, if it is available.
+ * @return the current frame number, or -1 if it is not available
+ */
+int log_framePrefixer_getFrameNum();
+
+/**
+ * Fills a string containing the frame number a record was created in
+ * (see log_sink_ptr), if it is available (>= 0).
  * Else fils in the empty string.
  * @return the number of chars written to the result buffer.
  */
-size_t log_framePrefixer_createPrefix(char* result, size_t resultSize);
+size_t log_framePrefixer_createPrefix(int frameNum, char* result, size_t resultSize);
 
 #ifdef __cplusplus
 } // extern "C"
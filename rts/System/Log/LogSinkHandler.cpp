@@ -13,7 +13,7 @@ LogSinkHandler logSinkHandler;
 
 /// Records a log entry
 static void log_sink_record_logSinkHandler(const char* section, int level,
-		const char* record)
+		int frameNum, const char* record)
 {
 	logSinkHandler.RecordLogMessage((section == NULL) ? "" : section, level, record);
 }
@@ -34,9 +34,14 @@ LogSinkHandler::~LogSinkHandler() {
 void LogSinkHandler::AddSink(ILogSink* logSink) {
 
 	assert(logSink != NULL);
+
+	// records may be sunk on the log writer thread (see AsyncBackend.h)
+	log_backend_lockSinks();
 	sinks.push_back(logSink);
+	const bool firstSink = (sinks.size() == 1);
+	log_backend_unlockSinks();
 
-	if (sinks.size() == 1) {
+	if (firstSink) {
 		log_backend_registerSink(&log_sink_record_logSinkHandler);
 	}
 }
@@ -44,6 +49,9 @@ void LogSinkHandler::AddSink(ILogSink* logSink) {
 void LogSinkHandler::RemoveSink(ILogSink* logSink) {
 
 	assert(logSink != NULL);
+
+	// once this returns, logSink does not get any more records
+	log_backend_lockSinks();
 	std::vector<ILogSink*>::iterator lsi;
 	for (lsi = sinks.begin(); lsi != sinks.end(); ++lsi) {
 		if (*lsi == logSink) {
@@ -51,8 +59,10 @@ void LogSinkHandler::RemoveSink(ILogSink* logSink) {
 			break;
 		}
 	}
+	const bool noSinks = sinks.empty();
+	log_backend_unlockSinks();
 
-	if (sinks.empty()) {
+	if (noSinks) {
 		log_backend_unregisterSink(&log_sink_record_logSinkHandler);
 	}
 }
@@ -26,10 +26,10 @@ extern "C" {
 
 /// Records a log entry
 static void log_sink_record_outputDebugString(const char* section, int level,
-		const char* record)
+		int frameNum, const char* record)
 {
 	char framePrefix[128] = {'\0'};
-	log_framePrefixer_createPrefix(framePrefix, sizeof(framePrefix));
+	log_framePrefixer_createPrefix(frameNum, framePrefix, sizeof(framePrefix));
 
 	OutputDebugString(framePrefix);
 	OutputDebugString(record);
@@ -18,6 +18,9 @@
 #include "System/Log/LogSinkHandler.h"
 #include "System/Util.h"
 
+#if !defined(DEDICATED)
+	#include "System/Log/AsyncBackend.h"
+#endif
 #if !defined(DEDICATED) || defined(_MSC_VER)
 	#include "System/SpringApp.h"
 	#include "System/Platform/Threading.h"
@@ -47,6 +50,15 @@ static void ExitMessage(const std::string& msg, const std::string& caption, unsi
 #ifdef _MSC_VER
 	if (forced)
 		TerminateProcess(GetCurrentProcess(), -1);
+#endif
+#if !defined(DEDICATED)
+	// write out everything still queued, before exit destroys the sinks
+	// (if forced, the writer thread might be stuck as well)
+	if (forced) {
+		log_async_flush();
+	} else {
+		log_async_stop();
+	}
 #endif
 	exit(-1);
 }
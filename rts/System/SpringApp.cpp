@@ -30,6 +30,7 @@
 #include "System/Input/Joystick.h"
 #include "System/MsgStrings.h"
 #include "System/NetProtocol.h"
+#include "Lua/LuaChunkCache.h"
 #include "Lua/LuaOpenGL.h"
 #include "Menu/SelectMenu.h"
 
@@ -48,6 +49,7 @@
 #include "System/Sync/FPUCheck.h"
 #include "System/GlobalConfig.h"
 #include "System/Log/ILog.h"
+#include "System/Log/AsyncBackend.h"
 #include "System/myMath.h"
 #include "System/OpenMP_cond.h"
 #include "System/StartScriptGen.h"
@@ -108,6 +110,10 @@ CONFIG(bool, WindowBorderless).defaultValue(false);
 CONFIG(int, PathingThreadCount).defaultValue(0).safemodeValue(1).minimumValue(0);
 CONFIG(int, MultiThreadCount).defaultValue(0).safemodeValue(1).minimumValue(0).maximumValue(GML_MAX_NUM_THREADS);
 CONFIG(std::string, name).defaultValue(UnnamedPlayerName);
+CONFIG(bool, LogAsync).defaultValue(false).safemodeValue(false).description("Write log records on a background thread, so disk I/O can not stall the game.");
+CONFIG(int, LogQueueSize).defaultValue(4096).minimumValue(16).description("Maximum number of log records waiting to be written when LogAsync is enabled, more get dropped.");
+CONFIG(int, LogRateLimit).defaultValue(0).minimumValue(0).description("Maximum number of info and debug log records per second of a single log section, 0 for no limit.");
+CONFIG(bool, LuaChunkCache).defaultValue(true).safemodeValue(false).description("Keep compiled Lua chunks in memory and in the cache dir, so reloading LuaRules and LuaUI (or starting the same game again) does not compile unchanged files again.");
 
 
 ClientSetup* startsetup = NULL;
@@ -188,6 +194,14 @@ bool SpringApp::Initialize()
 
 	ParseCmdLine();
 	CMyMath::Init();
+
+	if (configHandler->GetBool("LogAsync")) {
+		log_async_setRateLimit(configHandler->GetInt("LogRateLimit"));
+		log_async_start(configHandler->GetInt("LogQueueSize"));
+	}
+
+	CLuaChunkCache::SetEnabled(configHandler->GetBool("LuaChunkCache"));
+
 	good_fpu_control_registers("::Run");
 
 	// log OS version
@@ -1076,6 +1090,9 @@ void SpringApp::Shutdown()
 	FileSystemInitializer::Cleanup();
 
 	Watchdog::Uninstall();
+
+	// write out everything still queued
+	log_async_stop();
 }
 
 bool SpringApp::MainEventHandler(const SDL_Event& event)
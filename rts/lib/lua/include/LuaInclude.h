@@ -76,8 +76,8 @@ inline bool luaL_optboolean(lua_State* L, int idx, bool def)
 struct luaContextData;
 extern boost::recursive_mutex* getLuaMutex(bool userMode, bool primary);
 
-inline lua_State *LUA_OPEN(luaContextData* lcd = NULL, bool userMode = true, bool primary = true) {
-	lua_State *L_New = lua_open();
+inline lua_State *LUA_OPEN(luaContextData* lcd = NULL, bool userMode = true, bool primary = true, lua_Alloc allocFunc = NULL, void* allocData = NULL) {
+	lua_State *L_New = (allocFunc != NULL) ? luaL_newstatealloc(allocFunc, allocData) : lua_open();
 	L_New->lcd = lcd;
 	L_New->luamutex = getLuaMutex(userMode, primary);
 	return L_New;
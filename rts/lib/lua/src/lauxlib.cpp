@@ -666,7 +666,13 @@ static int panic (lua_State *L) {
 
 
 LUALIB_API lua_State *luaL_newstate (void) {
-  lua_State *L = lua_newstate(l_alloc, NULL);
+  return luaL_newstatealloc(l_alloc, NULL);
+}
+
+
+// SPRING: luaL_newstate with a custom allocator
+LUALIB_API lua_State *luaL_newstatealloc (lua_Alloc f, void *ud) {
+  lua_State *L = lua_newstate(f, ud);
   if (L) lua_atpanic(L, &panic);
   return L;
 }
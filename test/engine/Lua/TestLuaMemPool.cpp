@@ -0,0 +1,182 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "Lua/LuaMemPool.h"
+
+#define BOOST_TEST_MODULE LuaMemPool
+#include <boost/test/unit_test.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+
+namespace {
+	struct Block {
+		Block(): ptr(NULL), size(0) {}
+		void* ptr;
+		size_t size;
+	};
+
+	/// lua_Alloc of luaL_newstate
+	void* MallocAlloc(void* ud, void* ptr, size_t osize, size_t nsize) {
+		if (nsize == 0) {
+			free(ptr);
+			return NULL;
+		}
+		return realloc(ptr, nsize);
+	}
+
+	/// mostly small blocks, as Lua allocates them (table nodes, strings, closures)
+	size_t RandomSize(unsigned int& seed) {
+		seed = seed * 1103515245 + 12345;
+		const unsigned int r = (seed >> 8);
+
+		if ((r % 16) == 0)
+			return (257 + (r % 4096));
+
+		return (1 + (r % 256));
+	}
+
+	/**
+	 * Allocates, grows, shrinks and frees blocks in a random order, like
+	 * widgets churning small tables do.
+	 * @param check fill and verify the contents of all blocks
+	 * @return seconds taken
+	 */
+	double MixedWorkload(void* (*allocFunc)(void*, void*, size_t, size_t), void* ud, int numOps, bool check) {
+		std::vector<Block> blocks(4096);
+		unsigned int seed = 42;
+
+		const boost::posix_time::ptime startTime = boost::posix_time::microsec_clock::universal_time();
+
+		for (int i = 0; i < numOps; ++i) {
+			seed = seed * 1103515245 + 12345;
+			Block& b = blocks[(seed >> 8) % blocks.size()];
+
+			if (check && b.ptr != NULL) {
+				const unsigned char* bytes = static_cast<const unsigned char*>(b.ptr);
+				for (size_t n = 0; n < b.size; ++n) {
+					BOOST_REQUIRE_EQUAL(bytes[n], (unsigned char) (b.size + n));
+				}
+			}
+
+			if (b.ptr != NULL && (seed & 0x10000)) {
+				allocFunc(ud, b.ptr, b.size, 0);
+				b.ptr = NULL;
+				b.size = 0;
+			} else {
+				const size_t newSize = RandomSize(seed);
+				void* newPtr = allocFunc(ud, b.ptr, b.size, newSize);
+				BOOST_REQUIRE(newPtr != NULL);
+
+				if (check) {
+					// the old contents have to be kept
+					const unsigned char* bytes = static_cast<const unsigned char*>(newPtr);
+					for (size_t n = 0; n < std::min(b.size, newSize); ++n) {
+						BOOST_REQUIRE_EQUAL(bytes[n], (unsigned char) (b.size + n));
+					}
+					for (size_t n = 0; n < newSize; ++n) {
+						static_cast<unsigned char*>(newPtr)[n] = (unsigned char) (newSize + n);
+					}
+				}
+
+				b.ptr = newPtr;
+				b.size = newSize;
+			}
+		}
+
+		for (size_t i = 0; i < blocks.size(); ++i) {
+			allocFunc(ud, blocks[i].ptr, blocks[i].size, 0);
+		}
+
+		const boost::posix_time::time_duration duration = boost::posix_time::microsec_clock::universal_time() - startTime;
+		return (std::max(duration.total_microseconds(), boost::int64_t(1)) / 1000000.0);
+	}
+}
+
+
+BOOST_AUTO_TEST_CASE(Contents)
+{
+	LuaMemPool pool;
+
+	MixedWorkload(&LuaMemPool::Alloc, &pool, 100000, true);
+
+	BOOST_CHECK_EQUAL(pool.GetStats().allocBytes, 0u);
+	BOOST_CHECK_EQUAL(pool.GetStats().allocObjects, 0u);
+	BOOST_CHECK(pool.GetStats().poolBytes > 0u);
+}
+
+BOOST_AUTO_TEST_CASE(Accounting)
+{
+	LuaMemPool pool;
+	BOOST_CHECK_EQUAL(LuaMemPool::GetGlobalStats().numPools, 1u);
+
+	void* a = pool.Realloc(NULL, 0, 24);
+	void* b = pool.Realloc(NULL, 0, 1000);
+	BOOST_CHECK_EQUAL(pool.GetStats().allocBytes, 1024u);
+	BOOST_CHECK_EQUAL(pool.GetStats().allocObjects, 2u);
+
+	a = pool.Realloc(a, 24, 300);
+	b = pool.Realloc(b, 1000, 10);
+	BOOST_CHECK_EQUAL(pool.GetStats().allocBytes, 310u);
+	BOOST_CHECK_EQUAL(pool.GetStats().allocObjects, 2u);
+
+	// a freed block is reused for the next one of its size-class
+	pool.Realloc(b, 10, 0);
+	BOOST_CHECK_EQUAL(pool.Realloc(NULL, 0, 16), b);
+
+	pool.Realloc(b, 16, 0);
+	pool.Realloc(a, 300, 0);
+	BOOST_CHECK_EQUAL(pool.GetStats().allocBytes, 0u);
+	BOOST_CHECK_EQUAL(pool.GetStats().allocObjects, 0u);
+}
+
+BOOST_AUTO_TEST_CASE(Limits)
+{
+	LuaMemPool pool;
+	pool.SetLimits(1000, 2000);
+
+	void* a = pool.Realloc(NULL, 0, 900);
+	BOOST_REQUIRE(a != NULL);
+	BOOST_CHECK(!pool.NeedsCollect());
+
+	void* b = pool.Realloc(NULL, 0, 200);
+	BOOST_REQUIRE(b != NULL);
+	BOOST_CHECK(pool.NeedsCollect());
+
+	// growing beyond the hard limit fails, shrinking never does
+	BOOST_CHECK(pool.Realloc(NULL, 0, 1000) == NULL);
+	BOOST_CHECK(pool.Realloc(b, 200, 1200) == NULL);
+	BOOST_CHECK_EQUAL(pool.GetNumLimitErrors(), 2u);
+	b = pool.Realloc(b, 200, 100);
+	BOOST_CHECK(b != NULL);
+
+	// the live data exceeds the soft limit, do not collect again right away
+	b = pool.Realloc(b, 100, 200);
+	pool.Collected();
+	BOOST_CHECK(!pool.NeedsCollect());
+
+	pool.Realloc(a, 900, 0);
+	pool.Realloc(b, 200, 0);
+	pool.Collected();
+	BOOST_CHECK(!pool.NeedsCollect());
+}
+
+BOOST_AUTO_TEST_CASE(Throughput)
+{
+	const int numOps = 2000000;
+
+	const double mallocSeconds = MixedWorkload(&MallocAlloc, NULL, numOps, false);
+
+	LuaMemPool pool;
+	const double poolSeconds = MixedWorkload(&LuaMemPool::Alloc, &pool, numOps, false);
+
+	BOOST_TEST_MESSAGE("operations per second, malloc:     " << (numOps / mallocSeconds));
+	BOOST_TEST_MESSAGE("operations per second, LuaMemPool: " << (numOps / poolSeconds));
+
+	// timing depends on the machine, so only warn
+	BOOST_WARN(poolSeconds < mallocSeconds);
+}
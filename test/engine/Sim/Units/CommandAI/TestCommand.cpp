@@ -0,0 +1,196 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "Sim/Units/CommandAI/Command.h"
+#include "System/BaseNetProtocol.h"
+#include "System/Net/RawPacket.h"
+#include "System/Net/UnpackPacket.h"
+
+#define BOOST_TEST_MODULE Command
+#include <boost/test/unit_test.hpp>
+#include <boost/cstdint.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+
+#include <algorithm>
+#include <deque>
+#include <vector>
+
+
+namespace {
+	/// how Command stored its parameters before CommandParams
+	struct VectorCommand {
+		VectorCommand(int id, unsigned char options, const float3& pos)
+			: aiCommandId(-1), options(options), tag(0), timeOut(INT_MAX), id(id)
+		{
+			params.push_back(pos.x);
+			params.push_back(pos.y);
+			params.push_back(pos.z);
+		}
+
+		int aiCommandId;
+		unsigned char options;
+		std::vector<float> params;
+		unsigned int tag;
+		int timeOut;
+		int id;
+	};
+
+	/**
+	 * float3::operator== uses math::fabs, which needs streflop when it is
+	 * enabled; this test does not link it, so compare the components.
+	 */
+	bool SamePos(const float3& a, const float3& b) {
+		return (a.x == b.x && a.y == b.y && a.z == b.z);
+	}
+
+	double Seconds(const boost::posix_time::ptime& startTime) {
+		const boost::posix_time::time_duration duration = boost::posix_time::microsec_clock::universal_time() - startTime;
+		return (std::max(duration.total_microseconds(), boost::int64_t(1)) / 1000000.0);
+	}
+
+	/**
+	 * Shift-queues numWaypoints move orders for each of numUnits units, copies
+	 * all queues (as CSelectedUnitsAI does when giving the same order to a
+	 * group) and iterates over them, the way CCommandAI does.
+	 * @return seconds taken
+	 */
+	template<typename T>
+	double QueueWorkload(int numUnits, int numWaypoints, float* checkSum) {
+		const boost::posix_time::ptime startTime = boost::posix_time::microsec_clock::universal_time();
+
+		std::vector< std::deque<T> > queues(numUnits);
+
+		for (int u = 0; u < numUnits; ++u) {
+			for (int w = 0; w < numWaypoints; ++w) {
+				queues[u].push_back(T(CMD_MOVE, SHIFT_KEY, float3(u, 0.0f, w)));
+			}
+		}
+
+		std::vector< std::deque<T> > copies(queues);
+
+		float sum = 0.0f;
+
+		for (int u = 0; u < numUnits; ++u) {
+			for (typename std::deque<T>::const_iterator it = copies[u].begin(); it != copies[u].end(); ++it) {
+				sum += (it->params[0] + it->params[2]);
+			}
+		}
+
+		*checkSum = sum;
+		return Seconds(startTime);
+	}
+}
+
+
+BOOST_AUTO_TEST_CASE(Params)
+{
+	CommandParams params;
+	BOOST_CHECK(params.empty());
+	BOOST_CHECK_EQUAL(params.capacity(), CommandParams::INLINE_CAPACITY);
+
+	for (int i = 0; i < 20; ++i) {
+		params.push_back(i);
+	}
+	BOOST_CHECK_EQUAL(params.size(), 20u);
+
+	for (int i = 0; i < 20; ++i) {
+		BOOST_CHECK_EQUAL(params[i], float(i));
+	}
+
+	// copies are independent
+	CommandParams copy(params);
+	copy[0] = 42.0f;
+	BOOST_CHECK_EQUAL(params[0], 0.0f);
+	BOOST_CHECK_EQUAL(copy[0], 42.0f);
+	BOOST_CHECK_EQUAL(copy.size(), 20u);
+
+	CommandParams small;
+	small.push_back(1.0f);
+	copy = small;
+	BOOST_CHECK_EQUAL(copy.size(), 1u);
+	BOOST_CHECK_EQUAL(copy[0], 1.0f);
+
+	// like safe_vector
+	BOOST_CHECK_EQUAL(copy[1], 0.0f);
+	BOOST_CHECK_EQUAL(copy.at(100), 0.0f);
+
+	const size_t capacity = params.capacity();
+	params.clear();
+	BOOST_CHECK(params.empty());
+	BOOST_CHECK_EQUAL(params.capacity(), capacity);
+}
+
+BOOST_AUTO_TEST_CASE(Commands)
+{
+	Command c(CMD_INSERT, SHIFT_KEY, 1.0f, float3(2.0f, 3.0f, 4.0f));
+	c.PushParam(5.0f);
+	c.PushParam(6.0f);
+
+	Command copy = c;
+	BOOST_CHECK_EQUAL(copy.GetID(), CMD_INSERT);
+	BOOST_CHECK_EQUAL(copy.options, SHIFT_KEY);
+	BOOST_CHECK_EQUAL(copy.GetParamsCount(), 6u);
+	BOOST_CHECK(SamePos(copy.GetPos(1), float3(2.0f, 3.0f, 4.0f)));
+	BOOST_CHECK_EQUAL(copy.GetParam(5), 6.0f);
+
+	std::deque<Command> queue;
+	for (int i = 0; i < 100; ++i) {
+		queue.push_back(Command(CMD_MOVE, float3(i, 0.0f, 0.0f)));
+		queue.push_front(c);
+	}
+	queue.erase(queue.begin(), queue.begin() + 100);
+
+	for (int i = 0; i < 100; ++i) {
+		BOOST_CHECK_EQUAL(queue[i].params[0], float(i));
+	}
+}
+
+BOOST_AUTO_TEST_CASE(NetCommand)
+{
+	Command c(CMD_MOVE, SHIFT_KEY, float3(1.0f, 2.0f, 3.0f));
+
+	const boost::shared_ptr<const netcode::RawPacket> packet =
+		CBaseNetProtocol::Get().SendCommand(7, c.GetID(), c.options, c.params.begin(), c.params.size());
+
+	// decoded like in CGame::ClientReadNet
+	netcode::UnpackPacket pckt(packet, 1);
+
+	unsigned short packetSize; pckt >> packetSize;
+	unsigned char playerNum; pckt >> playerNum;
+	const unsigned int numParams = (packetSize - 9) / sizeof(float);
+	int cmdID; pckt >> cmdID;
+	unsigned char cmdOpt; pckt >> cmdOpt;
+
+	BOOST_CHECK_EQUAL(packetSize, packet->length);
+	BOOST_CHECK_EQUAL(playerNum, 7);
+	BOOST_CHECK_EQUAL(cmdID, CMD_MOVE);
+	BOOST_CHECK_EQUAL(cmdOpt, SHIFT_KEY);
+	BOOST_REQUIRE_EQUAL(numParams, 3u);
+
+	Command r(cmdID, cmdOpt);
+	for (unsigned int a = 0; a < numParams; ++a) {
+		float param; pckt >> param;
+		r.PushParam(param);
+	}
+	BOOST_CHECK(SamePos(r.GetPos(0), c.GetPos(0)));
+}
+
+BOOST_AUTO_TEST_CASE(Throughput)
+{
+	// a big selection, shift-queueing a long path
+	const int numUnits = 500;
+	const int numWaypoints = 50;
+
+	float vectorSum = 0.0f;
+	float paramsSum = 0.0f;
+
+	const double vectorSeconds = QueueWorkload<VectorCommand>(numUnits, numWaypoints, &vectorSum);
+	const double paramsSeconds = QueueWorkload<Command>(numUnits, numWaypoints, &paramsSum);
+
+	BOOST_CHECK_EQUAL(vectorSum, paramsSum);
+
+	BOOST_TEST_MESSAGE("queued commands per second, std::vector params: " << (numUnits * numWaypoints / vectorSeconds));
+	BOOST_TEST_MESSAGE("queued commands per second, CommandParams:      " << (numUnits * numWaypoints / paramsSeconds));
+
+	// timing depends on the machine, so only warn
+	BOOST_WARN(paramsSeconds < vectorSeconds);
+}
@@ -0,0 +1,190 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "System/Log/ILog.h"
+#include "System/Log/AsyncBackend.h"
+#include "System/Log/Backend.h"
+#include "System/Log/DefaultFilter.h"
+#include "System/Log/FileSink.h"
+
+#define BOOST_TEST_MODULE AsyncLog
+#include <boost/test/unit_test.hpp>
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+
+#define LOG_SECTION_ASYNC_TEST "async-test"
+LOG_REGISTER_SECTION_GLOBAL(LOG_SECTION_ASYNC_TEST)
+
+static const int NUM_THREADS = 4;
+static const int NUM_RECORDS = 10000;
+
+namespace {
+	/// counts the test records, and checks their per-thread order
+	struct CountingSink {
+		static int numRecords;
+		static int numOutOfOrder;
+		static int slowdownUs;
+		static std::vector<int> lastRecord;
+
+		static void Reset() {
+			numRecords = 0;
+			numOutOfOrder = 0;
+			slowdownUs = 0;
+			lastRecord.assign(NUM_THREADS, -1);
+		}
+
+		static void Record(const char* section, int level, int frameNum, const char* record) {
+			if (strcmp(section, LOG_SECTION_ASYNC_TEST) != 0) {
+				return;
+			}
+
+			int thread = -1;
+			int recordNum = -1;
+			const char* text = strstr(record, "thread ");
+			if ((text != NULL) && (sscanf(text, "thread %d record %d", &thread, &recordNum) == 2)
+					&& (thread >= 0) && (thread < NUM_THREADS))
+			{
+				if (recordNum <= lastRecord[thread]) {
+					numOutOfOrder++;
+				}
+				lastRecord[thread] = recordNum;
+			}
+			numRecords++;
+
+			if (slowdownUs > 0) {
+				boost::this_thread::sleep(boost::posix_time::microseconds(slowdownUs));
+			}
+		}
+	};
+	int CountingSink::numRecords = 0;
+	int CountingSink::numOutOfOrder = 0;
+	int CountingSink::slowdownUs = 0;
+	std::vector<int> CountingSink::lastRecord;
+
+	struct AsyncLogFixture {
+		AsyncLogFixture() {
+			log_filter_section_setMinLevel(LOG_SECTION_ASYNC_TEST, LOG_LEVEL_INFO);
+			log_backend_registerSink(&CountingSink::Record);
+			CountingSink::Reset();
+		}
+		~AsyncLogFixture() {
+			log_async_stop();
+			log_async_setRateLimit(0);
+			log_backend_unregisterSink(&CountingSink::Record);
+		}
+	};
+
+	void LogRecords(int thread, int numRecords) {
+		for (int r = 0; r < numRecords; ++r) {
+			LOG_SL(LOG_SECTION_ASYNC_TEST, L_INFO, "thread %i record %i", thread, r);
+		}
+	}
+
+	/// @return records per second
+	double LogFromThreads(int numThreads, int numRecordsPerThread) {
+
+		const boost::posix_time::ptime startTime = boost::posix_time::microsec_clock::universal_time();
+
+		boost::thread_group threads;
+		for (int t = 0; t < numThreads; ++t) {
+			threads.create_thread(boost::bind(&LogRecords, t, numRecordsPerThread));
+		}
+		threads.join_all();
+
+		const boost::posix_time::time_duration duration = boost::posix_time::microsec_clock::universal_time() - startTime;
+		const double seconds = std::max(duration.total_microseconds(), boost::int64_t(1)) / 1000000.0;
+
+		return ((numThreads * numRecordsPerThread) / seconds);
+	}
+}
+
+
+BOOST_FIXTURE_TEST_SUITE(everything, AsyncLogFixture)
+
+BOOST_AUTO_TEST_CASE(Delivery)
+{
+	// large enough to never drop, the writer may be slow to start
+	log_async_start(NUM_THREADS * NUM_RECORDS);
+	BOOST_CHECK(log_async_isRunning());
+
+	LogFromThreads(NUM_THREADS, NUM_RECORDS);
+	log_async_stop();
+
+	BOOST_CHECK(!log_async_isRunning());
+	BOOST_CHECK_EQUAL(log_async_getNumDropped(), 0u);
+	BOOST_CHECK_EQUAL(CountingSink::numRecords, NUM_THREADS * NUM_RECORDS);
+	BOOST_CHECK_EQUAL(CountingSink::numOutOfOrder, 0);
+}
+
+BOOST_AUTO_TEST_CASE(BoundedDrop)
+{
+	// the sink can not keep up, so the producers have to drop records
+	// instead of blocking
+	CountingSink::slowdownUs = 100;
+	log_async_start(16);
+
+	const unsigned int numDroppedBefore = log_async_getNumDropped();
+	LogFromThreads(NUM_THREADS, NUM_RECORDS);
+	log_async_stop();
+
+	const unsigned int numDropped = log_async_getNumDropped() - numDroppedBefore;
+	BOOST_CHECK(numDropped > 0u);
+	BOOST_CHECK_EQUAL(CountingSink::numRecords + numDropped, (unsigned int) (NUM_THREADS * NUM_RECORDS));
+	BOOST_CHECK_EQUAL(CountingSink::numOutOfOrder, 0);
+}
+
+BOOST_AUTO_TEST_CASE(RateLimit)
+{
+	const int rateLimit = 100;
+	log_async_setRateLimit(rateLimit);
+	log_async_start(4096);
+
+	const unsigned int numSuppressedBefore = log_async_getNumSuppressed();
+	LogRecords(0, 10 * rateLimit);
+	LOG_SL(LOG_SECTION_ASYNC_TEST, L_WARNING, "warnings are never rate limited");
+	log_async_stop();
+
+	const unsigned int numSuppressed = log_async_getNumSuppressed() - numSuppressedBefore;
+	// the records may be spread over two seconds
+	BOOST_CHECK(CountingSink::numRecords <= (2 * rateLimit + 1));
+	BOOST_CHECK_EQUAL(CountingSink::numRecords + numSuppressed, (unsigned int) (10 * rateLimit + 1));
+}
+
+BOOST_AUTO_TEST_CASE(Throughput)
+{
+	// compare the time the logging thread spends, with synchronous and
+	// asynchronous logging, writing to a log file which is flushed after
+	// every record (the worst case, see the LogFlush config variable);
+	// only one thread, as the synchronous sinks are not thread-safe
+	const char* tmpName = tmpnam(NULL);
+	BOOST_REQUIRE_MESSAGE((tmpName != NULL), "Failed to fetch a temporary log file name");
+	const std::string logFile = tmpName;
+	log_file_addLogFile(logFile.c_str(), NULL, LOG_LEVEL_ALL, true);
+
+	const int numRecords = NUM_RECORDS;
+
+	const double syncRate = LogFromThreads(1, numRecords);
+	BOOST_CHECK_EQUAL(CountingSink::numRecords, numRecords);
+
+	CountingSink::Reset();
+	log_async_start(numRecords);
+	const double asyncRate = LogFromThreads(1, numRecords);
+	log_async_stop();
+
+	log_file_removeLogFile(logFile.c_str());
+	remove(logFile.c_str());
+
+	BOOST_TEST_MESSAGE("records per second, synchronous:  " << syncRate);
+	BOOST_TEST_MESSAGE("records per second, asynchronous: " << asyncRate);
+
+	BOOST_CHECK_EQUAL(CountingSink::numRecords, numRecords);
+	BOOST_CHECK_EQUAL(CountingSink::numOutOfOrder, 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
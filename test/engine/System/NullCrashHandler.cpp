@@ -0,0 +1,7 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "System/Platform/CrashHandler.h"
+
+namespace CrashHandler {
+	void OutputStacktrace() {}
+};